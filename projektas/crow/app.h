@@ -26,6 +26,7 @@
 #include <type_traits>
 #include <thread>
 #include <condition_variable>
+#include <limits>
 
 #include "crow/version.h"
 #include "crow/settings.h"
@@ -394,6 +395,23 @@ namespace crow
             return res_stream_threshold_;
         }
 
+        /// \brief Set the largest request body (in bytes) Crow will buffer (Default is unlimited)
+        ///
+        /// The whole body is held in memory before a handler runs, so this bounds memory per connection.
+        /// A request declaring a larger Content-Length, or sending more data than this, is rejected while
+        /// parsing and its connection is closed.
+        self_t& max_body_size(size_t size)
+        {
+            max_body_size_ = size;
+            return *this;
+        }
+
+        /// \brief Get the largest request body (in bytes) Crow will buffer
+        size_t& max_body_size()
+        {
+            return max_body_size_;
+        }
+
         
         self_t& register_blueprint(Blueprint& blueprint)
         {
@@ -736,6 +754,7 @@ namespace crow
         std::string server_name_ = std::string("Crow/") + VERSION;
         std::string bindaddr_ = "0.0.0.0";
         size_t res_stream_threshold_ = 1048576;
+        size_t max_body_size_ = std::numeric_limits<size_t>::max();
         Router router_;
         bool static_routes_added_{false};
 
@@ -1,6 +1,8 @@
 #ifdef CROW_ENABLE_COMPRESSION
 #pragma once
 
+#include <cctype>
+#include <cstdlib>
 #include <string>
 #include <zlib.h>
 
@@ -19,40 +21,134 @@ namespace crow // NOTE: Already documented in "crow/app.h"
             GZIP = 15 | 16,
         };
 
-        inline std::string compress_string(std::string const& str, algorithm algo)
+        /// A deflate/gzip compressor that keeps its z_stream between responses.
+
+        ///
+        /// deflateInit2 allocates ~256 KB of state; after each finished body the stream is only
+        /// deflateReset, so a compressor per thread serves every response on that thread.
+        class deflater
         {
-            std::string compressed_str;
-            z_stream stream{};
-            // Initialize with the default values
-            if (::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, algo, 8, Z_DEFAULT_STRATEGY) == Z_OK)
+        public:
+            deflater(algorithm algo, int level):
+              level_(level)
+            {
+                ok_ = ::deflateInit2(&stream_, level, Z_DEFLATED, algo, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+            }
+
+            deflater(const deflater&) = delete;
+            deflater& operator=(const deflater&) = delete;
+
+            ~deflater()
             {
-                char buffer[8192];
+                if (ok_)
+                    ::deflateEnd(&stream_);
+            }
+
+            /// Change the compression level. Only takes effect between bodies.
+            void set_level(int level)
+            {
+                if (ok_ && level != level_ && ::deflateParams(&stream_, level, Z_DEFAULT_STRATEGY) == Z_OK)
+                    level_ = level;
+            }
+
+            /// Compress the next part of a body, appending the output to `out`.
+            /// After the `last` part (or on failure) the stream is reset for the next body.
+            bool write(const char* data, std::size_t size, std::string& out, bool last)
+            {
+                if (!ok_)
+                    return false;
 
-                stream.avail_in = str.size();
                 // zlib does not take a const pointer. The data is not altered.
-                stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(str.c_str()));
+                stream_.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data));
+                stream_.avail_in = static_cast<uInt>(size);
 
                 int code = Z_OK;
                 do
                 {
-                    stream.avail_out = sizeof(buffer);
-                    stream.next_out = reinterpret_cast<Bytef*>(&buffer[0]);
-
-                    code = ::deflate(&stream, Z_FINISH);
-                    // Successful and non-fatal error code returned by deflate when used with Z_FINISH flush
-                    if (code == Z_OK || code == Z_STREAM_END)
-                    {
-                        std::copy(&buffer[0], &buffer[sizeof(buffer) - stream.avail_out], std::back_inserter(compressed_str));
-                    }
+                    std::size_t used = out.size();
+                    std::size_t room = stream_.avail_in / 2 + 4096;
+                    out.resize(used + room);
+                    stream_.next_out = reinterpret_cast<Bytef*>(&out[used]);
+                    stream_.avail_out = static_cast<uInt>(room);
+
+                    code = ::deflate(&stream_, last ? Z_FINISH : Z_NO_FLUSH);
+                    out.resize(used + room - stream_.avail_out);
+                } while (code == Z_OK && (last || stream_.avail_in > 0 || stream_.avail_out == 0));
+
+                // Z_BUF_ERROR only means there was nothing more to do before Z_FINISH
+                bool done = last ? code == Z_STREAM_END : (code == Z_OK || code == Z_BUF_ERROR);
+                if (last || !done)
+                    ::deflateReset(&stream_);
+                return done;
+            }
 
-                } while (code == Z_OK);
+        private:
+            z_stream stream_{};
+            int level_;
+            bool ok_ = false;
+        };
 
-                if (code != Z_STREAM_END)
-                    compressed_str.clear();
+        /// The calling thread's compressor for `algo`, set to `level`.
+        inline deflater& thread_deflater(algorithm algo, int level = Z_DEFAULT_COMPRESSION)
+        {
+            thread_local deflater gzip(GZIP, level);
+            thread_local deflater deflate(DEFLATE, level);
+            deflater& compressor = algo == GZIP ? gzip : deflate;
+            compressor.set_level(level);
+            return compressor;
+        }
 
-                ::deflateEnd(&stream);
+        /// Pick gzip (preferred) or deflate from an Accept-Encoding header. Codings with q=0 are refused.
+        inline bool negotiate(const std::string& accept_encoding, algorithm& algo)
+        {
+            bool gzip = false, deflate = false, gzip_refused = false;
+            std::size_t pos = 0;
+            while (pos < accept_encoding.size())
+            {
+                std::size_t end = accept_encoding.find(',', pos);
+                if (end == std::string::npos)
+                    end = accept_encoding.size();
+
+                std::string coding = accept_encoding.substr(pos, end - pos);
+                pos = end + 1;
+
+                std::size_t params = coding.find(';');
+                std::string name = coding.substr(0, params);
+                name.erase(0, name.find_first_not_of(" \t"));
+                name.erase(name.find_last_not_of(" \t") + 1);
+                for (auto& c : name)
+                    c = std::tolower(static_cast<unsigned char>(c));
+
+                bool refused = false;
+                if (params != std::string::npos)
+                {
+                    std::size_t q = coding.find("q=", params);
+                    refused = q != std::string::npos && std::atof(coding.c_str() + q + 2) <= 0.0;
+                }
+                if (refused)
+                {
+                    gzip_refused = gzip_refused || name == "gzip" || name == "x-gzip";
+                    continue;
+                }
+                if (name == "gzip" || name == "x-gzip" || name == "*")
+                    gzip = true;
+                else if (name == "deflate")
+                    deflate = true;
             }
 
+            gzip = gzip && !gzip_refused;
+            if (gzip)
+                algo = GZIP;
+            else if (deflate)
+                algo = DEFLATE;
+            return gzip || deflate;
+        }
+
+        inline std::string compress_string(std::string const& str, algorithm algo)
+        {
+            std::string compressed_str;
+            if (!thread_deflater(algo).write(str.data(), str.size(), compressed_str, true))
+                compressed_str.clear();
             return compressed_str;
         }
 
@@ -67,6 +67,7 @@ namespace crow
           get_cached_date_str(get_cached_date_str_f),
           task_timer_(task_timer),
           res_stream_threshold_(handler->stream_threshold()),
+          max_body_size_(handler->max_body_size()),
           queue_length_(queue_length)
         {
 #ifdef CROW_ENABLE_DEBUG
@@ -119,6 +120,12 @@ namespace crow
             }
         }
 
+        /// Largest request body the parser will buffer (see App::max_body_size).
+        size_t max_body_size() const
+        {
+            return max_body_size_;
+        }
+
         void handle_header()
         {
             // HTTP 1.1 Expect: 100-continue
@@ -235,8 +242,9 @@ namespace crow
             if (handler_->compression_used())
             {
                 std::string accept_encoding = req_.get_header_value("Accept-Encoding");
-                if (!accept_encoding.empty() && res.compressed)
+                if (!accept_encoding.empty() && res.compressed && !res.stream)
                 {
+                    res.flatten_body();
                     switch (handler_->compression_algorithm())
                     {
                         case compression::DEFLATE:
@@ -272,9 +280,23 @@ namespace crow
                 res.set_header("location", location);
             }
 
+            if (res.stream)
+            {
+                // Pipelined requests must not interleave with the chunks, so the connection ends with the stream
+                close_connection_ = true;
+                add_keep_alive_ = false;
+            }
+
+            sent_handler_ = std::move(res.on_sent);
+            res.on_sent = nullptr;
+
             prepare_buffers();
 
-            if (res.is_static_type())
+            if (res.stream)
+            {
+                do_write_stream();
+            }
+            else if (res.is_static_type())
             {
                 do_write_static();
             }
@@ -359,7 +381,7 @@ namespace crow
             auto& status = statusCodes.find(res.code)->second;
             buffers_.emplace_back(status.data(), status.size());
 
-            if (res.code >= 400 && res.body.empty())
+            if (res.code >= 400 && res.body.empty() && res.segments.empty())
                 res.body = statusCodes[res.code].substr(9);
 
             for (auto& kv : res.headers)
@@ -370,9 +392,15 @@ namespace crow
                 buffers_.emplace_back(crlf.data(), crlf.size());
             }
 
-            if (!res.manual_length_header && !res.headers.count("content-length"))
+            if (res.stream)
+            {
+                static std::string chunked_tag = "Transfer-Encoding: chunked\r\nConnection: close";
+                buffers_.emplace_back(chunked_tag.data(), chunked_tag.size());
+                buffers_.emplace_back(crlf.data(), crlf.size());
+            }
+            else if (!res.manual_length_header && !res.headers.count("content-length"))
             {
-                content_length_ = std::to_string(res.body.size());
+                content_length_ = std::to_string(res.body_size());
                 static std::string content_length_tag = "Content-Length: ";
                 buffers_.emplace_back(content_length_tag.data(), content_length_tag.size());
                 buffers_.emplace_back(content_length_.data(), content_length_.size());
@@ -431,14 +459,20 @@ namespace crow
             res.clear();
             buffers_.clear();
             parser_.clear();
+            notify_sent();
         }
 
         void do_write_general()
         {
-            if (res.body.length() < res_stream_threshold_)
+            // Segmented bodies reference memory owned elsewhere, so they always go out in one async write
+            if (!res.segments.empty() || res.body.length() < res_stream_threshold_)
             {
                 res_body_copy_.swap(res.body);
-                buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                if (!res_body_copy_.empty())
+                    buffers_.emplace_back(res_body_copy_.data(), res_body_copy_.size());
+                res_segments_copy_.swap(res.segments);
+                for (const auto& segment : res_segments_copy_)
+                    buffers_.emplace_back(segment.begin(), segment.length());
 
                 do_write();
 
@@ -477,6 +511,111 @@ namespace crow
                 res.clear();
                 buffers_.clear();
                 parser_.clear();
+                notify_sent();
+            }
+        }
+
+        void do_write_stream()
+        {
+            stream_ = std::move(res.stream);
+            cancel_deadline_timer();
+
+            // The header block references res.headers; copy it so the response can be cleared while chunks are sent
+            stream_head_.clear();
+            for (const auto& buffer : buffers_)
+                stream_head_.append(static_cast<const char*>(buffer.data()), buffer.size());
+            buffers_.clear();
+            buffers_.emplace_back(stream_head_.data(), stream_head_.size());
+            res.clear();
+            write_stream_buffers(false);
+        }
+
+        void write_stream_buffers(bool last)
+        {
+            auto self = this->shared_from_this();
+            asio::async_write(
+              adaptor_.socket(), buffers_,
+              [self, last](const error_code& ec, std::size_t /*bytes_transferred*/) {
+                  if (ec)
+                  {
+                      CROW_LOG_DEBUG << self << " from write (chunked)";
+                      self->finish_stream(false);
+                  }
+                  else if (last)
+                      self->finish_stream(true);
+                  else
+                      self->write_next_chunk();
+              });
+        }
+
+        void write_next_chunk()
+        {
+            auto self = this->shared_from_this();
+            auto state = stream_->poll(stream_chunk_, [self] {
+                self->adaptor_.get_io_service().post([self] {
+                    self->write_next_chunk();
+                });
+            });
+
+            buffers_.clear();
+            switch (state)
+            {
+                case response_stream::state::pending:
+                    return;
+                case response_stream::state::failed:
+                    finish_stream(false);
+                    return;
+                case response_stream::state::finished:
+                {
+                    static std::string last_chunk = "0\r\n\r\n";
+                    buffers_.emplace_back(last_chunk.data(), last_chunk.size());
+                    write_stream_buffers(true);
+                    return;
+                }
+                case response_stream::state::chunk:
+                {
+                    static const char hex[] = "0123456789abcdef";
+                    char size_line[20];
+                    char* p = size_line + sizeof(size_line);
+                    *--p = '\n';
+                    *--p = '\r';
+                    std::size_t size = stream_chunk_.size();
+                    do
+                    {
+                        *--p = hex[size & 0xF];
+                        size >>= 4;
+                    } while (size);
+                    stream_chunk_size_.assign(p, size_line + sizeof(size_line));
+                    buffers_.emplace_back(stream_chunk_size_.data(), stream_chunk_size_.size());
+                    buffers_.emplace_back(stream_chunk_.data(), stream_chunk_.size());
+                    buffers_.emplace_back(crlf.data(), crlf.size());
+                    write_stream_buffers(false);
+                    return;
+                }
+            }
+        }
+
+        void finish_stream(bool ok)
+        {
+            if (!ok)
+                stream_->cancel();
+            stream_.reset();
+            stream_chunk_.clear();
+            stream_head_.clear();
+            buffers_.clear();
+            parser_.clear();
+            adaptor_.shutdown_readwrite();
+            adaptor_.close();
+            notify_sent();
+        }
+
+        void notify_sent()
+        {
+            if (sent_handler_)
+            {
+                auto handler = std::move(sent_handler_);
+                sent_handler_ = nullptr;
+                handler();
             }
         }
 
@@ -526,11 +665,17 @@ namespace crow
         void do_write()
         {
             auto self = this->shared_from_this();
+            // Taken now: a pipelined request may complete before this write does
+            std::function<void()> sent = std::move(sent_handler_);
+            sent_handler_ = nullptr;
             asio::async_write(
               adaptor_.socket(), buffers_,
-              [self](const error_code& ec, std::size_t /*bytes_transferred*/) {
+              [self, sent](const error_code& ec, std::size_t /*bytes_transferred*/) {
                   self->res.clear();
-                  self->res_body_copy_.clear();                  
+                  self->res_body_copy_.clear();
+                  self->res_segments_copy_.clear();
+                  if (sent)
+                      sent();
                   if (!self->continue_requested)
                   {
                       self->parser_.clear();
@@ -614,6 +759,12 @@ namespace crow
         std::string content_length_;
         std::string date_str_;
         std::string res_body_copy_;
+        std::vector<response::body_segment> res_segments_copy_;
+        std::shared_ptr<response_stream> stream_;
+        std::function<void()> sent_handler_;
+        std::string stream_head_;
+        std::string stream_chunk_;
+        std::string stream_chunk_size_;
 
         detail::task_timer::identifier_type task_id_{};
 
@@ -629,6 +780,7 @@ namespace crow
         detail::task_timer& task_timer_;
 
         size_t res_stream_threshold_;
+        size_t max_body_size_;
 
         std::atomic<unsigned int>& queue_length_;
     };
@@ -1,6 +1,13 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 #include <ios>
 #include <fstream>
 #include <sstream>
@@ -29,6 +36,136 @@ namespace crow
 
     class Router;
 
+    /// Body of a chunked (`Transfer-Encoding: chunked`) response, produced on another thread.
+
+    ///
+    /// The producer calls write() for every chunk and close() at the end. write() blocks while
+    /// `max_pending` chunks are still waiting to be sent, so memory stays bounded however large the body is.
+    /// The connection takes chunks with poll() and cancels the stream if the client goes away.
+    /// A producer holding scarce resources should pass a deadline to write(), so a client that stops
+    /// reading cannot block it forever.
+    class response_stream
+    {
+    public:
+        enum class state
+        {
+            chunk,
+            pending,
+            finished,
+            failed
+        };
+
+        explicit response_stream(std::size_t max_pending = 4):
+          max_pending_(max_pending)
+        {}
+
+        response_stream(const response_stream&) = delete;
+        response_stream& operator=(const response_stream&) = delete;
+
+        /// Queue a chunk. Returns false once the connection is gone and the producer should stop.
+        bool write(std::string chunk)
+        {
+            return write(std::move(chunk), std::chrono::steady_clock::time_point::max());
+        }
+
+        /// Queue a chunk, waiting for room no later than `deadline`. If the client has not read enough by then,
+        /// the stream is cancelled (the connection drops it) and false is returned.
+        bool write(std::string chunk, std::chrono::steady_clock::time_point deadline)
+        {
+            std::function<void()> ready;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                auto has_room = [this] {
+                    return cancelled_ || chunks_.size() < max_pending_;
+                };
+                if (deadline == std::chrono::steady_clock::time_point::max())
+                    space_.wait(lock, has_room);
+                else if (!space_.wait_until(lock, deadline, has_room))
+                {
+                    timed_out_ = true;
+                    cancelled_ = true;
+                    chunks_.clear();
+                    ready_ = nullptr;
+                }
+                if (cancelled_)
+                    return false;
+                if (chunk.empty())
+                    return true;
+                chunks_.push_back(std::move(chunk));
+                ready.swap(ready_);
+            }
+            if (ready)
+                ready();
+            return true;
+        }
+
+        /// Mark the end of the body. With `ok == false` the connection is closed without the terminating chunk,
+        /// so the client can tell the response is incomplete.
+        void close(bool ok = true)
+        {
+            std::function<void()> ready;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closed_)
+                    return;
+                closed_ = true;
+                failed_ = !ok;
+                ready.swap(ready_);
+            }
+            if (ready)
+                ready();
+        }
+
+        /// Stop the producer and drop pending chunks (connection side, or when the response is discarded).
+        void cancel()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                cancelled_ = true;
+                chunks_.clear();
+                ready_ = nullptr;
+            }
+            space_.notify_all();
+        }
+
+        /// Whether a write() gave up because its deadline passed.
+        bool timed_out()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return timed_out_;
+        }
+
+        /// Connection side: take the next chunk. If none is ready yet, `ready` is called (on the producer's thread) once one is.
+        state poll(std::string& out, std::function<void()> ready)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (chunks_.empty())
+                {
+                    if (closed_)
+                        return failed_ ? state::failed : state::finished;
+                    ready_ = std::move(ready);
+                    return state::pending;
+                }
+                out = std::move(chunks_.front());
+                chunks_.pop_front();
+            }
+            space_.notify_one();
+            return state::chunk;
+        }
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable space_;
+        std::deque<std::string> chunks_;
+        std::function<void()> ready_;
+        std::size_t max_pending_;
+        bool closed_ = false;
+        bool failed_ = false;
+        bool cancelled_ = false;
+        bool timed_out_ = false;
+    };
+
     /// HTTP response
     struct response
     {
@@ -41,6 +178,30 @@ namespace crow
         std::string body; ///< The actual payload containing the response data.
         ci_map headers;   ///< HTTP headers.
 
+        /// A part of the body that is written after `body` without being copied into it.
+
+        ///
+        /// Either references memory kept alive by `owner` (e.g. an immutable cached page) or holds its own `text`.
+        struct body_segment
+        {
+            const char* data = nullptr;
+            std::size_t size = 0;
+            std::shared_ptr<const void> owner;
+            std::string text;
+            bool owns_text = false;
+
+            const char* begin() const { return owns_text ? text.data() : data; }
+            std::size_t length() const { return owns_text ? text.size() : size; }
+        };
+        std::vector<body_segment> segments; ///< Scatter-gather body parts, sent together with the headers in one write.
+
+        /// If set, `body` and `segments` are ignored and the body is sent with `Transfer-Encoding: chunked`
+        /// as the stream produces it. Streamed responses close the connection when they finish.
+        std::shared_ptr<response_stream> stream;
+
+        /// Called on the IO thread once the response has been written to the socket (or writing it failed).
+        std::function<void()> on_sent;
+
 #ifdef CROW_ENABLE_COMPRESSION
         bool compressed = true; ///< If compression is enabled and this is false, the individual response will not be compressed.
 #endif
@@ -166,8 +327,14 @@ namespace crow
         response& operator=(response&& r) noexcept
         {
             body = std::move(r.body);
+            segments = std::move(r.segments);
+            stream = std::move(r.stream);
+            on_sent = std::move(r.on_sent);
             code = r.code;
             headers = std::move(r.headers);
+#ifdef CROW_ENABLE_COMPRESSION
+            compressed = r.compressed;
+#endif
             completed_ = r.completed_;
             file_info = std::move(r.file_info);
             return *this;
@@ -182,6 +349,13 @@ namespace crow
         void clear()
         {
             body.clear();
+            segments.clear();
+            if (stream)
+            {
+                stream->cancel();
+                stream.reset();
+            }
+            on_sent = nullptr;
             code = 200;
             headers.clear();
             completed_ = false;
@@ -230,7 +404,56 @@ namespace crow
 
         void write(const std::string& body_part)
         {
-            body += body_part;
+            if (segments.empty())
+                body += body_part;
+            else
+                add_segment(body_part);
+        }
+
+        /// Append a body segment that references `size` bytes at `data` without copying them.
+
+        ///
+        /// `owner` must keep the memory alive; the response holds it until the write completes.
+        void add_segment(const char* data, std::size_t size, std::shared_ptr<const void> owner)
+        {
+            if (size == 0)
+                return;
+            body_segment segment;
+            segment.data = data;
+            segment.size = size;
+            segment.owner = std::move(owner);
+            segments.push_back(std::move(segment));
+        }
+
+        /// Append a body segment that owns its text (for dynamic parts between referenced ones).
+        void add_segment(std::string text)
+        {
+            if (text.empty())
+                return;
+            body_segment segment;
+            segment.text = std::move(text);
+            segment.owns_text = true;
+            segments.push_back(std::move(segment));
+        }
+
+        /// Total body size: `body` plus all segments.
+        std::size_t body_size() const
+        {
+            std::size_t size = body.size();
+            for (const body_segment& segment : segments)
+                size += segment.length();
+            return size;
+        }
+
+        /// Copy all segments into `body`, for code that needs the whole body as one string (e.g. compression).
+        void flatten_body()
+        {
+            if (segments.empty())
+                return;
+            body.reserve(body_size());
+            for (const body_segment& segment : segments)
+                body.append(segment.begin(), segment.length());
+            segments.clear();
         }
 
         /// Set the response completion flag and call the handler (to send the response).
@@ -241,8 +464,14 @@ namespace crow
                 completed_ = true;
                 if (skip_body)
                 {
-                    set_header("Content-Length", std::to_string(body.size()));
+                    set_header("Content-Length", std::to_string(body_size()));
                     body = "";
+                    segments.clear();
+                    if (stream)
+                    {
+                        stream->cancel();
+                        stream.reset();
+                    }
                     manual_length_header = true;
                 }
                 if (complete_request_handler_)
@@ -257,7 +486,7 @@ namespace crow
         /// Same as end() except it adds a body part right before ending.
         void end(const std::string& body_part)
         {
-            body += body_part;
+            write(body_part);
             end();
         }
 
@@ -2,12 +2,24 @@
 
 #include "crow/settings.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
 
 namespace crow
 {
@@ -38,39 +50,29 @@ namespace crow
         virtual void log(std::string message, LogLevel level) = 0;
     };
 
-    class CerrLogHandler : public ILogHandler
+    namespace detail
     {
-    public:
-        void log(std::string message, LogLevel level) override
+        inline const char* log_prefix(LogLevel level)
         {
-            std::string prefix;
             switch (level)
             {
                 case LogLevel::Debug:
-                    prefix = "DEBUG   ";
-                    break;
+                    return "DEBUG   ";
                 case LogLevel::Info:
-                    prefix = "INFO    ";
-                    break;
+                    return "INFO    ";
                 case LogLevel::Warning:
-                    prefix = "WARNING ";
-                    break;
+                    return "WARNING ";
                 case LogLevel::Error:
-                    prefix = "ERROR   ";
-                    break;
+                    return "ERROR   ";
                 case LogLevel::Critical:
-                    prefix = "CRITICAL";
-                    break;
+                    return "CRITICAL";
             }
-            std::cerr << std::string("(") + timestamp() + std::string(") [") + prefix + std::string("] ") + message << std::endl;
+            return "";
         }
 
-    private:
-        static std::string timestamp()
+        inline std::string log_timestamp(time_t t)
         {
             char date[32];
-            time_t t = time(0);
-
             tm my_tm;
 
 #if defined(_MSC_VER) || defined(__MINGW32__)
@@ -90,6 +92,220 @@ namespace crow
             size_t sz = strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &my_tm);
             return std::string(date, date + sz);
         }
+    } // namespace detail
+
+    class CerrLogHandler : public ILogHandler
+    {
+    public:
+        void log(std::string message, LogLevel level) override
+        {
+            std::cerr << std::string("(") + detail::log_timestamp(time(0)) + std::string(") [") + detail::log_prefix(level) + std::string("] ") + message << std::endl;
+        }
+    };
+
+    /// Log handler that hands messages to a background thread through a fixed-size lock-free ring.
+
+    ///
+    /// log() never blocks: it claims a ring slot (multi-producer, sequence numbered slots) or, when the
+    /// ring is full, drops the message and counts it. The writer thread drains up to `batch_size` messages
+    /// at a time and writes each batch to stderr with one writev() (one fwrite() on Windows),
+    /// so a burst of errors does not serialize every worker thread on the stderr lock.
+    /// The handler must outlive every thread that logs; pending messages are written when it is destroyed.
+    class AsyncLogHandler : public ILogHandler
+    {
+    public:
+        static constexpr std::size_t batch_size = 64;
+
+        /// `capacity` is rounded up to a power of two.
+        explicit AsyncLogHandler(std::size_t capacity = 8192)
+        {
+            std::size_t size = 2;
+            while (size < capacity)
+                size <<= 1;
+            mask_ = size - 1;
+            slots_.reset(new slot[size]);
+            for (std::size_t i = 0; i < size; i++)
+                slots_[i].sequence.store(i, std::memory_order_relaxed);
+            writer_ = std::thread([this] {
+                run();
+            });
+        }
+
+        AsyncLogHandler(const AsyncLogHandler&) = delete;
+        AsyncLogHandler& operator=(const AsyncLogHandler&) = delete;
+
+        ~AsyncLogHandler()
+        {
+            stopping_.store(true, std::memory_order_release);
+            wake_.notify_one();
+            writer_.join();
+            std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+            if (dropped)
+                std::cerr << "(" << detail::log_timestamp(time(0)) << ") [WARNING ] " << dropped << " log messages were dropped" << std::endl;
+        }
+
+        void log(std::string message, LogLevel level) override
+        {
+            std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+            slot* claimed;
+            for (;;)
+            {
+                claimed = &slots_[pos & mask_];
+                std::size_t sequence = claimed->sequence.load(std::memory_order_acquire);
+                auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+                if (diff == 0)
+                {
+                    if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                }
+                else if (diff < 0)
+                {
+                    // Full: the writer is behind by a whole ring
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                {
+                    pos = enqueue_pos_.load(std::memory_order_relaxed);
+                }
+            }
+
+            claimed->message = std::move(message);
+            claimed->level = level;
+            claimed->time = time(0);
+            claimed->sequence.store(pos + 1, std::memory_order_release);
+
+            if (sleeping_.load(std::memory_order_acquire))
+                wake_.notify_one();
+        }
+
+        /// Messages written to stderr so far.
+        std::uint64_t written() const { return written_.load(std::memory_order_relaxed); }
+
+        /// Messages dropped because the ring was full.
+        std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    private:
+        struct slot
+        {
+            std::atomic<std::size_t> sequence{0};
+            std::string message;
+            LogLevel level = LogLevel::Info;
+            time_t time = 0;
+        };
+
+        void run()
+        {
+            for (;;)
+            {
+                if (drain())
+                    continue;
+                if (stopping_.load(std::memory_order_acquire))
+                {
+                    if (!drain())
+                        break;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                sleeping_.store(true, std::memory_order_seq_cst);
+                // A message queued between drain() and here only waits for the timeout
+                if (!ready() && !stopping_.load(std::memory_order_acquire))
+                    wake_.wait_for(lock, std::chrono::milliseconds(50));
+                sleeping_.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        bool ready() const
+        {
+            const slot& next = slots_[dequeue_pos_ & mask_];
+            return next.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+        }
+
+        /// Writes one batch. Returns the number of messages written.
+        std::size_t drain()
+        {
+            std::size_t count = 0;
+            while (count < batch_size && ready())
+            {
+                slot& next = slots_[dequeue_pos_ & mask_];
+                if (next.time != last_time_ || stamp_.empty())
+                {
+                    last_time_ = next.time;
+                    stamp_ = detail::log_timestamp(next.time);
+                }
+                headers_[count] = "(" + stamp_ + ") [" + detail::log_prefix(next.level) + "] ";
+                messages_[count].swap(next.message);
+                next.message.clear();
+                next.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+                ++dequeue_pos_;
+                ++count;
+            }
+            if (count)
+            {
+                write_batch(count);
+                written_.fetch_add(count, std::memory_order_relaxed);
+            }
+            return count;
+        }
+
+        void write_batch(std::size_t count)
+        {
+            static const char newline = '\n';
+#ifdef _WIN32
+            std::string out;
+            for (std::size_t i = 0; i < count; i++)
+                out.append(headers_[i]).append(messages_[i]).append(1, newline);
+            std::fwrite(out.data(), 1, out.size(), stderr);
+            std::fflush(stderr);
+#else
+            iovec parts[batch_size * 3];
+            std::size_t n = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                parts[n++] = {const_cast<char*>(headers_[i].data()), headers_[i].size()};
+                parts[n++] = {const_cast<char*>(messages_[i].data()), messages_[i].size()};
+                parts[n++] = {const_cast<char*>(&newline), 1};
+            }
+            iovec* part = parts;
+            while (n > 0)
+            {
+                ssize_t written = ::writev(STDERR_FILENO, part, static_cast<int>(n));
+                if (written < 0)
+                    break; // stderr is gone; nothing else to report to
+                // Partial write: skip what went out and continue with the rest
+                while (n > 0 && static_cast<std::size_t>(written) >= part->iov_len)
+                {
+                    written -= static_cast<ssize_t>(part->iov_len);
+                    ++part;
+                    --n;
+                }
+                if (n > 0)
+                {
+                    part->iov_base = static_cast<char*>(part->iov_base) + written;
+                    part->iov_len -= static_cast<std::size_t>(written);
+                }
+            }
+#endif
+        }
+
+        std::unique_ptr<slot[]> slots_;
+        std::size_t mask_ = 0;
+        alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+        alignas(64) std::size_t dequeue_pos_ = 0; // writer thread only
+
+        std::string headers_[batch_size];
+        std::string messages_[batch_size];
+        std::string stamp_;
+        time_t last_time_ = 0;
+
+        std::atomic<std::uint64_t> written_{0};
+        std::atomic<std::uint64_t> dropped_{0};
+        std::atomic<bool> stopping_{false};
+        std::atomic<bool> sleeping_{false};
+        std::mutex wake_mutex_;
+        std::condition_variable wake_;
+        std::thread writer_;
     };
 
     class logger
@@ -0,0 +1,197 @@
+#ifdef CROW_ENABLE_COMPRESSION
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "crow/http_request.h"
+#include "crow/http_response.h"
+#include "crow/compression.h"
+#include "crow/logging.h"
+#include "crow/utility.h"
+
+namespace crow
+{
+    /// Compresses response bodies with gzip or deflate, whichever the client accepts.
+
+    ///
+    /// Unlike `App::use_compression()`, bodies smaller than `min_size`, types that do not
+    /// compress well, and bodies that already have a `Content-Encoding` are sent as they are.
+    /// Scatter-gather bodies are compressed segment by segment without being flattened first.
+    /// Compression reuses the calling IO thread's z_stream (see compression::thread_deflater).
+    struct CompressionMiddleware
+    {
+        struct context
+        {};
+
+        struct stats
+        {
+            std::uint64_t compressed;      ///< Responses sent compressed.
+            std::uint64_t skipped;         ///< Responses that could have been compressed but were not worth it.
+            std::uint64_t bytes_in;        ///< Body bytes before compression (compressed responses only).
+            std::uint64_t bytes_out;       ///< Body bytes after compression.
+        };
+
+        CompressionMiddleware()
+        {
+            types_ = {"text/", "application/json", "application/javascript", "application/xml", "image/svg+xml"};
+        }
+
+        /// zlib compression level, 1 (fastest) to 9 (smallest), or Z_DEFAULT_COMPRESSION.
+        CompressionMiddleware& level(int level)
+        {
+            level_ = level;
+            return *this;
+        }
+
+        /// Bodies smaller than this are not worth the CPU and the extra header.
+        CompressionMiddleware& min_size(std::size_t size)
+        {
+            min_size_ = size;
+            return *this;
+        }
+
+        /// Content-Type prefixes that are compressed (e.g. "text/"). Everything else is sent as is.
+        CompressionMiddleware& types(std::vector<std::string> prefixes)
+        {
+            types_ = std::move(prefixes);
+            return *this;
+        }
+
+        stats get_stats() const
+        {
+            return {compressed_.load(std::memory_order_relaxed), skipped_.load(std::memory_order_relaxed),
+                    bytes_in_.load(std::memory_order_relaxed), bytes_out_.load(std::memory_order_relaxed)};
+        }
+
+        void before_handle(request& /*req*/, response& /*res*/, context& /*ctx*/)
+        {}
+
+        void after_handle(request& req, response& res, context& /*ctx*/)
+        {
+            if (req.method == HTTPMethod::Head || res.stream || res.is_static_type() || res.code == 204 || res.code == 304)
+                return;
+            if (!res.get_header_value("Content-Encoding").empty())
+                return;
+
+            std::size_t size = res.body_size();
+            if (size < min_size_ || !compressible_type(res.get_header_value("Content-Type")))
+                return;
+
+            compression::algorithm algo;
+            if (!compression::negotiate(req.get_header_value("Accept-Encoding"), algo))
+                return;
+
+            compression::deflater& compressor = compression::thread_deflater(algo, level_);
+            std::string out;
+            out.reserve(size / 3 + 64);
+            // The body is sent first, then the segments; owned segments keep their text in `text`
+            bool ok = compressor.write(res.body.data(), res.body.size(), out, res.segments.empty());
+            for (std::size_t i = 0; ok && i < res.segments.size(); i++)
+                ok = compressor.write(res.segments[i].begin(), res.segments[i].length(), out, i + 1 == res.segments.size());
+
+#ifdef CROW_ENABLE_DEBUG
+            if (ok && !matches(res, out))
+            {
+                CROW_LOG_ERROR << "CompressionMiddleware: compressed body does not match the original, sending it uncompressed";
+                ok = false;
+            }
+#endif
+
+            if (!ok || out.size() >= size)
+            {
+                skipped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            compressed_.fetch_add(1, std::memory_order_relaxed);
+            bytes_in_.fetch_add(size, std::memory_order_relaxed);
+            bytes_out_.fetch_add(out.size(), std::memory_order_relaxed);
+
+            res.segments.clear();
+            res.body = std::move(out);
+            res.set_header("Content-Encoding", algo == compression::GZIP ? "gzip" : "deflate");
+            weaken_etag(res);
+            add_vary(res, "Accept-Encoding");
+            if (res.headers.count("Content-Length"))
+                res.set_header("Content-Length", std::to_string(res.body.size()));
+            res.compressed = false; // Already done, App::use_compression() must not compress it again
+        }
+
+    private:
+        /// A strong ETag names exact bytes, so once the body is compressed it only stays valid as a weak ETag.
+        /// If-None-Match uses weak comparison, so revalidation keeps working.
+        static void weaken_etag(response& res)
+        {
+            auto it = res.headers.find("ETag");
+            if (it != res.headers.end() && it->second.compare(0, 2, "W/") != 0)
+                it->second = "W/" + it->second;
+        }
+
+        /// Add `field` to the Vary header, merging any Vary values already set instead of adding another header.
+        static void add_vary(response& res, const std::string& field)
+        {
+            std::string vary;
+            bool present = false;
+            auto range = res.headers.equal_range("Vary");
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                const std::string& value = it->second;
+                std::size_t pos = 0;
+                while (pos < value.size())
+                {
+                    std::size_t end = value.find(',', pos);
+                    if (end == std::string::npos)
+                        end = value.size();
+                    std::string name = value.substr(pos, end - pos);
+                    pos = end + 1;
+                    name.erase(0, name.find_first_not_of(" \t"));
+                    name.erase(name.find_last_not_of(" \t") + 1);
+                    if (name.empty())
+                        continue;
+                    present = present || name == "*" || utility::string_equals(name, field);
+                    vary += vary.empty() ? name : ", " + name;
+                }
+            }
+            if (!present)
+                vary += vary.empty() ? field : ", " + field;
+            res.set_header("Vary", std::move(vary));
+        }
+
+#ifdef CROW_ENABLE_DEBUG
+        /// Debug check: the compressed output inflates back to the body followed by every segment.
+        static bool matches(const response& res, const std::string& compressed)
+        {
+            std::string original = res.body;
+            for (const auto& segment : res.segments)
+                original.append(segment.begin(), segment.length());
+            return compression::decompress_string(compressed) == original;
+        }
+#endif
+
+        bool compressible_type(const std::string& content_type) const
+        {
+            // Crow sets text/plain later for responses without a Content-Type
+            if (content_type.empty())
+                return true;
+            for (const auto& prefix : types_)
+                if (content_type.compare(0, prefix.size(), prefix) == 0)
+                    return true;
+            return false;
+        }
+
+        int level_ = Z_DEFAULT_COMPRESSION;
+        std::size_t min_size_ = 1024;
+        std::vector<std::string> types_;
+
+        std::atomic<std::uint64_t> compressed_{0};
+        std::atomic<std::uint64_t> skipped_{0};
+        std::atomic<std::uint64_t> bytes_in_{0};
+        std::atomic<std::uint64_t> bytes_out_{0};
+    };
+
+} // namespace crow
+#endif
@@ -91,8 +91,8 @@ namespace crow
                 {
                     return {true, *stack.back()};
                 }
-                static json::wvalue empty_str;
-                empty_str = "";
+                // Initialized once; assigning to a shared static on every lookup raced between rendering threads
+                static const json::wvalue empty_str("");
 
                 int dotPosition = name.find(".");
                 if (dotPosition == static_cast<int>(name.npos))
@@ -152,22 +152,7 @@ namespace crow
 
             void escape(const std::string& in, std::string& out) const
             {
-                out.reserve(out.size() + in.size());
-                for (auto it = in.begin(); it != in.end(); ++it)
-                {
-                    switch (*it)
-                    {
-                        case '&': out += "&amp;"; break;
-                        case '<': out += "&lt;"; break;
-                        case '>': out += "&gt;"; break;
-                        case '"': out += "&quot;"; break;
-                        case '\'': out += "&#39;"; break;
-                        case '/': out += "&#x2F;"; break;
-                        case '`': out += "&#x60;"; break;
-                        case '=': out += "&#x3D;"; break;
-                        default: out += *it; break;
-                    }
-                }
+                utility::html_escape_append(in.data(), in.size(), out);
             }
 
             bool isTagInsideObjectBlock(const int& current, const std::vector<const context*>& stack) const
@@ -408,6 +393,15 @@ namespace crow
                 return ret;
             }
 
+            /// Apply the values from the context provided and append the output to \p out (which may already be reserved)
+            void render_to(std::string& out, const context& ctx) const
+            {
+                std::vector<const context*> stack;
+                stack.emplace_back(&ctx);
+
+                render_internal(0, fragments_.size() - 1, stack, out, 0);
+            }
+
         private:
             void parse()
             {
@@ -3,9 +3,11 @@
 #include <string>
 #include <unordered_map>
 #include <algorithm>
+#include <limits>
 
 #include "crow/http_request.h"
 #include "crow/http_parser_merged.h"
+#include "crow/logging.h"
 
 namespace crow
 {
@@ -82,12 +84,25 @@ namespace crow
 
             self->set_connection_parameters();
 
+            // Refuse an oversized body before reading any of it (content_length is all ones when not given)
+            if (self->content_length != std::numeric_limits<uint64_t>::max() && self->content_length > self->handler_->max_body_size())
+            {
+                CROW_LOG_WARNING << "Request body of " << self->content_length << " bytes exceeds the limit of " << self->handler_->max_body_size();
+                return -1;
+            }
+
             self->process_header();
             return 0;
         }
         static int on_body(http_parser* self_, const char* at, size_t length)
         {
             HTTPParser* self = static_cast<HTTPParser*>(self_);
+            // Chunked bodies have no Content-Length, so the limit is also checked as data arrives
+            if (length > self->handler_->max_body_size() - self->req.body.size())
+            {
+                CROW_LOG_WARNING << "Request body exceeds the limit of " << self->handler_->max_body_size() << " bytes";
+                return 1;
+            }
             self->req.body.insert(self->req.body.end(), at, at + length);
             return 0;
         }
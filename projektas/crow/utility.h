@@ -19,6 +19,19 @@
 #include <filesystem>
 #endif
 
+// HTML escaping scans 32 (AVX2) or 16 (SSE2) bytes at a time when the target allows it
+#if defined(__AVX2__)
+#define CROW_HTML_ESCAPE_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CROW_HTML_ESCAPE_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(_MSC_VER) && (defined(CROW_HTML_ESCAPE_AVX2) || defined(CROW_HTML_ESCAPE_SSE2))
+#include <intrin.h>
+#endif
+
 // TODO(EDev): Adding C++20's [[likely]] and [[unlikely]] attributes might be useful
 #if defined(__GNUG__) || defined(__clang__)
 #define CROW_LIKELY(X) __builtin_expect(!!(X), 1)
@@ -906,5 +919,103 @@ namespace crow
 
             return v.substr(begin, end - begin);
         }
+
+        namespace detail
+        {
+            /// Entity for a character that must be escaped in HTML, or nullptr if it can be copied as is.
+            inline const char* html_entity(char c, std::size_t& length)
+            {
+                switch (c)
+                {
+                    case '&': length = 5; return "&amp;";
+                    case '<': length = 4; return "&lt;";
+                    case '>': length = 4; return "&gt;";
+                    case '"': length = 6; return "&quot;";
+                    case '\'': length = 5; return "&#39;";
+                    case '/': length = 6; return "&#x2F;";
+                    case '`': length = 6; return "&#x60;";
+                    case '=': length = 6; return "&#x3D;";
+                    default: return nullptr;
+                }
+            }
+
+#if defined(CROW_HTML_ESCAPE_AVX2) || defined(CROW_HTML_ESCAPE_SSE2)
+            inline unsigned lowest_set_bit(unsigned mask)
+            {
+#ifdef _MSC_VER
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return static_cast<unsigned>(index);
+#else
+                return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+            }
+#endif
+
+            /// First character in [p, end) that needs escaping, or end.
+            inline const char* find_html_special(const char* p, const char* end)
+            {
+#ifdef CROW_HTML_ESCAPE_AVX2
+                const __m256i amp32 = _mm256_set1_epi8('&'), lt32 = _mm256_set1_epi8('<'), gt32 = _mm256_set1_epi8('>'), quot32 = _mm256_set1_epi8('"');
+                const __m256i apos32 = _mm256_set1_epi8('\''), slash32 = _mm256_set1_epi8('/'), tick32 = _mm256_set1_epi8('`'), eq32 = _mm256_set1_epi8('=');
+                while (end - p >= 32)
+                {
+                    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+                    __m256i hit = _mm256_or_si256(
+                      _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, amp32), _mm256_cmpeq_epi8(chunk, lt32)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, gt32), _mm256_cmpeq_epi8(chunk, quot32))),
+                      _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, apos32), _mm256_cmpeq_epi8(chunk, slash32)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, tick32), _mm256_cmpeq_epi8(chunk, eq32))));
+                    unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit));
+                    if (mask)
+                        return p + lowest_set_bit(mask);
+                    p += 32;
+                }
+#endif
+#ifdef CROW_HTML_ESCAPE_SSE2
+                const __m128i amp16 = _mm_set1_epi8('&'), lt16 = _mm_set1_epi8('<'), gt16 = _mm_set1_epi8('>'), quot16 = _mm_set1_epi8('"');
+                const __m128i apos16 = _mm_set1_epi8('\''), slash16 = _mm_set1_epi8('/'), tick16 = _mm_set1_epi8('`'), eq16 = _mm_set1_epi8('=');
+                while (end - p >= 16)
+                {
+                    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                    __m128i hit = _mm_or_si128(
+                      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, amp16), _mm_cmpeq_epi8(chunk, lt16)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, gt16), _mm_cmpeq_epi8(chunk, quot16))),
+                      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, apos16), _mm_cmpeq_epi8(chunk, slash16)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(chunk, tick16), _mm_cmpeq_epi8(chunk, eq16))));
+                    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+                    if (mask)
+                        return p + lowest_set_bit(mask);
+                    p += 16;
+                }
+#endif
+                std::size_t length;
+                while (p < end && !html_entity(*p, length))
+                    ++p;
+                return p;
+            }
+        } // namespace detail
+
+        /// Append `size` bytes of `data` to `out` with HTML special characters replaced by entities.
+
+        ///
+        /// Runs without special characters are located with SIMD compares (where available) and copied in bulk.
+        inline void html_escape_append(const char* data, std::size_t size, std::string& out)
+        {
+            const char* p = data;
+            const char* end = data + size;
+            out.reserve(out.size() + size);
+            while (p < end)
+            {
+                const char* special = detail::find_html_special(p, end);
+                out.append(p, special - p);
+                if (special == end)
+                    break;
+                std::size_t length = 0;
+                const char* entity = detail::html_entity(*special, length);
+                out.append(entity, length);
+                p = special + 1;
+            }
+        }
     } // namespace utility
 } // namespace crow
@@ -5,8 +5,30 @@
 #include <memory>
 #include <mariadb/conncpp.hpp>
 #include <crow.h>
+#include <crow/middlewares/compression.h>
 #include <fstream>
 #include <tuple>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <array>
+#include <thread>
+#include <functional>
+#include <unordered_set>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+#include <optional>
+#include <random>
+#include <cmath>
+#include <limits>
 
 
 class User;
@@ -27,2842 +49,6044 @@ std::string loadHTML(const std::string& filename) {
             std::istreambuf_iterator<char>());
     }
     else {
-        std::cerr << "Nepavyko įkrauti HTML failo: " << filename << std::endl;
+        CROW_LOG_ERROR << "Nepavyko įkrauti HTML failo: " << filename;
     }
 
     return content;
 }
 
+// Pakeičia HTML specialius simbolius, kad vartotojo tekstas nebūtų interpretuojamas kaip žymės
+// Tas pats vektorizuotas branduolys, kurį naudoja ir šablonai (crow::utility::html_escape_append)
+std::string htmlEscape(std::string_view text) {
+    std::string out;
+    crow::utility::html_escape_append(text.data(), text.size(), out);
+    return out;
+}
 
-
-class User {
-public:
-    // Konstuktorius
-    User(int id, const string& name, const string& surname, const string& role)
-        : id_(id), name_(name), surname_(surname), role_(role) {
-        // Sukuriame prisijungimo vardą.
-        username_ = string(1, tolower(name_[0])) + name_.substr(1);
-        // Sukuriame slaptažodį: pavardė
-        password_ = surname_;
+// Išrenka sveikųjų skaičių ID sąrašą; skyrikliai gali būti bet kokie ne skaitmenys (kableliai, tarpai, naujos eilutės)
+std::vector<int> parseIdList(std::string_view text) {
+    std::vector<int> ids;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        if (*p < '0' || *p > '9') {
+            ++p;
+            continue;
+        }
+        int id = 0;
+        auto result = std::from_chars(p, end, id);
+        if (result.ec == std::errc()) {
+            ids.push_back(id);
+        }
+        p = result.ptr;
+        while (p < end && *p >= '0' && *p <= '9') ++p;  // per didelį skaičių praleidžiame
     }
+    return ids;
+}
 
-    // Getter'iai
-    int getId() const { return id_; }
-    string getName() const { return name_; }
-    string getSurname() const { return surname_; }
-    string getRole() const { return role_; }
-    string getUsername() const { return username_; }
-    string getPassword() const { return password_; }
-
-private:
-    int id_;
-    string name_;
-    string surname_;
-    string role_;
-    string username_;
-    string password_;
-};
+// URL parametro ID (pvz., ?student_id=12): tik neneigiamas sveikasis skaičius be jokių kitų simbolių
+bool parseId(const char* text, int& id) {
+    if (!text || !*text) return false;
+    std::string_view view(text);
+    int parsed = 0;
+    auto result = std::from_chars(view.data(), view.data() + view.size(), parsed);
+    if (result.ec != std::errc() || result.ptr != view.data() + view.size() || parsed < 0) return false;
+    id = parsed;
+    return true;
+}
 
-class MySQLDatabase {
+// application/x-www-form-urlencoded formos dekoderis visiems POST maršrutams. Laukai grąžinami kaip
+// string_view tiesiai į užklausos body; tik laukai su %XX ar '+' dekoduojami į vieną užklausos buferį
+// (arena_), kuriam iš anksto rezervuojamas body dydis, todėl jau grąžinti view nebeinvaliduojami.
+// Objektas negali gyventi ilgiau už body, iš kurio sukurtas.
+class FormData {
 public:
-    MySQLDatabase(const std::string& host, const std::string& user, const std::string& password, const std::string& db)
-        : host_(host), user_(user), password_(password), db_(db) {}
-
-    // Funkcija, kuri tikrina vartotoją pagal username ir password, ir grąžina vartotojo vaidmenį bei ID
-    std::pair<std::string, int> validateUser(const std::string& username, const std::string& password) {
-        sql::Connection* con = connect();
-        if (con) {
-            try {
-                // Patikrinti studentų lentelę
-                std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                    "SELECT role, student_id FROM students WHERE username = ? AND password = ?"));
-                pstmt->setString(1, username);
-                pstmt->setString(2, password);
-                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-                if (res->next()) {
-                    return { "Studentas", res->getInt("student_id") };  // Grąžinsime studento ID
-                }
-
-                // Patikrinti dėstytojų lentelę
-                pstmt = std::unique_ptr<sql::PreparedStatement>(con->prepareStatement(
-                    "SELECT role, teacher_id FROM teachers WHERE username = ? AND password = ?"));
-                pstmt->setString(1, username);
-                pstmt->setString(2, password);
-                res = std::unique_ptr<sql::ResultSet>(pstmt->executeQuery());
-                if (res->next()) {
-                    return { "Destytojas", res->getInt("teacher_id") };  // Grąžinsime dėstytojo ID
-                }
-
-                // Patikrinti administratorių lentelę
-                pstmt = std::unique_ptr<sql::PreparedStatement>(con->prepareStatement(
-                    "SELECT role FROM administrator WHERE username = ? AND password = ?"));
-                pstmt->setString(1, username);
-                pstmt->setString(2, password);
-                res = std::unique_ptr<sql::ResultSet>(pstmt->executeQuery());
-                if (res->next()) {
-                    return { "Administratorius", -1 };  // Administratoriams negrąžiname ID, nes jie neturi `student_id` ar `teacher_id`
-                }
-
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida tikrinant vartotoją: " << e.what() << std::endl;
-            }
-            delete con;
+    explicit FormData(std::string_view body) {
+        fields_.reserve(8);
+        std::size_t pos = 0;
+        while (pos <= body.size()) {
+            std::size_t end = body.find('&', pos);
+            if (end == std::string_view::npos) end = body.size();
+            std::string_view pair = body.substr(pos, end - pos);
+            pos = end + 1;
+            if (pair.empty()) continue;
+
+            std::size_t eq = pair.find('=');
+            std::string_view key = pair.substr(0, eq);
+            std::string_view value = eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+            fields_.push_back({ decode(key, body.size()), decode(value, body.size()) });
         }
-        return { "", -1 };  // Jei vartotojas nerastas, grąžinsime tuščią rolę ir klaidingą ID
     }
 
-    // Funkcija, kad suskaidytume POST užklausą į parametrus (prisijungimui)
-    void parseLoginData(const std::string& body, std::string& username, std::string& password) {
-        std::istringstream stream(body);
-        std::string param;
-        while (std::getline(stream, param, '&')) {
-            size_t pos = param.find("=");
-            if (pos != std::string::npos) {
-                std::string key = param.substr(0, pos);
-                std::string value = param.substr(pos + 1);
+    // view rodo į body arba arena_, todėl objekto nei kopijuojame, nei perkeliame
+    FormData(const FormData&) = delete;
+    FormData& operator=(const FormData&) = delete;
 
-                if (key == "username") {
-                    username = value;
-                }
-                else if (key == "password") {
-                    password = value;
-                }
-            }
+    // Pirmo lauko su tokiu vardu reikšmė; std::nullopt, jei lauko nėra
+    std::optional<std::string_view> get(std::string_view key) const {
+        for (const Field& field : fields_) {
+            if (field.key == key) return field.value;
         }
+        return std::nullopt;
     }
 
+    // Sveikasis skaičius per std::from_chars; false, jei lauko nėra arba reikšmė nėra vien skaičius
+    bool getInt(std::string_view key, int& value) const {
+        std::optional<std::string_view> text = get(key);
+        if (!text || text->empty()) return false;
+        int parsed = 0;
+        auto result = std::from_chars(text->data(), text->data() + text->size(), parsed);
+        if (result.ec != std::errc() || result.ptr != text->data() + text->size()) return false;
+        value = parsed;
+        return true;
+    }
 
+private:
+    struct Field {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
 
-    sql::Connection* connect() {
-        try {
-            sql::Driver* driver = sql::mariadb::get_driver_instance();
-            sql::Connection* con = driver->connect("tcp://" + host_ + ":3306", user_, password_);
-            con->setSchema(db_);
-            return con;
+    std::string_view decode(std::string_view text, std::size_t body_size) {
+        if (text.find_first_of("%+") == std::string_view::npos) {
+            return text;  // Dažniausias atvejis - be kopijos
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "MariaDB klaida: " << e.what() << std::endl;
-            return nullptr;
+        if (arena_.capacity() < body_size) {
+            arena_.reserve(body_size);  // Dekoduotas tekstas niekada neilgesnis už užkoduotą
+        }
+        std::size_t start = arena_.size();
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            char c = text[i];
+            int high = 0, low = 0;
+            if (c == '+') {
+                arena_ += ' ';
+            }
+            else if (c == '%' && i + 2 < text.size() && (high = hexValue(text[i + 1])) >= 0 && (low = hexValue(text[i + 2])) >= 0) {
+                arena_ += static_cast<char>(high * 16 + low);
+                i += 2;
+            }
+            else {
+                arena_ += c;  // Netaisyklingą %XX paliekame kaip yra
+            }
         }
+        return std::string_view(arena_.data() + start, arena_.size() - start);
     }
 
-private:
-    std::string host_;
-    std::string user_;
-    std::string password_;
-    std::string db_;
+    std::vector<Field> fields_;
+    std::string arena_;
 };
 
-//Studento klasė (vaikas iš user klasės)
-class Student : public User {
-public:
-    Student(int id, const string& name, const string& surname)
-        : User(id, name, surname, "Studentas") {}
+// Sąrašo puslapio parametrai: ?after=<paskutinis ID>&limit=<kiek>&prefix=<vardo pradžia>
+struct PageRequest {
+    static constexpr std::size_t kDefaultLimit = 50;
+    static constexpr std::size_t kMaxLimit = 500;
 
-    // Metodas grąžinantis studento duomenis
-    static bool getStudentData(int student_id, sql::Connection* con, std::string& name, std::string& surname, std::vector<std::pair<std::string, std::string>>& subjects) {
-        // Pirma užklausa: gauti studento vardą ir pavardę
-        std::unique_ptr<sql::PreparedStatement> studentPstmt(con->prepareStatement(
-            "SELECT name, surname FROM students WHERE student_id = ?"
-        ));
-        studentPstmt->setInt(1, student_id);
+    int after = 0;                      // grąžinami tik įrašai su didesniu ID
+    std::size_t limit = kDefaultLimit;
+    std::string prefix;                 // tuščias - be filtro
+};
 
-        std::unique_ptr<sql::ResultSet> studentRes(studentPstmt->executeQuery());
+// false - after ar limit nurodyti, bet nėra neneigiami sveikieji skaičiai (limit dar ir ne 0).
+// Tokio žymeklio neperaiškiname į kitą puslapį - maršrutai atsako 400.
+bool parsePageRequest(const crow::request& req, PageRequest& page) {
+    if (const char* after = req.url_params.get("after")) {
+        if (!parseId(after, page.after)) return false;
+    }
+    if (const char* limit = req.url_params.get("limit")) {
+        int value = 0;
+        if (!parseId(limit, value) || value == 0) return false;
+        page.limit = std::min(static_cast<std::size_t>(value), PageRequest::kMaxLimit);
+    }
+    if (const char* prefix = req.url_params.get("prefix")) {
+        page.prefix = prefix;
+    }
+    return true;
+}
 
-        if (studentRes->next()) {
-            name = studentRes->getString("name").c_str();
-            surname = studentRes->getString("surname").c_str();
+// Koduoja reikšmę naudojimui URL užklausos dalyje
+std::string urlEncode(std::string_view text) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(text.size());
+    for (unsigned char c : text) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
         }
         else {
-            return false;  // Studentas nerastas
+            out += '%';
+            out += hex[c >> 4];
+            out += hex[c & 15];
         }
+    }
+    return out;
+}
 
-        // Antra užklausa: gauti studento studijojamus dalykus ir pažymius
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT sub.subject_name, "
-            "CASE WHEN g.grade IS NULL THEN 'Nera' ELSE CAST(g.grade AS CHAR) END AS grade "
-            "FROM students_subjects ss "
-            "JOIN subjects sub ON ss.subject_id = sub.subject_id "
-            "LEFT JOIN grades g ON ss.student_id = g.student_id AND sub.subject_id = g.subject_id "
-            "WHERE ss.student_id = ?"
-        ));
-        pstmt->setInt(1, student_id);
+// Ar tekstas prasideda prefix (ASCII raidės lyginamos nepaisant dydžio, kaip DB)
+bool startsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+    if (prefix.size() > text.size()) return false;
+    for (std::size_t i = 0; i < prefix.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) != std::tolower(static_cast<unsigned char>(prefix[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
 
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+// Paieškos pagal pradžią forma sąrašo puslapio viršuje
+std::string pageSearchForm(const std::string& base_url, const PageRequest& page) {
+    return "<form method='GET' action='" + base_url + "'>"
+        "<input type='text' name='prefix' value='" + htmlEscape(page.prefix) + "' placeholder='Pavadinimo pradzia'>"
+        "<input type='hidden' name='limit' value='" + std::to_string(page.limit) + "'>"
+        "<button type='submit'>Ieskoti</button></form>";
+}
 
-        // Užpildome dalykų ir pažymių sąrašą
-        while (res->next()) {
-            std::string subject_name = res->getString("subject_name").c_str();
-            std::string grade = res->getString("grade").c_str();
-            subjects.push_back({ subject_name, grade });
-        }
+// Nuorodos į pirmą ir kitą puslapį; kitas puslapis prasideda po paskutinio parodyto ID
+std::string pageLinks(const std::string& base_url, const PageRequest& page, int last_id, bool has_more) {
+    std::string query = "limit=" + std::to_string(page.limit);
+    if (!page.prefix.empty()) {
+        query += "&prefix=" + urlEncode(page.prefix);
+    }
+    std::string html = "<p>";
+    if (page.after > 0) {
+        html += "<a href='" + base_url + "?" + query + "'>Pradzia</a>";
+    }
+    if (has_more) {
+        if (page.after > 0) html += " | ";
+        html += "<a href='" + base_url + "?after=" + std::to_string(last_id) + "&" + query + "'>Kitas puslapis</a>";
+    }
+    return html + "</p>";
+}
 
-        return true;
+// Vienas puslapis iš atmintyje laikomo, pagal ID surūšiuoto sąrašo.
+// matches(row) nusprendžia, ar eilutė atitinka prefix filtrą.
+template <typename Row, typename Matches>
+std::vector<Row> pageOf(const std::vector<Row>& rows, const PageRequest& page, Matches matches, bool& has_more) {
+    auto it = std::upper_bound(rows.begin(), rows.end(), page.after,
+        [](int after, const Row& row) { return after < std::get<0>(row); });
+    std::vector<Row> result;
+    has_more = false;
+    for (; it != rows.end(); ++it) {
+        if (!page.prefix.empty() && !matches(*it)) continue;
+        if (result.size() == page.limit) {
+            has_more = true;
+            break;
+        }
+        result.push_back(*it);
     }
+    return result;
+}
 
-};
-// Dėstytojo klasė (vaikas iš user klasės)
-class Teacher : public User {
+
+// Srautinis JSON rašytojas API atsakymams. Reikšmės iškart rašomos į išvesties buferį
+// (skaičiai per std::to_chars), be tarpinio crow::json::wvalue medžio kiekvienai eilutei.
+// Kableliai dedami automatiškai pagal atidarytų objektų/masyvų būseną.
+class JsonWriter {
 public:
-    Teacher(int id, const string& name, const string& surname)
-        : User(id, name, surname, "Destytojas") {}
-    // Funkcija gauti dėstytojo informaciją
-    static bool getTeacherInfo(int teacher_id, sql::Connection* con, std::string& name, std::string& surname) {
-        // Gauti dėstytojo vardą ir pavardę
-        std::unique_ptr<sql::PreparedStatement> teacherPstmt(con->prepareStatement(
-            "SELECT name, surname FROM teachers WHERE teacher_id = ?"
-        ));
-        teacherPstmt->setInt(1, teacher_id);
-        std::unique_ptr<sql::ResultSet> teacherRes(teacherPstmt->executeQuery());
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    JsonWriter& beginObject() { separate(); out_ += '{'; first_.push_back(true); return *this; }
+    JsonWriter& endObject() { out_ += '}'; first_.pop_back(); return *this; }
+    JsonWriter& beginArray() { separate(); out_ += '['; first_.push_back(true); return *this; }
+    JsonWriter& endArray() { out_ += ']'; first_.pop_back(); return *this; }
+
+    JsonWriter& key(std::string_view name) {
+        separate();
+        appendString(name);
+        out_ += ':';
+        after_key_ = true;
+        return *this;
+    }
 
-        if (teacherRes->next()) {
-            name = teacherRes->getString("name").c_str();
-            surname = teacherRes->getString("surname").c_str();
-            return true;
-        }
-        return false;
+    JsonWriter& string(std::string_view text) { separate(); appendString(text); return *this; }
+
+    JsonWriter& number(std::int64_t number) {
+        separate();
+        char buffer[24];
+        out_.append(buffer, std::to_chars(buffer, buffer + sizeof(buffer), number).ptr);
+        return *this;
     }
 
-    static bool getSubjects(int teacher_id, sql::Connection* con, std::vector<std::pair<int, std::string>>& subjects) {
-        // Gauti dėstytojui priskirtus dalykus
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT s.subject_id, s.subject_name "
-            "FROM teacher_subjects ts "
-            "JOIN subjects s ON ts.subject_id = s.subject_id "
-            "WHERE ts.teacher_id = ?"
-        ));
-        pstmt->setInt(1, teacher_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    JsonWriter& boolean(bool flag) { separate(); out_ += flag ? "true" : "false"; return *this; }
+    JsonWriter& null() { separate(); out_ += "null"; return *this; }
 
-        while (res->next()) {
-            int subject_id = res->getInt("subject_id");
-            std::string subject_name = res->getString("subject_name").c_str();
-            subjects.push_back({ subject_id, subject_name });
+private:
+    void separate() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (!first_.empty()) {
+            if (!first_.back()) {
+                out_ += ',';
+            }
+            first_.back() = false;
         }
-
-        return !subjects.empty();
     }
-    // Funkcija gauti dėstomo dalyko informaciją.
-    static bool getSubjectInfo(int subject_id, sql::Connection* con, std::string& subject_name) {
-        std::unique_ptr<sql::PreparedStatement> pstmt_subject(con->prepareStatement(
-            "SELECT subject_name FROM subjects WHERE subject_id = ?"));
-        pstmt_subject->setInt(1, subject_id);
-        std::unique_ptr<sql::ResultSet> res_subject(pstmt_subject->executeQuery());
 
-        if (res_subject->next()) {
-            subject_name = res_subject->getString("subject_name").c_str();
-            return true;
+    // Eilutė kabutėse; saugios atkarpos kopijuojamos visos iš karto
+    void appendString(std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        out_ += '"';
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            out_.append(text.data() + run, i - run);
+            run = i + 1;
+            switch (c) {
+            case '"': out_ += "\\\""; break;
+            case '\\': out_ += "\\\\"; break;
+            case '\n': out_ += "\\n"; break;
+            case '\r': out_ += "\\r"; break;
+            case '\t': out_ += "\\t"; break;
+            default:
+                out_ += "\\u00";
+                out_ += hex[c >> 4];
+                out_ += hex[c & 0xF];
+                break;
+            }
         }
-        return false;
+        out_.append(text.data() + run, text.size() - run);
+        out_ += '"';
     }
-    // Funkcija gauti studentus iš dėstomo dalyko.
-    static bool getStudentsForSubject(int subject_id, sql::Connection* con, std::string& students_html) {
-        std::unique_ptr<sql::PreparedStatement> pstmt_students(con->prepareStatement(
-            "SELECT DISTINCT s.student_id, s.name, s.surname, IFNULL(g.grade, 0) AS grade "
-            "FROM students s "
-            "JOIN students_subjects ss ON s.student_id = ss.student_id "
-            "JOIN group_subjects gs ON gs.subject_id = ss.subject_id "
-            "LEFT JOIN grades g ON s.student_id = g.student_id AND g.subject_id = ss.subject_id "
-            "WHERE ss.subject_id = ? AND s.group_id IS NOT NULL"));
-        pstmt_students->setInt(1, subject_id);
-        std::unique_ptr<sql::ResultSet> res_students(pstmt_students->executeQuery());
 
-        while (res_students->next()) {
-            int student_id = res_students->getInt("student_id");
-            std::string name = res_students->getString("name").c_str();
-            std::string surname = res_students->getString("surname").c_str();
-            int grade = res_students->getInt("grade");
+    std::string& out_;
+    std::vector<bool> first_;
+    bool after_key_ = false;
+};
 
-            students_html += "<tr>";
-            students_html += "<td>" + std::to_string(student_id) + "</td>";
-            students_html += "<td>" + name + "</td>";
-            students_html += "<td>" + surname + "</td>";
-            students_html += "<td>" + (grade == 0 ? "Nera" : std::to_string(grade)) + "</td>";
-            students_html += "</tr>";
-        }
+// JSON atsakymas iš jau paruošto teksto
+crow::response jsonResponse(int code, std::string body) {
+    crow::response res(code, std::move(body));
+    res.set_header("Content-Type", "application/json");
+    return res;
+}
 
-        return !students_html.empty();
+// Puslapiuoto sąrašo pabaiga: has_more ir next_after (kitos užklausos ?after= reikšmė)
+void writePageEnd(JsonWriter& json, int last_id, bool has_more) {
+    json.key("has_more").boolean(has_more);
+    json.key("next_after");
+    if (has_more) {
+        json.number(last_id);
     }
-    // Funkcija tikrinanti studentus iš DB.
-    static bool checkStudentExistence(int student_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT 1 FROM students WHERE student_id = ?"));
-        pstmt->setInt(1, student_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        return res->next();
+    else {
+        json.null();
     }
-    // Funkcija tikrinanti studentus ir dėstomus dalykus iš DB.
-    static bool checkStudentSubjectAssignment(int student_id, int subject_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT 1 FROM students_subjects WHERE student_id = ? AND subject_id = ?"));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, subject_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        return res->next();
+}
+
+// {"id":..,"name":..} eilučių masyvas
+void writeNamedRows(JsonWriter& json, const std::vector<std::tuple<int, std::string>>& rows) {
+    json.beginArray();
+    for (const auto& row : rows) {
+        json.beginObject();
+        json.key("id").number(std::get<0>(row));
+        json.key("name").string(std::get<1>(row));
+        json.endObject();
     }
-    // Funkcija tikrinanti studentų pažymius iš DB.
-    static bool checkStudentGradeExistence(int student_id, int subject_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT grade FROM grades WHERE student_id = ? AND subject_id = ?"));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, subject_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        return res->next();
+    json.endArray();
+}
+
+// {"id":..,"name":..,"surname":..} eilučių masyvas
+void writePersonRows(JsonWriter& json, const std::vector<std::tuple<int, std::string, std::string>>& rows) {
+    json.beginArray();
+    for (const auto& row : rows) {
+        json.beginObject();
+        json.key("id").number(std::get<0>(row));
+        json.key("name").string(std::get<1>(row));
+        json.key("surname").string(std::get<2>(row));
+        json.endObject();
     }
-    // Funkcija leidžianti pridėti studentui pažymį.
-    static bool addGrade(int student_id, int subject_id, int grade, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "INSERT INTO grades (student_id, subject_id, grade) VALUES (?, ?, ?)"));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, subject_id);
-        pstmt->setInt(3, grade);
-        pstmt->executeUpdate();
-        return true;
+    json.endArray();
+}
+
+// HDR stiliaus vėlinimo histograma (mikrosekundėmis): kiekvienas dvejeto laipsnis padalytas į 16 intervalų,
+// todėl santykinė paklaida ~6% nuo 1 us iki kelių parų, o atmintis pastovi.
+// Kiekviena gija rašo į savo skiltį (Shard) be užraktų ir be dalijamų talpyklos eilučių;
+// skiltys sujungiamos tik skaitant (snapshot), pvz. /metrics užklausoje.
+// Histogramos naikinamos tik baigiant programą - skilčių sąrašas tik auga.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBuckets = 16;
+    static constexpr int kMaxExponent = 36;  // ~19 val.; ilgesnės reikšmės patenka į paskutinį intervalą
+    static constexpr std::size_t kBuckets = (kMaxExponent - 3) * kSubBuckets;
+
+    struct Snapshot {
+        std::array<std::uint64_t, kBuckets> counts{};
+        std::uint64_t count = 0;
+        std::uint64_t sum_us = 0;
+
+        // Kiek reikšmių neviršija limit_us (intervalai, kurių viršutinė riba <= limit_us)
+        std::uint64_t countAtOrBelow(std::uint64_t limit_us) const {
+            std::uint64_t total = 0;
+            for (std::size_t i = 0; i < kBuckets && bucketUpper(i) <= limit_us + 1; ++i) {
+                total += counts[i];
+            }
+            return total;
+        }
+
+        void merge(const Snapshot& other) {
+            for (std::size_t i = 0; i < kBuckets; ++i) counts[i] += other.counts[i];
+            count += other.count;
+            sum_us += other.sum_us;
+        }
+    };
+
+    LatencyHistogram() : id_(next_id_.fetch_add(1, std::memory_order_relaxed)) {}
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        record(static_cast<std::uint64_t>(us < 0 ? 0 : us));
     }
-    // Funkcija leidžianti panaikinti studento pažymį.
-    static bool deleteGrade(int student_id, int subject_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "DELETE FROM grades WHERE student_id = ? AND subject_id = ?"));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, subject_id);
-        pstmt->executeUpdate();
-        return true;
+
+    void record(std::uint64_t us) {
+        Shard& shard = localShard();
+        // Skiltį rašo tik viena gija, todėl pakanka relaxed load + store (be atominio read-modify-write)
+        auto& bucket = shard.counts[bucketIndex(us)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        shard.sum_us.store(shard.sum_us.load(std::memory_order_relaxed) + us, std::memory_order_relaxed);
     }
-    // Funkcija skirta gauti pažymius.
-    static int getCurrentGrade(int student_id, int subject_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "SELECT grade FROM grades WHERE student_id = ? AND subject_id = ?"));
-        pstmt->setInt(1, student_id);
-        pstmt->setInt(2, subject_id);
-        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-        if (res->next()) {
-            return res->getInt("grade");
+
+    Snapshot snapshot() const {
+        Snapshot result;
+        for (const Shard* shard = head_.load(std::memory_order_acquire); shard; shard = shard->next) {
+            for (std::size_t i = 0; i < kBuckets; ++i) {
+                std::uint64_t n = shard->counts[i].load(std::memory_order_relaxed);
+                result.counts[i] += n;
+                result.count += n;
+            }
+            result.sum_us += shard->sum_us.load(std::memory_order_relaxed);
         }
-        return -1; // -1 reiškia, kad pažymio nėra
+        return result;
     }
-    // Funkcija leidžianti koreguoti studento pažymį.
-    static bool updateGrade(int student_id, int new_grade, int subject_id, sql::Connection* con) {
-        std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-            "UPDATE grades SET grade = ? WHERE student_id = ? AND subject_id = ?"));
-        pstmt->setInt(1, new_grade);
-        pstmt->setInt(2, student_id);
-        pstmt->setInt(3, subject_id);
-        pstmt->executeUpdate();
-        return true;
+
+    static std::size_t bucketIndex(std::uint64_t us) {
+        if (us < kSubBuckets) return static_cast<std::size_t>(us);
+        int exponent = 63;
+        while (!(us >> exponent)) --exponent;  // aukščiausias vienetinis bitas (>= 4)
+        if (exponent >= kMaxExponent) return kBuckets - 1;
+        return static_cast<std::size_t>((exponent - 3) * kSubBuckets + ((us >> (exponent - 4)) - kSubBuckets));
+    }
+
+    // Pirma reikšmė, kuri jau nepatenka į intervalą i
+    static std::uint64_t bucketUpper(std::size_t i) {
+        if (i < kSubBuckets) return i + 1;
+        std::size_t exponent = i / kSubBuckets + 3;
+        std::uint64_t step = std::uint64_t(1) << (exponent - 4);
+        return (kSubBuckets + i % kSubBuckets) * step + step;
+    }
+
+private:
+    struct Shard {
+        std::array<std::atomic<std::uint64_t>, kBuckets> counts{};
+        std::atomic<std::uint64_t> sum_us{ 0 };
+        Shard* next = nullptr;
+    };
+
+    Shard& localShard() {
+        // Gijos skilčių lentelė pagal histogramos id; nauja skiltis įterpiama į sąrašą CAS operacija
+        thread_local std::vector<Shard*> shards;
+        if (id_ >= shards.size()) shards.resize(id_ + 1, nullptr);
+        Shard*& shard = shards[id_];
+        if (!shard) {
+            shard = new Shard();
+            shard->next = head_.load(std::memory_order_relaxed);
+            while (!head_.compare_exchange_weak(shard->next, shard, std::memory_order_release, std::memory_order_relaxed)) {}
+        }
+        return *shard;
     }
 
+    inline static std::atomic<std::size_t> next_id_{ 0 };
+    std::size_t id_;
+    std::atomic<Shard*> head_{ nullptr };
 };
 
-// Admino klasė (vaikas iš user klasės)
-class Administrator : public User {
+// Prometheus tekstinio formato histograma su sekundžių ribomis (le) iš HDR histogramos
+void writePrometheusHistogram(std::string& out, const std::string& name, const std::string& labels,
+    const LatencyHistogram::Snapshot& snapshot) {
+    static const std::uint64_t bounds_us[] = { 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+        1000000, 2500000, 5000000, 10000000 };
+    static const char* const bounds_text[] = { "0.0005", "0.001", "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "0.5",
+        "1", "2.5", "5", "10" };
+    std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+    for (std::size_t i = 0; i < std::size(bounds_us); ++i) {
+        out += name + "_bucket" + prefix + "le=\"" + bounds_text[i] + "\"} " + std::to_string(snapshot.countAtOrBelow(bounds_us[i])) + "\n";
+    }
+    out += name + "_bucket" + prefix + "le=\"+Inf\"} " + std::to_string(snapshot.count) + "\n";
+    std::string label_block = labels.empty() ? "" : "{" + labels + "}";
+    char sum[32];
+    std::snprintf(sum, sizeof(sum), "%.6f", static_cast<double>(snapshot.sum_us) / 1e6);
+    out += name + "_sum" + label_block + " " + sum + "\n";
+    out += name + "_count" + label_block + " " + std::to_string(snapshot.count) + "\n";
+}
+
+void writePrometheusHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += std::string("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+}
+
+// Vienos užklausos fazių sekimas (tracing): eilė, ryšio gavimas, paruoštos užklausos, HTML piešimas, rašymas.
+// Intervalai renkami kiekvienai užklausai (tai tik keli laiko matavimai), o ją baigus nusprendžiama, ar
+// išsaugoti: visada išsaugomos lėtesnės nei slow_threshold, kitos - atsitiktinai su tikimybe sample_rate.
+// Išsaugoti trace'ai dedami į baigusios gijos žiedinį buferį, o /debug/traces juos išveda
+// Chrome trace-event JSON formatu (chrome://tracing, Perfetto).
+class Tracer {
 public:
-    Administrator(int id, const string& name, const string& surname)
-        : User(id, name, surname, "Administratorius") {}
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t kRingSize = 256;  // išsaugotų trace'ų vienoje gijoje
+
+    struct Span {
+        const char* name;  // tik statinis tekstas
+        Clock::time_point start;
+        Clock::time_point end;
+        std::uint32_t thread;
+    };
+
+    struct Trace {
+        std::uint64_t id = 0;
+        std::string method;
+        std::string url;
+        int status = 0;
+        bool sampled = false;
+        Clock::time_point start;
+        Clock::time_point end;
+
+        // Intervalus deda IO ir DB gijos - paeiliui, bet ne vienoje gijoje
+        void add(const char* name, Clock::time_point from, Clock::time_point to) {
+            std::lock_guard<std::mutex> lock(mutex);
+            spans.push_back({ name, from, to, threadIndex() });
+        }
 
-    // Pridėti studentą į duomenų bazę
-    std::string addStudentToDatabase(MySQLDatabase& db, const std::string& name, const std::string& surname) {
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                // Patikriname, ar studentas su tokiu vardu ir pavarde jau egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_student(
-                    con->prepareStatement("SELECT COUNT(*) FROM students WHERE name = ? AND surname = ?"));
-                pstmt_student->setString(1, name);
-                pstmt_student->setString(2, surname);
-                unique_ptr<sql::ResultSet> res_student(pstmt_student->executeQuery());
-                if (res_student->next() && res_student->getInt(1) > 0) {
-                    delete con;
-                    return "Studentas su tokiu vardu ir pavarde jau egzistuoja!";
-                }
+        mutable std::mutex mutex;  // skaitytojas (chromeTraceJson) laiko jį ir paskelbtam trace
+        std::vector<Span> spans;
+    };
 
-                // Patikriname, ar dėstytojas su tokiu vardu ir pavarde jau egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_teacher(
-                    con->prepareStatement("SELECT COUNT(*) FROM teachers WHERE name = ? AND surname = ?"));
-                pstmt_teacher->setString(1, name);
-                pstmt_teacher->setString(2, surname);
-                unique_ptr<sql::ResultSet> res_teacher(pstmt_teacher->executeQuery());
-                if (res_teacher->next() && res_teacher->getInt(1) > 0) {
-                    delete con;
-                    return "Su tokiu vardu ir pavarde jau egzistuoja destytojas!";
-                }
+    // Nustato gijos trace bloko trukmei (DB darbui ar IO gijos užbaigimui)
+    class Scope {
+    public:
+        explicit Scope(std::shared_ptr<Trace> trace) : previous_(std::move(current())) {
+            current() = std::move(trace);
+        }
+        ~Scope() { current() = std::move(previous_); }
 
-                // Pridėti studentą į duomenų bazę
-                unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                    "INSERT INTO students (name, surname, role, username, password) VALUES (?, ?, ?, ?, ?)"));
-                pstmt->setString(1, name);
-                pstmt->setString(2, surname);
-                pstmt->setString(3, "Studentas");  // rolė - Studentas
-                pstmt->setString(4, name.substr(0, 1) + name.substr(1));  // username (pirmoji vardo raidė)
-                pstmt->setString(5, surname);  // Slaptažodis = pavardė
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
 
-                pstmt->executeUpdate();
-                delete con;
-                return "Studentas pridetas sekmingai!";
-            }
-            catch (sql::SQLException& e) {
-                delete con;
-                return "Klaida uzklausoje: " + std::string(e.what());
-            }
+    private:
+        std::shared_ptr<Trace> previous_;
+    };
+
+    // Bloko trukmė kaip intervalas dabartiniame gijos trace; be trace nieko nedaro
+    class SpanTimer {
+    public:
+        explicit SpanTimer(const char* name) : trace_(current().get()), name_(name) {
+            if (trace_) start_ = Clock::now();
         }
-        else {
-            return "Nepavyko prisijungti prie duomenu bazes.";
+        ~SpanTimer() {
+            if (trace_) trace_->add(name_, start_, Clock::now());
         }
+
+        SpanTimer(const SpanTimer&) = delete;
+        SpanTimer& operator=(const SpanTimer&) = delete;
+
+    private:
+        Trace* trace_;
+        const char* name_;
+        Clock::time_point start_;
+    };
+
+    // sample_rate 0..1 - kokia dalis greitų užklausų išsaugoma; lėtesnės nei slow_threshold išsaugomos visada
+    static void configure(double sample_rate, std::chrono::microseconds slow_threshold) {
+        sample_per_million_.store(static_cast<std::uint32_t>(std::clamp(sample_rate, 0.0, 1.0) * 1e6), std::memory_order_relaxed);
+        slow_threshold_us_.store(slow_threshold.count(), std::memory_order_relaxed);
     }
 
-    // Pašalinti studentą pagal ID iš visų susijusių lentelių (iš DB)
-    std::string deleteStudentFromDatabase(MySQLDatabase& db, int student_id) {
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                // Patikriname, ar studentas egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_check(
-                    con->prepareStatement("SELECT COUNT(*) FROM students WHERE student_id = ?"));
-                pstmt_check->setInt(1, student_id);
-                unique_ptr<sql::ResultSet> res_check(pstmt_check->executeQuery());
-                if (res_check->next() && res_check->getInt(1) == 0) {
-                    delete con;
-                    return "Studentas su tokiu ID nerastas!";
-                }
-
-                // Pašaliname studentą iš grupės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_group(
-                    con->prepareStatement("DELETE FROM group_students WHERE student_id = ?"));
-                pstmt_delete_group->setInt(1, student_id);
-                pstmt_delete_group->executeUpdate();
-
-                // Pašaliname studentą iš dalyko
-                unique_ptr<sql::PreparedStatement> pstmt_delete_subject(
-                    con->prepareStatement("DELETE FROM students_subjects WHERE student_id = ?"));
-                pstmt_delete_subject->setInt(1, student_id);
-                pstmt_delete_subject->executeUpdate();
-
-                // Pašaliname studentą iš pažymių
-                unique_ptr<sql::PreparedStatement> pstmt_delete_grades(
-                    con->prepareStatement("DELETE FROM grades WHERE student_id = ?"));
-                pstmt_delete_grades->setInt(1, student_id);
-                pstmt_delete_grades->executeUpdate();
-
-                // Pašaliname studentą iš 'students' lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_student(
-                    con->prepareStatement("DELETE FROM students WHERE student_id = ?"));
-                pstmt_delete_student->setInt(1, student_id);
-                pstmt_delete_student->executeUpdate();
-
-                delete con;
-                return "Studentas pasalintas sekmingai!";
-            }
-            catch (sql::SQLException& e) {
-                delete con;
-                return "Klaida trinant studenta: " + std::string(e.what());
-            }
-        }
-        else {
-            return "Nepavyko prisijungti prie duomenu bazes.";
-        }
+    static std::shared_ptr<Trace> begin(std::string method, std::string url) {
+        auto trace = std::make_shared<Trace>();
+        trace->id = next_id_.fetch_add(1, std::memory_order_relaxed) + 1;
+        trace->method = std::move(method);
+        trace->url = std::move(url);
+        trace->start = Clock::now();
+        trace->spans.reserve(12);
+        // xorshift - pakankamai atsitiktinis atrankai ir be bendros būsenos tarp gijų
+        thread_local std::uint64_t random = [] {
+            std::uint64_t z = 0x9E3779B97F4A7C15ull * (threadIndex() + 1);  // splitmix64 sėkla pagal giją
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }();
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+        trace->sampled = random % 1000000 < sample_per_million_.load(std::memory_order_relaxed);
+        return trace;
     }
 
-    // Gauti visus studentus iš duomenų bazės
-    std::vector<std::tuple<int, std::string, std::string>> getAllStudents(sql::Connection* conn) {
-        std::vector<std::tuple<int, std::string, std::string>> students;
+    // Užbaigia trace ir, jei jis lėtas arba atrinktas, išsaugo šios gijos žiediniame buferyje
+    static void finish(const std::shared_ptr<Trace>& trace) {
+        trace->end = Clock::now();
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(trace->end - trace->start).count();
+        if (!trace->sampled && elapsed < slow_threshold_us_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        Ring& ring = localRing();
+        std::lock_guard<std::mutex> lock(ring.mutex);  // konkuruoja tik su retu /debug/traces
+        ring.traces[ring.next % kRingSize] = trace;
+        ++ring.next;
+    }
 
-        if (conn) {
-            try {
-                std::unique_ptr<sql::PreparedStatement> pstmt(
-                    conn->prepareStatement("SELECT student_id, name, surname FROM students")
-                );
-                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    static std::shared_ptr<Trace>& current() {
+        thread_local std::shared_ptr<Trace> trace;
+        return trace;
+    }
 
-                while (res->next()) {
-                    int student_id = res->getInt("student_id");
-                    std::string name = res->getString("name").c_str();
-                    std::string surname = res->getString("surname").c_str();
+    // Mažas, stabilus gijos numeris trace-event "tid" laukui
+    static std::uint32_t threadIndex() {
+        static std::atomic<std::uint32_t> next{ 0 };
+        thread_local std::uint32_t index = ++next;
+        return index;
+    }
 
-                    students.push_back(std::make_tuple(student_id, name, surname));
+    // Visi išsaugoti trace'ai: kiekviena užklausa - atskira eilutė (tid = trace id), gija - args.thread
+    static std::string chromeTraceJson() {
+        std::vector<std::shared_ptr<const Trace>> traces;
+        {
+            std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+            for (const std::shared_ptr<Ring>& ring : rings_) {
+                std::lock_guard<std::mutex> lock(ring->mutex);
+                for (const std::shared_ptr<const Trace>& trace : ring->traces) {
+                    if (trace) traces.push_back(trace);
                 }
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida užklausoje: " << e.what() << std::endl;
-            }
         }
-        else {
-            std::cerr << "Nepavyko prisijungti prie duomenų bazės!" << std::endl;
+        std::sort(traces.begin(), traces.end(),
+            [](const std::shared_ptr<const Trace>& a, const std::shared_ptr<const Trace>& b) { return a->start < b->start; });
+
+        auto micros = [](Clock::time_point point) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(point.time_since_epoch()).count();
+        };
+
+        std::string out;
+        out.reserve(256 + traces.size() * 1024);
+        JsonWriter json(out);
+        json.beginObject();
+        json.key("displayTimeUnit").string("ms");
+        json.key("traceEvents").beginArray();
+        for (const std::shared_ptr<const Trace>& trace : traces) {
+            json.beginObject();
+            json.key("name").string(trace->method + " " + trace->url);
+            json.key("cat").string("request");
+            json.key("ph").string("X");
+            json.key("ts").number(micros(trace->start));
+            json.key("dur").number(micros(trace->end) - micros(trace->start));
+            json.key("pid").number(1);
+            json.key("tid").number(static_cast<std::int64_t>(trace->id));
+            json.key("args").beginObject();
+            json.key("status").number(trace->status);
+            json.key("sampled").boolean(trace->sampled);
+            json.endObject();
+            json.endObject();
+
+            // Srautiniam atsakymui DB gija dar gali pridėti intervalą ir po paskelbimo, todėl kopijuojame su užraktu
+            std::vector<Span> spans;
+            {
+                std::lock_guard<std::mutex> lock(trace->mutex);
+                spans = trace->spans;
+            }
+            for (const Span& span : spans) {
+                json.beginObject();
+                json.key("name").string(span.name);
+                json.key("cat").string("phase");
+                json.key("ph").string("X");
+                json.key("ts").number(micros(span.start));
+                json.key("dur").number(micros(span.end) - micros(span.start));
+                json.key("pid").number(1);
+                json.key("tid").number(static_cast<std::int64_t>(trace->id));
+                json.key("args").beginObject();
+                json.key("thread").number(span.thread);
+                json.endObject();
+                json.endObject();
+            }
         }
+        json.endArray();
+        json.endObject();
+        return out;
+    }
 
-        return students;
+private:
+    struct Ring {
+        std::mutex mutex;
+        std::array<std::shared_ptr<const Trace>, kRingSize> traces;
+        std::size_t next = 0;
+    };
+
+    static Ring& localRing() {
+        // Žiedas gyvena ir gijai pasibaigus, kad jos trace'ai liktų matomi
+        thread_local std::shared_ptr<Ring> ring = [] {
+            auto created = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lock(rings_mutex_);
+            rings_.push_back(created);
+            return created;
+        }();
+        return *ring;
     }
 
+    inline static std::atomic<std::uint32_t> sample_per_million_{ 0 };
+    inline static std::atomic<std::int64_t> slow_threshold_us_{ 250000 };
+    inline static std::atomic<std::uint64_t> next_id_{ 0 };
+    inline static std::mutex rings_mutex_;
+    inline static std::vector<std::shared_ptr<Ring>> rings_;
+};
 
-    // Pridėti dėstytoją į duomenų bazę
-    std::string addTeacherToDatabase(MySQLDatabase& db, const std::string& name, const std::string& surname) {
-        sql::Connection* con = db.connect();
-        if (!con) {
-            return "Klaida: nepavyko prisijungti prie duomenų bazės.";
-        }
 
-        try {
-            // Patikrinti, ar dėstytojas jau egzistuoja
-            unique_ptr<sql::PreparedStatement> checkTeacherStmt(
-                con->prepareStatement("SELECT COUNT(*) FROM teachers WHERE name = ? AND surname = ?")
-            );
-            checkTeacherStmt->setString(1, name);
-            checkTeacherStmt->setString(2, surname);
-            unique_ptr<sql::ResultSet> teacherRes(checkTeacherStmt->executeQuery());
-            if (teacherRes->next() && teacherRes->getInt(1) > 0) {
-                delete con;
-                return "Dėstytojas jau egzistuoja: " + name + " " + surname;
-            }
+class User {
+public:
+    // Konstuktorius
+    User(int id, const string& name, const string& surname, const string& role)
+        : id_(id), name_(name), surname_(surname), role_(role) {
+        // Sukuriame prisijungimo vardą.
+        username_ = string(1, tolower(name_[0])) + name_.substr(1);
+        // Sukuriame slaptažodį: pavardė
+        password_ = surname_;
+    }
 
-            // Patikrinti, ar studentas jau egzistuoja su tokiu pačiu vardu ir pavarde
-            unique_ptr<sql::PreparedStatement> checkStudentStmt(
-                con->prepareStatement("SELECT COUNT(*) FROM students WHERE name = ? AND surname = ?")
-            );
-            checkStudentStmt->setString(1, name);
-            checkStudentStmt->setString(2, surname);
-            unique_ptr<sql::ResultSet> studentRes(checkStudentStmt->executeQuery());
-            if (studentRes->next() && studentRes->getInt(1) > 0) {
-                delete con;
-                return "Studentas su tokiu vardu ir pavarde jau egzistuoja: " + name + " " + surname;
-            }
+    // Getter'iai
+    int getId() const { return id_; }
+    string getName() const { return name_; }
+    string getSurname() const { return surname_; }
+    string getRole() const { return role_; }
+    string getUsername() const { return username_; }
+    string getPassword() const { return password_; }
 
-            // Pridėti naują dėstytoją
-            unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                "INSERT INTO teachers (name, surname, role, username, password) VALUES (?, ?, ?, ?, ?)"));
-            pstmt->setString(1, name);
-            pstmt->setString(2, surname);
-            pstmt->setString(3, "Destytojas");  // Rolė - Studentas
-            pstmt->setString(4, name.substr(0, 1) + name.substr(1));  // username (pirmoji vardo raidė)
-            pstmt->setString(5, surname);  // Slaptažodis = pavardė
+private:
+    int id_;
+    string name_;
+    string surname_;
+    string role_;
+    string username_;
+    string password_;
+};
 
-            pstmt->executeUpdate();
-            delete con;
-            return "Destytojas pridėtas sėkmingai!";
+// Paruoštų užklausų (prepared statement) talpykla vienam ryšiui.
+// Raktas - SQL tekstas, o seniausiai naudotos užklausos išmetamos (LRU), kai viršijama talpa.
+// Išmetimas atidedamas iki trim(), kurį telkinys kviečia grąžinant ryšį: kol ryšys išnuomotas,
+// iš jo užklausų gali būti atidarytų ResultSet, o sunaikinus užklausą jie taptų negaliojantys.
+class StatementCache {
+public:
+    explicit StatementCache(std::size_t capacity) : capacity_(capacity) {}
+
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+
+    // Grąžina jau paruoštą užklausą arba ją paruošia (vienas papildomas kelias iki serverio tik pirmą kartą)
+    sql::PreparedStatement* get(sql::Connection& con, const std::string& sql, bool& hit) {
+        auto it = index_.find(std::string_view(sql));
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);  // Perkeliame į pradžią - naujausiai naudota
+            ++hits_;
+            hit = true;
+            return entries_.front().statement.get();
         }
-        catch (sql::SQLException& e) {
-            delete con;
-            return "Klaida pridedant dėstytoją: " + std::string(e.what());
+
+        std::unique_ptr<sql::PreparedStatement> statement(con.prepareStatement(sql));
+        entries_.push_front(Entry{ sql, std::move(statement) });
+        index_.emplace(std::string_view(entries_.front().sql), entries_.begin());
+        ++misses_;
+        hit = false;
+        return entries_.front().statement.get();
+    }
+
+    // Išmeta seniausiai naudotas užklausas virš talpos. Kviesti tik kai nė vienas ResultSet nebeatidarytas.
+    void trim() {
+        while (entries_.size() > capacity_) {
+            index_.erase(std::string_view(entries_.back().sql));
+            entries_.pop_back();
         }
     }
 
-    // Metodas, kuris patikrina, ar dėstytojas egzistuoja ir pašalina jį, (jei taip)
-    std::string removeTeacherFromDatabase(MySQLDatabase& db, int teacher_id) {
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                // Patikriname, ar dėstytojas egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_check(
-                    con->prepareStatement("SELECT COUNT(*) FROM teachers WHERE teacher_id = ?"));
-                pstmt_check->setInt(1, teacher_id);
-                unique_ptr<sql::ResultSet> res(pstmt_check->executeQuery());
-                if (res->next() && res->getInt(1) == 0) {
-                    delete con;
-                    return "Destytojas su tokiu ID nerastas!";
-                }
-
-                // Pirmiausia pašaliname visus priskyrimus į teacher_subjects lentelę
-                unique_ptr<sql::PreparedStatement> pstmt_delete_teacher_subjects(
-                    con->prepareStatement("DELETE FROM teacher_subjects WHERE teacher_id = ?")
-                );
-                pstmt_delete_teacher_subjects->setInt(1, teacher_id);
-                pstmt_delete_teacher_subjects->executeUpdate();
+    // Išvalo talpyklą (pvz., po reset(), kai serveris pamiršta paruoštas užklausas)
+    void clear() {
+        index_.clear();
+        entries_.clear();
+    }
 
-                // Pašaliname dėstytoją iš teachers lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_teacher(
-                    con->prepareStatement("DELETE FROM teachers WHERE teacher_id = ?")
-                );
-                pstmt_delete_teacher->setInt(1, teacher_id);
-                pstmt_delete_teacher->executeUpdate();
+    std::size_t size() const { return entries_.size(); }
+    std::uint64_t hits() const { return hits_; }
+    std::uint64_t misses() const { return misses_; }
 
-                delete con;
-                return "Destytojas pasalintas sekmingai!";
-            }
-            catch (sql::SQLException& e) {
-                delete con;
-                return "Klaida trinant destytoja: " + std::string(e.what());
-            }
+private:
+    struct Entry {
+        std::string sql;
+        std::unique_ptr<sql::PreparedStatement> statement;
+    };
+
+    std::size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index_;  // Raktai rodo į Entry::sql
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+// Neseniai patvirtintų prisijungimų talpykla su trumpu galiojimo laiku (TTL).
+// Slaptažodis nelaikomas atvirai - saugome tik jo SHA1 maišą.
+class LoginCache {
+public:
+    LoginCache(std::chrono::seconds ttl, std::size_t max_entries)
+        : ttl_(ttl), max_entries_(max_entries) {}
+
+    bool find(const std::string& username, const std::string& password, std::pair<std::string, int>& user) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(username);
+        if (it == entries_.end()) {
+            return false;
         }
-        else {
-            return "Nepavyko prisijungti prie duomenų bazės.";
+        if (std::chrono::steady_clock::now() >= it->second.expires) {
+            entries_.erase(it);
+            return false;
+        }
+        if (it->second.digest != digest(password)) {
+            return false;
         }
+        user = { it->second.role, it->second.id };
+        return true;
     }
-        
-    
-        
-    // Randame dėstytojų info iš DB.
-    std::vector<std::tuple<int, std::string, std::string>> getAllTeachers(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string, std::string>> teachers;
-
-        try {
-            unique_ptr<sql::PreparedStatement> pstmt(
-                con->prepareStatement("SELECT teacher_id, name, surname FROM teachers")
-            );
-            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-            while (res->next()) {
-                int teacher_id = res->getInt("teacher_id");
-                std::string name = res->getString("name").c_str();
-                std::string surname = res->getString("surname").c_str();
 
-                teachers.emplace_back(teacher_id, name, surname);
+    void store(const std::string& username, const std::string& password, const std::pair<std::string, int>& user) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() >= max_entries_) {
+            // Pirmiausia išmetame pasenusius įrašus, o jei to neužtenka - pradedame iš naujo
+            for (auto it = entries_.begin(); it != entries_.end();) {
+                it = now >= it->second.expires ? entries_.erase(it) : std::next(it);
+            }
+            if (entries_.size() >= max_entries_) {
+                entries_.clear();
             }
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "Klaida gaunant dėstytojus: " << e.what() << std::endl;
-        }
+        entries_[username] = Entry{ digest(password), user.first, user.second, now + ttl_ };
+    }
 
-        return teachers;
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
     }
 
-    // Pridėti dėstytoją į duomenų bazę
-    std::string addSubjectToDatabase(MySQLDatabase& db, const std::string& subject_name) {
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                // Patikrinimas, ar toks dalykas jau egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_check(
-                    con->prepareStatement("SELECT COUNT(*) FROM subjects WHERE subject_name = ?")
-                );
-                pstmt_check->setString(1, subject_name);
-                unique_ptr<sql::ResultSet> res_check(pstmt_check->executeQuery());
+private:
+    using Digest = std::array<std::uint32_t, 5>;
+
+    struct Entry {
+        Digest digest;
+        std::string role;
+        int id;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    static Digest digest(const std::string& password) {
+        sha1::SHA1 hasher;
+        hasher.processBytes(password.data(), password.size());
+        Digest result;
+        hasher.getDigest(result.data());
+        return result;
+    }
 
-                if (res_check->next() && res_check->getInt(1) > 0) {
-                    // Jei dalykas jau egzistuoja
-                    return "Toks dalykas jau egzistuoja!";  // Pranešimas apie klaidą
-                }
+    std::chrono::seconds ttl_;
+    std::size_t max_entries_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+};
 
-                // Jei dalykas neegzistuoja, pridedame į duomenų bazę
-                unique_ptr<sql::PreparedStatement> pstmt_insert(
-                    con->prepareStatement("INSERT INTO subjects (subject_name) VALUES (?)")
-                );
-                pstmt_insert->setString(1, subject_name);
-                pstmt_insert->executeUpdate();
+class MySQLDatabase {
+public:
+    // Ryšių telkinio (pool) nustatymai
+    struct PoolConfig {
+        std::size_t min_size = 2;                           // Tiek ryšių paliekame net ir neveikiant
+        std::size_t max_size = 16;                          // Daugiau ryšių nei tiek neatidarome
+        std::chrono::seconds idle_timeout{ 300 };           // Nenaudojamas ilgiau ryšys uždaromas (jei viršijamas min_size)
+        std::chrono::milliseconds wait_timeout{ 3000 };     // Kiek ilgiausiai laukiame laisvo ryšio
+        std::chrono::seconds validate_after{ 30 };          // Po tiek laiko neveiklumo ryšį tikriname isValid()
+        std::size_t statement_cache_size = 64;              // Kiek paruoštų užklausų laikome kiekvienam ryšiui
+        std::chrono::seconds login_cache_ttl{ 30 };         // Kiek laiko tikime neseniai patvirtintu prisijungimu
+        std::size_t login_cache_size = 4096;                // Daugiausiai tiek prisijungimų laikome atmintyje
+    };
+
+    // Visų ryšių paruoštų užklausų talpyklos statistika
+    struct StatementCacheStats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
 
-                return "Dalykas pridėtas sėkmingai!";  // Sėkmės pranešimas
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida įrašant dalyką: " << e.what() << std::endl;
-                return "Įvyko klaida pridedant dalyką į duomenų bazę.";  // Klaidos pranešimas
+private:
+    // Vienas telkinio ryšys kartu su jo paruoštomis užklausomis ir paskutinio panaudojimo laiku.
+    // Laukų tvarka svarbi: užklausos sunaikinamos anksčiau už ryšį.
+    struct PooledConnection {
+        PooledConnection(std::unique_ptr<sql::Connection> connection, std::size_t cache_size)
+            : con(std::move(connection)), statements(cache_size), last_used(std::chrono::steady_clock::now()) {}
+
+        std::unique_ptr<sql::Connection> con;
+        StatementCache statements;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+public:
+    // RAII ryšio nuoma: išėjus iš matomumo srities ryšys automatiškai grąžinamas į telkinį
+    class ConnectionLease {
+    public:
+        ConnectionLease() = default;
+        ConnectionLease(MySQLDatabase* owner, std::unique_ptr<PooledConnection> pooled)
+            : owner_(owner), pooled_(std::move(pooled)), acquired_(std::chrono::steady_clock::now()) {}
+
+        ConnectionLease(const ConnectionLease&) = delete;
+        ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+        ConnectionLease(ConnectionLease&& other) noexcept
+            : owner_(other.owner_), pooled_(std::move(other.pooled_)), acquired_(other.acquired_) {
+            other.owner_ = nullptr;
+        }
+
+        ConnectionLease& operator=(ConnectionLease&& other) noexcept {
+            if (this != &other) {
+                release();
+                owner_ = other.owner_;
+                pooled_ = std::move(other.pooled_);
+                acquired_ = other.acquired_;
+                other.owner_ = nullptr;
             }
+            return *this;
         }
-        else {
-            return "Nepavyko prisijungti prie duomenų bazės.";  // Klaida dėl ryšio su DB
+
+        ~ConnectionLease() { release(); }
+
+        sql::Connection* get() const { return pooled_ ? pooled_->con.get() : nullptr; }
+        sql::Connection* operator->() const { return get(); }
+        explicit operator bool() const { return get() != nullptr; }
+
+        // Grąžina šio ryšio talpykloje laikomą paruoštą užklausą. Užklausa priklauso talpyklai - jos netriname.
+        // Rodyklė galioja, kol laikomas šis lease; iš jos gauti ResultSet turi būti uždaryti anksčiau už lease.
+        sql::PreparedStatement* prepare(const std::string& sql) {
+            bool hit = false;
+            auto start = std::chrono::steady_clock::now();
+            sql::PreparedStatement* statement = pooled_->statements.get(*pooled_->con, sql, hit);
+            (hit ? owner_->statement_hits_ : owner_->statement_misses_).fetch_add(1, std::memory_order_relaxed);
+            // Į trace patenka tik tikras paruošimas serveryje; talpyklos pataikymai trunka nanosekundes
+            if (!hit && Tracer::current()) {
+                Tracer::current()->add("db.prepare", start, std::chrono::steady_clock::now());
+            }
+            return statement;
         }
-    }
-    // Ištrinti dėstomą dalyką iš DB.
-    std::string deleteSubjectFromDatabase(MySQLDatabase& db, int subject_id) {
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                // 1. Patikrinimas, ar dalykas egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_check(
-                    con->prepareStatement("SELECT COUNT(*) FROM subjects WHERE subject_id = ?")
-                );
-                pstmt_check->setInt(1, subject_id);
-                unique_ptr<sql::ResultSet> res_check(pstmt_check->executeQuery());
 
-                if (res_check->next() && res_check->getInt(1) == 0) {
-                    return "Dalykas su ID " + std::to_string(subject_id) + " nerastas.";
+    private:
+        void release() {
+            if (owner_ && pooled_) {
+                auto now = std::chrono::steady_clock::now();
+                owner_->lease_time_.record(now - acquired_);
+                if (Tracer::current()) {
+                    Tracer::current()->add("db.lease", acquired_, now);
                 }
+                owner_->release(std::move(pooled_));
+            }
+            owner_ = nullptr;
+        }
 
-                // 2. Pašaliname įrašus iš `grades` lentelės, susijusius su šiuo `subject_id`
-                unique_ptr<sql::PreparedStatement> pstmt_delete_grades(
-                    con->prepareStatement("DELETE FROM grades WHERE subject_id = ?")
-                );
-                pstmt_delete_grades->setInt(1, subject_id);
-                pstmt_delete_grades->executeUpdate();
-
-                // 3. Pašaliname įrašus iš `group_subjects` lentelės, susijusius su šiuo `subject_id`
-                unique_ptr<sql::PreparedStatement> pstmt_delete_group_subjects(
-                    con->prepareStatement("DELETE FROM group_subjects WHERE subject_id = ?")
-                );
-                pstmt_delete_group_subjects->setInt(1, subject_id);
-                pstmt_delete_group_subjects->executeUpdate();
-
-                // 4. Pašaliname įrašus iš `students_subjects` lentelės, susijusius su šiuo `subject_id`
-                unique_ptr<sql::PreparedStatement> pstmt_delete_students_subjects(
-                    con->prepareStatement("DELETE FROM students_subjects WHERE subject_id = ?")
-                );
-                pstmt_delete_students_subjects->setInt(1, subject_id);
-                pstmt_delete_students_subjects->executeUpdate();
+        MySQLDatabase* owner_ = nullptr;
+        std::unique_ptr<PooledConnection> pooled_;
+        std::chrono::steady_clock::time_point acquired_;
+    };
 
-                // 5. Pašaliname įrašus iš `teacher_subjects` lentelės, susijusius su šiuo `subject_id`
-                unique_ptr<sql::PreparedStatement> pstmt_delete_teacher_subjects(
-                    con->prepareStatement("DELETE FROM teacher_subjects WHERE subject_id = ?")
-                );
-                pstmt_delete_teacher_subjects->setInt(1, subject_id);
-                pstmt_delete_teacher_subjects->executeUpdate();
+    MySQLDatabase(const std::string& host, const std::string& user, const std::string& password, const std::string& db)
+        : MySQLDatabase(host, user, password, db, PoolConfig()) {}
 
-                // 6. Pašaliname dalyką iš `subjects` lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_subject(
-                    con->prepareStatement("DELETE FROM subjects WHERE subject_id = ?")
-                );
-                pstmt_delete_subject->setInt(1, subject_id);
-                pstmt_delete_subject->executeUpdate();
+    MySQLDatabase(const std::string& host, const std::string& user, const std::string& password, const std::string& db,
+        const PoolConfig& config)
+        : host_(host), user_(user), password_(password), db_(db), config_(config),
+          login_cache_(config.login_cache_ttl, config.login_cache_size) {}
 
-                // 7. Jei viskas sėkmingai atlikta, grąžiname pranešimą apie sėkmingą pašalinimą
-                return "Dalykas su ID " + std::to_string(subject_id) + " pašalintas sėkmingai.";
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida trinant dalyką: " << e.what() << std::endl;
-                return "Įvyko klaida trinant dalyką: " + std::string(e.what());
-            }
-        }
-        else {
-            return "Nepavyko prisijungti prie duomenų bazės.";
+    // Funkcija, kuri tikrina vartotoją pagal username ir password, ir grąžina vartotojo vaidmenį bei ID.
+    // Visos trys lentelės tikrinamos viena užklausa, o neseniai patvirtinti prisijungimai imami iš atminties.
+    std::pair<std::string, int> validateUser(const std::string& username, const std::string& password) {
+        std::pair<std::string, int> cached;
+        if (login_cache_.find(username, password, cached)) {
+            return cached;
         }
-    }
-    // Gauname visus dėstomus dalykus iš DB.
-    std::vector<std::tuple<int, std::string>> getSubjectsFromDatabase(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string>> subjects;
 
+        ConnectionLease con = acquire();
         if (con) {
             try {
-                unique_ptr<sql::PreparedStatement> pstmt(
-                    con->prepareStatement("SELECT subject_id, subject_name FROM subjects")
-                );
-                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-                // Įkrauname duomenis į vektorių
-                while (res->next()) {
-                    int subject_id = res->getInt("subject_id");
-                    std::string subject_name = res->getString("subject_name").c_str();
-
-                    // Pridedame tuple į vektorių
-                    subjects.push_back(std::make_tuple(subject_id, subject_name));
+                // priority užtikrina tą pačią tvarką kaip anksčiau: studentai, dėstytojai, administratoriai
+                sql::PreparedStatement* pstmt = con.prepare(
+                    "SELECT role, id FROM ("
+                    "SELECT 1 AS priority, 'Studentas' AS role, student_id AS id FROM students WHERE username = ? AND password = ? "
+                    "UNION ALL "
+                    "SELECT 2, 'Destytojas', teacher_id FROM teachers WHERE username = ? AND password = ? "
+                    "UNION ALL "
+                    "SELECT 3, 'Administratorius', -1 FROM administrator WHERE username = ? AND password = ?"
+                    ") AS credentials ORDER BY priority LIMIT 1");
+                for (int i = 0; i < 3; ++i) {
+                    pstmt->setString(2 * i + 1, username);
+                    pstmt->setString(2 * i + 2, password);
+                }
+                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+                if (res->next()) {
+                    // Administratoriams grąžinamas -1, nes jie neturi `student_id` ar `teacher_id`
+                    std::pair<std::string, int> user{ res->getString("role").c_str(), res->getInt("id") };
+                    login_cache_.store(username, password, user);
+                    return user;
                 }
             }
             catch (sql::SQLException& e) {
-                std::cerr << "Klaida užklausoje: " << e.what() << std::endl;
+                CROW_LOG_ERROR << "Klaida tikrinant vartotoją: " << e.what();
             }
         }
-        else {
-            std::cerr << "Nepavyko prisijungti prie duomenų bazės!" << std::endl;
+        return { "", -1 };  // Jei vartotojas nerastas, grąžinsime tuščią rolę ir klaidingą ID
+    }
+
+    // Lentelės, kurių pakeitimus sekame versijų skaitikliais (atmintyje laikomoms talpykloms).
+    // GroupSubjects ir TeacherSubjects - priskyrimų lentelės; grupės narystė keičia students.group_id.
+    enum class Table { Students, Teachers, Subjects, Groups, GroupSubjects, TeacherSubjects, Grades, Count };
+
+    std::uint64_t tableVersion(Table table) const {
+        return table_versions_[static_cast<std::size_t>(table)].load(std::memory_order_acquire);
+    }
+
+    // Kviečiama po sėkmingo pakeitimo: duomenys, sukurti pagal senesnę versiją, bus perkrauti
+    void touch(Table table) {
+        table_versions_[static_cast<std::size_t>(table)].fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // Kelių lentelių bendra versija. Skaitikliai tik didėja, todėl suma pasikeičia pasikeitus bet kuriai lentelei.
+    std::uint64_t tablesVersion(std::initializer_list<Table> tables) const {
+        std::uint64_t version = 0;
+        for (Table table : tables) {
+            version += tableVersion(table);
         }
+        return version;
+    }
 
-        return subjects;  // Grąžiname vektorių su dalykais
+    // Vieno studento duomenų (pažymių, priskirtų dalykų) versija ETag'ams. Skaitikliai suskirstyti
+    // į kStudentStripes juostų pagal ID - sutapus juostai ETag tik be reikalo pasikeičia.
+    std::uint64_t studentVersion(int student_id) const {
+        return student_versions_[static_cast<std::size_t>(student_id) % kStudentStripes].load(std::memory_order_acquire);
     }
 
-    // Pridėjimo grupės funkcija (gavimas duomenų iš db). 
-    std::string addGroupToDatabase(MySQLDatabase& db, const std::string& group_name) {
-        sql::Connection* con = db.connect();
-        bool group_exists = false;
-        std::string response_body;
+    void touchStudent(int student_id) {
+        student_versions_[static_cast<std::size_t>(student_id) % kStudentStripes].fetch_add(1, std::memory_order_acq_rel);
+    }
 
-        try {
-            // Patikriname, ar grupė jau egzistuoja
-            unique_ptr<sql::PreparedStatement> pstmt(
-                con->prepareStatement("SELECT COUNT(*) FROM stud_groups WHERE group_name = ?")
-            );
-            pstmt->setString(1, group_name);
-            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-            if (res->next() && res->getInt(1) > 0) {
-                group_exists = true;
-            }
+    // Po pažymio pakeitimo: keičiasi ir pažymių lentelė, ir to studento puslapis
+    void touchGrades(int student_id) {
+        touch(Table::Grades);
+        touchStudent(student_id);
+    }
+
+    // Išvalo prisijungimų talpyklą (kviečiama pašalinus studentą ar dėstytoją)
+    void invalidateLoginCache() {
+        login_cache_.clear();
+    }
+
+    // Funkcija, kad suskaidytume POST užklausą į parametrus (prisijungimui)
+    void parseLoginData(const std::string& body, std::string& username, std::string& password) {
+        FormData form(body);
+        if (std::optional<std::string_view> value = form.get("username")) {
+            username.assign(value->begin(), value->end());
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "Klaida užklausoje: " << e.what() << std::endl;
+        if (std::optional<std::string_view> value = form.get("password")) {
+            password.assign(value->begin(), value->end());
         }
+    }
 
-        if (group_exists) {
-            // Jei grupė jau egzistuoja
-            response_body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
-                "Tokia grupe jau egzistuoja! "
-                "<br></body></html>";
+    StatementCacheStats statementCacheStats() const {
+        return { statement_hits_.load(std::memory_order_relaxed), statement_misses_.load(std::memory_order_relaxed) };
+    }
+
+    // Ar įdiegta sql/001_cascade_deletes.sql migracija (visi jos išoriniai raktai su ON DELETE taisykle).
+    // Tikrinama vieną kartą; įdiegus migraciją serverį reikia paleisti iš naujo.
+    bool hasCascadeForeignKeys(ConnectionLease& con) {
+        int state = cascade_state_.load(std::memory_order_acquire);
+        if (state >= 0) {
+            return state == 1;
         }
-        else {
-            // Jei grupė neegzistuoja, pridedame ją į duomenų bazę
-            try {
-                unique_ptr<sql::PreparedStatement> pstmt_insert(
-                    con->prepareStatement("INSERT INTO stud_groups (group_name) VALUES (?)")
-                );
-                pstmt_insert->setString(1, group_name);
-                pstmt_insert->executeUpdate();
 
-                response_body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
-                    "Grupe prideta sekmingai! "
-                    "<br></body></html>";
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida uzklausoje irasant grupe: " << e.what() << std::endl;
-                response_body = "<html><body>Klaida pridedant grupe.</body></html>";
-            }
+        static const char* const constraints[] = {
+            "fk_grades_student", "fk_grades_subject",
+            "fk_students_subjects_student", "fk_students_subjects_subject",
+            "fk_group_students_student", "fk_group_students_group",
+            "fk_group_subjects_group", "fk_group_subjects_subject",
+            "fk_teacher_subjects_teacher", "fk_teacher_subjects_subject",
+            "fk_students_group",
+        };
+        const std::size_t expected = sizeof(constraints) / sizeof(constraints[0]);
+
+        std::string sql = "SELECT COUNT(*) FROM information_schema.REFERENTIAL_CONSTRAINTS "
+            "WHERE CONSTRAINT_SCHEMA = DATABASE() AND DELETE_RULE IN ('CASCADE', 'SET NULL') "
+            "AND CONSTRAINT_NAME IN (";
+        for (std::size_t i = 0; i < expected; ++i) {
+            sql += i == 0 ? "'" : ", '";
+            sql += constraints[i];
+            sql += "'";
         }
+        sql += ")";
 
-        return response_body;
+        try {
+            std::unique_ptr<sql::Statement> stmt(con->createStatement());
+            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery(sql));
+            bool present = res->next() && static_cast<std::size_t>(res->getInt(1)) == expected;
+            cascade_state_.store(present ? 1 : 0, std::memory_order_release);
+            return present;
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Nepavyko patikrinti isoriniu raktu: " << e.what();
+            return false;
+        }
     }
-    // Metodas panaikinti grupes iš DB.
-    std::string removeGroupFromDatabase(MySQLDatabase& db, int group_id) {
-        sql::Connection* con = db.connect();
-        std::string result_message;
 
-        if (con) {
-            try {
-                // 1. Patikriname, ar grupė su nurodytu ID egzistuoja
-                unique_ptr<sql::PreparedStatement> pstmt_check(
-                    con->prepareStatement("SELECT COUNT(*) FROM stud_groups WHERE group_id = ?")
-                );
-                pstmt_check->setInt(1, group_id);
-                unique_ptr<sql::ResultSet> res(pstmt_check->executeQuery());
+    // Išnuomoja ryšį iš telkinio. Jei per wait_timeout laisvo ryšio negauname, grąžiname tuščią nuomą.
+    ConnectionLease acquire() {
+        Tracer::SpanTimer span("db.acquire");
+        const auto start = std::chrono::steady_clock::now();
+        ConnectionLease lease = acquireLease();
+        pool_wait_.record(std::chrono::steady_clock::now() - start);
+        return lease;
+    }
+
+    // Laukimas telkinyje (įskaitant naujo ryšio atidarymą) ir ryšio nuomos trukmė - apytikslis DB užklausų laikas
+    const LatencyHistogram& poolWaitHistogram() const { return pool_wait_; }
+    const LatencyHistogram& leaseTimeHistogram() const { return lease_time_; }
 
-                if (res->next() && res->getInt(1) == 0) {
-                    result_message = "Grupe su tokiu ID nerasta!";
-                    return result_message;
+private:
+    ConnectionLease acquireLease() {
+        const auto deadline = std::chrono::steady_clock::now() + config_.wait_timeout;
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            evictIdleLocked(now);
+
+            // Pirmiausia imame paskutinį grąžintą (dar "šiltą") ryšį
+            if (!idle_.empty()) {
+                std::unique_ptr<PooledConnection> pooled = std::move(idle_.back());
+                idle_.pop_back();
+                lock.unlock();
+
+                if (now - pooled->last_used < config_.validate_after || isHealthy(*pooled)) {
+                    return ConnectionLease(this, std::move(pooled));
                 }
 
-                // 2. Pašaliname group_id iš students lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_update_students(
-                    con->prepareStatement("UPDATE students SET group_id = NULL WHERE group_id = ?")
-                );
-                pstmt_update_students->setInt(1, group_id);
-                pstmt_update_students->executeUpdate();
+                // Ryšys nutrūko - išmetame jį ir bandome iš naujo
+                pooled.reset();
+                lock.lock();
+                --total_;
+                continue;
+            }
 
-                // 3. Pašaliname susijusius įrašus iš group_subjects lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_group_subjects(
-                    con->prepareStatement("DELETE FROM group_subjects WHERE group_id = ?")
-                );
-                pstmt_delete_group_subjects->setInt(1, group_id);
-                pstmt_delete_group_subjects->executeUpdate();
+            // Laisvų nėra, bet dar galime atidaryti naują ryšį
+            if (total_ < config_.max_size) {
+                ++total_;  // Rezervuojame vietą, kad kiti neviršytų max_size, kol jungiamės
+                lock.unlock();
 
-                // 4. Pašaliname susijusius įrašus iš group_students lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_group_students(
-                    con->prepareStatement("DELETE FROM group_students WHERE group_id = ?")
-                );
-                pstmt_delete_group_students->setInt(1, group_id);
-                pstmt_delete_group_students->executeUpdate();
+                std::unique_ptr<sql::Connection> con(connect());
+                if (con) {
+                    std::unique_ptr<PooledConnection> pooled(new PooledConnection(std::move(con), config_.statement_cache_size));
+                    return ConnectionLease(this, std::move(pooled));
+                }
 
-                // 5. Pašaliname grupę iš stud_groups lentelės
-                unique_ptr<sql::PreparedStatement> pstmt_delete_group(
-                    con->prepareStatement("DELETE FROM stud_groups WHERE group_id = ?")
-                );
-                pstmt_delete_group->setInt(1, group_id);
-                pstmt_delete_group->executeUpdate();
+                lock.lock();
+                --total_;
+                pool_cv_.notify_one();
+                return ConnectionLease();
+            }
 
-                result_message = "Grupe su ID " + std::to_string(group_id) + " pasalinta sekmingai.";
+            // Telkinys pilnas - laukiame, kol kas nors grąžins ryšį
+            if (pool_cv_.wait_until(lock, deadline) == std::cv_status::timeout &&
+                idle_.empty() && total_ >= config_.max_size) {
+                CROW_LOG_ERROR << "Nepavyko gauti rysio is telkinio per " << config_.wait_timeout.count() << " ms.";
+                return ConnectionLease();
             }
-            catch (sql::SQLException& e) {
-                result_message = "Klaida trinant grupe: " + std::string(e.what());
+        }
+    }
+
+    sql::Connection* connect() {
+        Tracer::SpanTimer span("db.connect");
+        try {
+            sql::Driver* driver = sql::mariadb::get_driver_instance();
+            // Be useServerPrepStmts Connector/C++ užklausas paruošia kliento pusėje ir kiekvieną kartą siunčia
+            // visą SQL tekstą, tad StatementCache nesutaupytų nė vieno kelio iki serverio
+            sql::Properties properties({
+                { "user", user_ },
+                { "password", password_ },
+                { "useServerPrepStmts", "true" } });
+            sql::Connection* con = driver->connect("tcp://" + host_ + ":3306", properties);
+            con->setSchema(db_);
+            return con;
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "MariaDB klaida: " << e.what();
+            return nullptr;
+        }
+    }
+
+    // Patikrina, ar ryšys dar gyvas. Jei ne - bandome jį atstatyti su reset().
+    static bool isHealthy(PooledConnection& pooled) {
+        try {
+            if (pooled.con->isValid()) {
+                return true;
             }
+            // Po reset() serveris pamiršta paruoštas užklausas, todėl išvalome ir talpyklą
+            pooled.statements.clear();
+            pooled.con->reset();
+            return pooled.con->isValid();
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Telkinio rysys nebegalioja: " << e.what();
+            return false;
         }
-        delete con; // Uždaryti ryšį su duomenų baze
-        return result_message;
     }
 
-    // Funkcija, kuri gauna grupių informaciją iš duomenų bazės ir grąžina vektorių su grupėmis
-    std::vector<std::tuple<int, std::string>> getAllGroupsFromDatabase(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string>> groups;
+    // Grąžina ryšį į telkinį (kviečiama iš ConnectionLease destruktoriaus)
+    void release(std::unique_ptr<PooledConnection> pooled) {
+        // Jei nuomininkas paliko atvirą transakciją, ją atšaukiame, kad kitas negautų "nešvaraus" ryšio
+        bool healthy = true;
+        try {
+            if (!pooled->con->getAutoCommit()) {
+                pooled->con->rollback();
+                pooled->con->setAutoCommit(true);
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Nepavyko atstatyti rysio busenos: " << e.what();
+            healthy = false;
+        }
 
-        if (con) {
-            try {
-                // Atlieka užklausą, kad gautų grupių informaciją
-                unique_ptr<sql::PreparedStatement> pstmt(
-                    con->prepareStatement("SELECT group_id, group_name FROM stud_groups")
-                );
-                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        // Nuomininko ResultSet jau uždaryti (lease sunaikinamas anksčiau už juos sukūrusią sritį),
+        // todėl tik dabar saugu išmesti talpą viršijusias užklausas
+        if (healthy) {
+            pooled->statements.trim();
+        }
 
-                // Užpildo vektorių su grupių ID ir pavadinimais
-                while (res->next()) {
-                    int group_id = res->getInt("group_id");
-                    std::string group_name = res->getString("group_name").c_str();
+        std::unique_lock<std::mutex> lock(pool_mutex_);
+        if (healthy) {
+            pooled->last_used = std::chrono::steady_clock::now();
+            idle_.push_back(std::move(pooled));
+        }
+        else {
+            --total_;
+        }
+        lock.unlock();
+        pool_cv_.notify_one();
+    }
 
-                    groups.push_back(std::make_tuple(group_id, group_name));  // Prideda į vektorių kaip tuple
-                }
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida užklausoje: " << e.what() << std::endl;
-            }
+    // Uždaro per ilgai nenaudotus ryšius, bet palieka bent min_size. Seniausi yra idle_ pradžioje.
+    void evictIdleLocked(std::chrono::steady_clock::time_point now) {
+        while (!idle_.empty() && total_ > config_.min_size &&
+            now - idle_.front()->last_used > config_.idle_timeout) {
+            idle_.pop_front();
+            --total_;
         }
-        return groups;  // Grąžina vektorių su grupėmis
     }
 
-    // Pridėti dėstytoją į duomenų bazę
-    std::string addTeacherAndSubjectToDatabase(MySQLDatabase& db, int teacher_id, int subject_id) {
-        // Prisijungimas prie MariaDB duomenų bazės
-        sql::Connection* con = db.connect();
+    std::string host_;
+    std::string user_;
+    std::string password_;
+    std::string db_;
 
-        if (!con) {
-            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
-        }
+    PoolConfig config_;
+    LoginCache login_cache_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cv_;
+    std::deque<std::unique_ptr<PooledConnection>> idle_;
+    std::size_t total_ = 0;  // Laisvi + išnuomoti ryšiai
+
+    std::atomic<std::uint64_t> statement_hits_{ 0 };
+    std::atomic<std::uint64_t> statement_misses_{ 0 };
+    LatencyHistogram pool_wait_;
+    LatencyHistogram lease_time_;
+    std::atomic<int> cascade_state_{ -1 };  // -1 dar netikrinta, 0 nėra, 1 yra
+    std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Table::Count)> table_versions_{};
+    static constexpr std::size_t kStudentStripes = 1024;
+    std::array<std::atomic<std::uint64_t>, kStudentStripes> student_versions_{};
+};
 
-        try {
-            // 1. Tikriname, ar teacher_id egzistuoja
-            std::unique_ptr<sql::PreparedStatement> check_teacher(con->prepareStatement(
-                "SELECT COUNT(*) FROM teachers WHERE teacher_id = ?"));
-            check_teacher->setInt(1, teacher_id);
-            std::unique_ptr<sql::ResultSet> teacher_res(check_teacher->executeQuery());
-            bool teacher_exists = teacher_res->next() && teacher_res->getInt(1) > 0;
+// Stiprus ETag iš duomenų versijos. Įtraukiama serverio paleidimo žymė, nes versijų
+// skaitikliai po perkrovimo vėl prasideda nuo nulio.
+std::string versionETag(const char* scope, std::uint64_t version) {
+    static const std::uint64_t boot = static_cast<std::uint64_t>(
+        std::chrono::system_clock::now().time_since_epoch().count());
+    char buffer[64];
+    char* p = buffer;
+    *p++ = '"';
+    for (const char* c = scope; *c; ++c) {
+        *p++ = *c;
+    }
+    *p++ = '-';
+    p = std::to_chars(p, buffer + sizeof(buffer), boot, 16).ptr;
+    *p++ = '-';
+    p = std::to_chars(p, buffer + sizeof(buffer), version, 16).ptr;
+    *p++ = '"';
+    return std::string(buffer, p);
+}
 
-            // 2. Tikriname, ar subject_id egzistuoja
-            std::unique_ptr<sql::PreparedStatement> check_subject(con->prepareStatement(
-                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?"));
-            check_subject->setInt(1, subject_id);
-            std::unique_ptr<sql::ResultSet> subject_res(check_subject->executeQuery());
-            bool subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+// Iš anksto suspausto (gzip) to paties turinio ETag: kiti baitai, todėl ir kitas stiprus ETag ("...-gz")
+std::string gzipETag(const std::string& etag) {
+    return etag.substr(0, etag.size() - 1) + "-gz\"";
+}
 
-            // 3. Jei bet kuris neegzistuoja, grąžiname klaidą
-            if (!teacher_exists) {
-                delete con;
-                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " neegzistuoja.";
-            }
+// Ar naršyklės If-None-Match (gali būti sąrašas arba "*") atitinka dabartinį ETag ar jo gzip variantą.
+// matched - atitikęs variantas, kurį reikia grąžinti 304 atsakyme.
+bool etagMatches(const crow::request& req, const std::string& etag, std::string& matched) {
+    const std::string& header = req.get_header_value("If-None-Match");
+    if (header.empty()) {
+        return false;
+    }
+    if (header == "*" || header.find(etag) != std::string::npos) {
+        matched = etag;
+        return true;
+    }
+    std::string gzip = gzipETag(etag);
+    if (header.find(gzip) != std::string::npos) {
+        matched = std::move(gzip);
+        return true;
+    }
+    return false;
+}
 
-            if (!subject_exists) {
-                delete con;
-                return "Klaida: Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
-            }
+// Ar klientas priima gzip (su ta pačia q=0 logika kaip CompressionMiddleware)
+bool acceptsGzip(const crow::request& req) {
+#ifdef CROW_ENABLE_COMPRESSION
+    crow::compression::algorithm algo;
+    return crow::compression::negotiate(req.get_header_value("Accept-Encoding"), algo) && algo == crow::compression::GZIP;
+#else
+    (void)req;
+    return false;
+#endif
+}
 
-            // 4. Patikriname, ar jau egzistuoja ryšys tarp dėstytojo ir dalyko
-            std::unique_ptr<sql::PreparedStatement> check_relation(con->prepareStatement(
-                "SELECT COUNT(*) FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?"));
-            check_relation->setInt(1, teacher_id);
-            check_relation->setInt(2, subject_id);
-            std::unique_ptr<sql::ResultSet> relation_res(check_relation->executeQuery());
-            bool relation_exists = relation_res->next() && relation_res->getInt(1) > 0;
+// Srautinio atsakymo buferis. Tekstas kaupiamas buffer(), o prisipildžius ~16 KB atiduodamas jungčiai kaip
+// vienas chunked gabalas. Rašymas blokuoja, kol jungtis neišsiuntė ankstesnių gabalų, todėl atmintyje
+// vienu metu laikomi tik keli gabalai, kad ir kokia didelė būtų lentelė.
+// Kadangi rašantysis laiko DB giją ir ryšį, vienas gabalas laukiamas ne ilgiau nei write_timeout, o visas
+// atsakymas - ne ilgiau nei iki deadline; pasibaigus laikui flush grąžina false ir srautas nutraukiamas.
+class ChunkWriter {
+public:
+    static constexpr std::size_t kChunkSize = 16 * 1024;
 
-            if (relation_exists) {
-                delete con;
-                return "Klaida: Sis dalykas jau priskirtas destytojui su ID " + std::to_string(teacher_id) + ".";
-            }
+    ChunkWriter(std::shared_ptr<crow::response_stream> stream, std::chrono::milliseconds write_timeout,
+        std::chrono::steady_clock::time_point deadline)
+        : stream_(std::move(stream)), write_timeout_(write_timeout), deadline_(deadline) {
+        buffer_.reserve(kChunkSize + 1024);
+    }
 
-            // 5. Jei visi patikrinimai praeina, atliekame įrašą į teacher_subjects
-            std::unique_ptr<sql::PreparedStatement> insert_relation(con->prepareStatement(
-                "INSERT INTO teacher_subjects (teacher_id, subject_id) VALUES (?, ?)"));
-            insert_relation->setInt(1, teacher_id);
-            insert_relation->setInt(2, subject_id);
-            insert_relation->executeUpdate();
+    std::string& buffer() { return buffer_; }
 
-            delete con; // Atlaisviname jungtį
-            return "success"; // Visos operacijos buvo atliktos sėkmingai
-        }
-        catch (sql::SQLException& e) {
-            delete con; // Atlaisviname jungtį klaidos atveju
-            return "SQL klaida: " + std::string(e.what());
+    // Išsiunčia buferį, jei jis prisipildė. false reiškia, kad klientas atsijungė arba per lėtai skaito
+    // ir darbą reikia nutraukti.
+    bool flushIfFull() { return buffer_.size() < kChunkSize || flush(); }
+
+    bool flush() {
+        if (buffer_.empty()) {
+            return true;
         }
+        auto deadline = std::min(deadline_, std::chrono::steady_clock::now() + write_timeout_);
+        bool ok = stream_->write(std::move(buffer_), deadline);
+        buffer_.clear();
+        buffer_.reserve(kChunkSize + 1024);
+        return ok;
     }
 
-    // Pašalinti dėstytoją iš dalyko
-    std::string removeTeacherAndSubjectFromDatabase(MySQLDatabase& db, int teacher_id, int subject_id) {
-        // Prisijungimas prie MariaDB duomenų bazės
-        sql::Connection* con = db.connect();
+    // Ar darbas nutrauktas dėl laiko, o ne dėl atsijungusio kliento
+    bool timedOut() const { return stream_->timed_out(); }
 
-        if (!con) {
-            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
+private:
+    std::shared_ptr<crow::response_stream> stream_;
+    std::chrono::milliseconds write_timeout_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::string buffer_;
+};
+
+// Atskiras gijų telkinys blokuojančioms SQL užklausoms.
+// Crow IO gijos tik perduoda darbą į ribotą eilę, o atsakymas užbaigiamas vėliau per response::end(),
+// todėl viena lėta užklausa nebeužlaiko kitų tos pačios io_context jungčių.
+class DbExecutor {
+public:
+    DbExecutor(std::size_t threads, std::size_t max_queue)
+        : max_queue_(max_queue) {
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { run(); });
         }
+    }
 
-        try {
-            // 1. Patikriname, ar egzistuoja dėstytojas ir dalykas
-            std::unique_ptr<sql::PreparedStatement> check_teacher(con->prepareStatement(
-                "SELECT COUNT(*) FROM teachers WHERE teacher_id = ?"));
-            check_teacher->setInt(1, teacher_id);
-            std::unique_ptr<sql::ResultSet> teacher_res(check_teacher->executeQuery());
-            bool teacher_exists = teacher_res->next() && teacher_res->getInt(1) > 0;
+    DbExecutor(const DbExecutor&) = delete;
+    DbExecutor& operator=(const DbExecutor&) = delete;
 
-            std::unique_ptr<sql::PreparedStatement> check_subject(con->prepareStatement(
-                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?"));
-            check_subject->setInt(1, subject_id);
-            std::unique_ptr<sql::ResultSet> subject_res(check_subject->executeQuery());
-            bool subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+    ~DbExecutor() {
+        shutdown();
+    }
 
-            // 2. Jei dėstytojas arba dalykas neegzistuoja
-            if (!teacher_exists) {
-                delete con;
-                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " neegzistuoja.";
+    // Nebepriima naujų darbų, įvykdo jau eilėje esančius ir sujungia gijas. Galima kviesti kelis kartus.
+    // Darbai rodo į main() objektus, todėl kviečiama prieš jiems išnykstant.
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
             }
+        }
+    }
 
-            if (!subject_exists) {
-                delete con;
-                return "Klaida: Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+    // Įdeda darbą į eilę. Grąžina false, jei eilė pilna arba vykdyklė stabdoma.
+    bool submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || jobs_.size() >= max_queue_) {
+                return false;
             }
+            jobs_.push_back({ std::move(job), std::chrono::steady_clock::now() });
+        }
+        cv_.notify_one();
+        return true;
+    }
 
-            // 3. Tikriname, ar egzistuoja ryšys tarp dėstytojo ir dalyko
-            std::unique_ptr<sql::PreparedStatement> check_relationship(con->prepareStatement(
-                "SELECT COUNT(*) FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?"));
-            check_relationship->setInt(1, teacher_id);
-            check_relationship->setInt(2, subject_id);
-            std::unique_ptr<sql::ResultSet> relationship_res(check_relationship->executeQuery());
-            bool relationship_exists = relationship_res->next() && relationship_res->getInt(1) > 0;
-
-            if (!relationship_exists) {
-                delete con;
-                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " ir dalykas su ID " +
-                    std::to_string(subject_id) + " nera priskirti.";
+    // Įvykdo work DB gijoje, o gautą atsakymą išsiunčia užklausos IO gijoje.
+    // req turi galioti, kol atsakymas neužbaigtas - Crow tai užtikrina asinchroniniams maršrutams.
+    void respond(const crow::request& req, crow::response& res, std::function<crow::response()> work) {
+        auto* io_service = req.io_service;
+        std::shared_ptr<Tracer::Trace> trace = Tracer::current();
+        auto queued_at = std::chrono::steady_clock::now();
+        bool queued = submit([io_service, &res, work = std::move(work), trace, queued_at]() {
+            Tracer::Scope scope(trace);
+            auto started = std::chrono::steady_clock::now();
+            if (trace) trace->add("queue", queued_at, started);
+
+            auto result = std::make_shared<crow::response>();
+            try {
+                *result = work();
             }
+            catch (const std::exception& e) {
+                CROW_LOG_ERROR << "Klaida vykdant DB darba: " << e.what();
+                *result = crow::response(500, "Vidine klaida.");
+            }
+            auto posted = std::chrono::steady_clock::now();
+            if (trace) trace->add("db.job", started, posted);
+
+            // response ir jungtis priklauso IO gijai, todėl užbaigiame tik ten
+            io_service->post([&res, result, trace, posted]() {
+                Tracer::Scope scope(trace);
+                if (trace) trace->add("io.wait", posted, std::chrono::steady_clock::now());
+                res = std::move(*result);
+                res.end();
+            });
+        });
 
-            // 4. Pašaliname ryšį iš teacher_subjects lentelės
-            std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                "DELETE FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?"));
-            pstmt->setInt(1, teacher_id);
-            pstmt->setInt(2, subject_id);
+        if (!queued) {
+            res.code = 503;
+            res.end("Serveris perkrautas, bandykite veliau.");
+        }
+    }
 
-            int affectedRows = pstmt->executeUpdate();
-            if (affectedRows > 0) {
-                delete con;
-                return "success"; // Ryšys buvo sėkmingai pašalintas
+    // Kaip respond, bet su ETag, apskaičiuotu iš atmintyje laikomų versijų. Jei naršyklė jau turi
+    // tą versiją, 304 atsakoma iškart IO gijoje - darbas į eilę nededamas ir DB neliečiama.
+    // ETag reikia apskaičiuoti prieš skaitant duomenis, kad lenktynių atveju jis būtų senesnis, o ne naujesnis.
+    // Jau suspaustas (gzip) turinys, pvz., iš RenderedPageCache, gauna atskirą "-gz" ETag.
+    void respondWithETag(const crow::request& req, crow::response& res, std::string etag, std::function<crow::response()> work) {
+        std::string matched;
+        if (etagMatches(req, etag, matched)) {
+            res.code = 304;
+            res.set_header("ETag", matched);
+            res.end();
+            return;
+        }
+        respond(req, res, [etag = std::move(etag), work = std::move(work)]() {
+            crow::response result = work();
+            if (result.code == 200) {
+                result.set_header("ETag", result.get_header_value("Content-Encoding") == "gzip" ? gzipETag(etag) : etag);
+                result.set_header("Cache-Control", "no-cache");
             }
-            else {
-                delete con;
-                return "Klaida: Nepavyko pašalinti ryšio.";
+            return result;
+        });
+    }
+
+    // Srautinis atsakymas dideliems sąrašams: antraštės (200, Transfer-Encoding: chunked) išsiunčiamos iškart,
+    // o work DB gijoje rašo į ChunkWriter. Klaida po antraščių nebegali tapti 500, todėl tada jungtis
+    // nutraukiama be baigiamojo gabalo - klientas mato nepilną atsakymą.
+    // Kol lėtas klientas neperskaito gabalų, darbas laiko DB giją ir ryšį, todėl srautas nutraukiamas, jei
+    // vienas gabalas laukia ilgiau nei kStreamWriteTimeout arba visas atsakymas trunka ilgiau nei kStreamTimeout.
+    static constexpr std::chrono::seconds kStreamWriteTimeout{ 30 };
+    static constexpr std::chrono::minutes kStreamTimeout{ 10 };
+
+    void stream(crow::response& res, const std::string& content_type, std::function<void(ChunkWriter&)> work) {
+        auto body = std::make_shared<crow::response_stream>();
+        std::shared_ptr<Tracer::Trace> trace = Tracer::current();
+        auto queued_at = std::chrono::steady_clock::now();
+        bool queued = submit([body, work = std::move(work), trace, queued_at]() {
+            Tracer::Scope scope(trace);
+            auto started = std::chrono::steady_clock::now();
+            if (trace) trace->add("queue", queued_at, started);
+            ChunkWriter out(body, kStreamWriteTimeout, started + kStreamTimeout);
+            bool ok = true;
+            try {
+                work(out);
+                ok = out.flush();
             }
+            catch (const std::exception& e) {
+                CROW_LOG_ERROR << "Klaida vykdant DB darba (srautas): " << e.what();
+                ok = false;
+            }
+            if (!ok && out.timedOut()) {
+                CROW_LOG_WARNING << "Srautas nutrauktas: klientas per letai skaito, DB gija ir rysys atlaisvinti";
+            }
+            // Kaip respond(): intervalas įrašomas prieš close, nes po jo IO gija gali trace užbaigti ir paskelbti
+            if (trace) trace->add("db.job", started, std::chrono::steady_clock::now());
+            body->close(ok);
+        });
+
+        if (!queued) {
+            res.code = 503;
+            res.end("Serveris perkrautas, bandykite veliau.");
+            return;
         }
-        catch (sql::SQLException& e) {
-            delete con;
-            return "SQL klaida: " + std::string(e.what());
-        }
+        res.set_header("Content-Type", content_type);
+        res.stream = std::move(body);
+        res.end();
     }
 
-    // Funkcija, kuri grąžina vektorių su dėstytojo ir dalyko informacija
-    std::vector<std::tuple<int, std::string, std::string, int, std::string>> getTeacherSubjectInfo(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string, std::string, int, std::string>> teacherSubjectInfo;  // Vektorius su tuple..:)
-
-        if (con) {
-            try {
-                // Atlieka užklausą, kad gautų dėstytojų ir jų priskirtų dalykų informaciją
-                unique_ptr<sql::PreparedStatement> pstmt(
-                    con->prepareStatement("SELECT t.teacher_id, t.name, t.surname, s.subject_id, s.subject_name "
-                        "FROM teachers t "
-                        "LEFT JOIN teacher_subjects ts ON t.teacher_id = ts.teacher_id "
-                        "LEFT JOIN subjects s ON ts.subject_id = s.subject_id")
-                );
-                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    std::size_t queueLength() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return jobs_.size();
+    }
 
-                // Užpildo vektorių su dėstytojų ir dalykų informacija
-                while (res->next()) {
-                    int teacher_id = res->getInt("teacher_id");
-                    std::string teacher_name = res->getString("name").c_str();
-                    std::string teacher_surname = res->getString("surname").c_str();
-                    int subject_id = res->getInt("subject_id");
-                    std::string subject_name = res->getString("subject_name").c_str();
+    // Kiek darbas laukė eilėje ir kiek truko (DB + atsakymo paruošimas)
+    const LatencyHistogram& queueWaitHistogram() const { return queue_wait_; }
+    const LatencyHistogram& jobTimeHistogram() const { return job_time_; }
 
-                    // Jei dalykas nepriskirtas, įrašome "Nera dalyko" (kažkodėl neveikia UTF-8 koduotė)
-                    if (subject_id == 0) {
-                        teacherSubjectInfo.push_back(std::make_tuple(teacher_id, teacher_name, teacher_surname, 0, "Nera dalyko"));
-                    }
-                    else {
-                        teacherSubjectInfo.push_back(std::make_tuple(teacher_id, teacher_name, teacher_surname, subject_id, subject_name));
-                    }
+private:
+    void run() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    return;  // Stabdoma ir eilė jau tuščia
                 }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida uzklausoje: " << e.what() << std::endl;
-            }
+            auto started = std::chrono::steady_clock::now();
+            queue_wait_.record(started - job.queued);
+            job.work();
+            job_time_.record(std::chrono::steady_clock::now() - started);
         }
-
-        return teacherSubjectInfo;  // Grąžina vektorių su dėstytojo ir dėstomo dalyko informacija
     }
 
-    // Pridedame studentus su grupe.
-    std::string addGroupAndStudentToDatabase(MySQLDatabase& db, int group_id, int student_id) {
-        // Prisijungimas prie MariaDB
-        sql::Connection* con = db.connect();
-        if (!con) {
-            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
-        }
+    struct Job {
+        std::function<void()> work;
+        std::chrono::steady_clock::time_point queued;
+    };
+
+    std::size_t max_queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    LatencyHistogram queue_wait_;
+    LatencyHistogram job_time_;
+    std::vector<std::thread> workers_;
+    bool stopping_ = false;
+};
 
-        try {
-            // Patikriname, ar group_id egzistuoja
-            std::unique_ptr<sql::PreparedStatement> check_group(con->prepareStatement(
-                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?"));
-            check_group->setInt(1, group_id);
-            std::unique_ptr<sql::ResultSet> group_res(check_group->executeQuery());
-            bool group_exists = group_res->next() && group_res->getInt(1) > 0;
+//Studento klasė (vaikas iš user klasės)
+class Student : public User {
+public:
+    Student(int id, const string& name, const string& surname)
+        : User(id, name, surname, "Studentas") {}
 
-            // Patikriname, ar student_id egzistuoja
-            std::unique_ptr<sql::PreparedStatement> check_student(con->prepareStatement(
-                "SELECT COUNT(*) FROM students WHERE student_id = ?"));
-            check_student->setInt(1, student_id);
-            std::unique_ptr<sql::ResultSet> student_res(check_student->executeQuery());
+    // Metodas grąžinantis studento duomenis
+    static bool getStudentData(int student_id, MySQLDatabase::ConnectionLease& con, std::string& name, std::string& surname, std::vector<std::pair<std::string, std::string>>& subjects) {
+        // Pirma užklausa: gauti studento vardą ir pavardę
+        sql::PreparedStatement* studentPstmt = con.prepare(
+            "SELECT name, surname FROM students WHERE student_id = ?"
+        );
+        studentPstmt->setInt(1, student_id);
+
+        std::unique_ptr<sql::ResultSet> studentRes(studentPstmt->executeQuery());
+
+        if (studentRes->next()) {
+            name = studentRes->getString("name").c_str();
+            surname = studentRes->getString("surname").c_str();
+        }
+        else {
+            return false;  // Studentas nerastas
+        }
+
+        // Antra užklausa: gauti studento studijojamus dalykus ir pažymius
+        sql::PreparedStatement* pstmt = con.prepare(
+            "SELECT sub.subject_name, "
+            "CASE WHEN g.grade IS NULL THEN 'Nera' ELSE CAST(g.grade AS CHAR) END AS grade "
+            "FROM students_subjects ss "
+            "JOIN subjects sub ON ss.subject_id = sub.subject_id "
+            "LEFT JOIN grades g ON ss.student_id = g.student_id AND sub.subject_id = g.subject_id "
+            "WHERE ss.student_id = ?"
+        );
+        pstmt->setInt(1, student_id);
+
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        // Užpildome dalykų ir pažymių sąrašą
+        while (res->next()) {
+            std::string subject_name = res->getString("subject_name").c_str();
+            std::string grade = res->getString("grade").c_str();
+            subjects.push_back({ subject_name, grade });
+        }
+
+        return true;
+    }
+
+};
+// Dėstytojo klasė (vaikas iš user klasės)
+class Teacher : public User {
+public:
+    Teacher(int id, const string& name, const string& surname)
+        : User(id, name, surname, "Destytojas") {}
+    // Funkcija gauti dėstytojo informaciją
+    static bool getTeacherInfo(int teacher_id, MySQLDatabase::ConnectionLease& con, std::string& name, std::string& surname) {
+        // Gauti dėstytojo vardą ir pavardę
+        sql::PreparedStatement* teacherPstmt = con.prepare(
+            "SELECT name, surname FROM teachers WHERE teacher_id = ?"
+        );
+        teacherPstmt->setInt(1, teacher_id);
+        std::unique_ptr<sql::ResultSet> teacherRes(teacherPstmt->executeQuery());
+
+        if (teacherRes->next()) {
+            name = teacherRes->getString("name").c_str();
+            surname = teacherRes->getString("surname").c_str();
+            return true;
+        }
+        return false;
+    }
+
+    static bool getSubjects(int teacher_id, MySQLDatabase::ConnectionLease& con, std::vector<std::pair<int, std::string>>& subjects) {
+        // Gauti dėstytojui priskirtus dalykus
+        sql::PreparedStatement* pstmt = con.prepare(
+            "SELECT s.subject_id, s.subject_name "
+            "FROM teacher_subjects ts "
+            "JOIN subjects s ON ts.subject_id = s.subject_id "
+            "WHERE ts.teacher_id = ?"
+        );
+        pstmt->setInt(1, teacher_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        while (res->next()) {
+            int subject_id = res->getInt("subject_id");
+            std::string subject_name = res->getString("subject_name").c_str();
+            subjects.push_back({ subject_id, subject_name });
+        }
+
+        return !subjects.empty();
+    }
+    // Funkcija gauti dėstomo dalyko informaciją.
+    static bool getSubjectInfo(int subject_id, MySQLDatabase::ConnectionLease& con, std::string& subject_name) {
+        sql::PreparedStatement* pstmt_subject = con.prepare(
+            "SELECT subject_name FROM subjects WHERE subject_id = ?");
+        pstmt_subject->setInt(1, subject_id);
+        std::unique_ptr<sql::ResultSet> res_subject(pstmt_subject->executeQuery());
+
+        if (res_subject->next()) {
+            subject_name = res_subject->getString("subject_name").c_str();
+            return true;
+        }
+        return false;
+    }
+    // Dalyko studentų sąrašo eilutė (grade == 0 - pažymio nėra)
+    struct RosterRow {
+        int student_id;
+        std::string name;
+        std::string surname;
+        int grade;
+    };
+
+    // Dalyko studentai su pažymiais; naudojama ir HTML puslapyje, ir JSON API
+    static std::vector<RosterRow> getSubjectRoster(int subject_id, MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt_students = con.prepare(
+            "SELECT DISTINCT s.student_id, s.name, s.surname, IFNULL(g.grade, 0) AS grade "
+            "FROM students s "
+            "JOIN students_subjects ss ON s.student_id = ss.student_id "
+            "JOIN group_subjects gs ON gs.subject_id = ss.subject_id "
+            "LEFT JOIN grades g ON s.student_id = g.student_id AND g.subject_id = ss.subject_id "
+            "WHERE ss.subject_id = ? AND s.group_id IS NOT NULL");
+        pstmt_students->setInt(1, subject_id);
+        std::unique_ptr<sql::ResultSet> res_students(pstmt_students->executeQuery());
+
+        std::vector<RosterRow> roster;
+        while (res_students->next()) {
+            roster.push_back({ res_students->getInt("student_id"), res_students->getString("name").c_str(),
+                res_students->getString("surname").c_str(), res_students->getInt("grade") });
+        }
+        return roster;
+    }
+
+    // Funkcija gauti studentus iš dėstomo dalyko.
+    static bool getStudentsForSubject(int subject_id, MySQLDatabase::ConnectionLease& con, std::string& students_html) {
+        for (const RosterRow& row : getSubjectRoster(subject_id, con)) {
+            std::string id = std::to_string(row.student_id);
+            students_html += "<tr>";
+            students_html += "<td>" + id + "</td>";
+            students_html += "<td>" + htmlEscape(row.name) + "</td>";
+            students_html += "<td>" + htmlEscape(row.surname) + "</td>";
+            students_html += "<td>" + (row.grade == 0 ? "Nera" : std::to_string(row.grade)) + "</td>";
+            students_html += "<td><input type='number' class='batch-grade' data-student-id='" + id + "' min='1' max='10'>"
+                " <label><input type='checkbox' class='batch-delete' data-student-id='" + id + "'> Istrinti</label></td>";
+            students_html += "</tr>";
+        }
+
+        return !students_html.empty();
+    }
+    // Pažymio keitimo rezultatas: ar pavyko, o jei ne - kuri sąlyga neišpildyta
+    enum class GradeResult { Ok, StudentNotFound, NotAssigned, GradeExists, GradeMissing, SameGrade };
+
+    // Funkcija leidžianti pridėti studentui pažymį. Visi patikrinimai atliekami tame pačiame sakinyje.
+    static GradeResult addGrade(int student_id, int subject_id, int grade, MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt = con.prepare(
+            "INSERT INTO grades (student_id, subject_id, grade) "
+            "SELECT ss.student_id, ss.subject_id, ? FROM students_subjects ss "
+            "WHERE ss.student_id = ? AND ss.subject_id = ? "
+            "AND NOT EXISTS (SELECT 1 FROM grades g WHERE g.student_id = ss.student_id AND g.subject_id = ss.subject_id)");
+        pstmt->setInt(1, grade);
+        pstmt->setInt(2, student_id);
+        pstmt->setInt(3, subject_id);
+        if (pstmt->executeUpdate() > 0) {
+            return GradeResult::Ok;
+        }
+
+        GradeState state = getGradeState(student_id, subject_id, con);
+        if (!state.student_exists) return GradeResult::StudentNotFound;
+        if (!state.assigned) return GradeResult::NotAssigned;
+        return GradeResult::GradeExists;
+    }
+    // Funkcija leidžianti panaikinti studento pažymį.
+    static GradeResult deleteGrade(int student_id, int subject_id, MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt = con.prepare(
+            "DELETE g FROM grades g "
+            "JOIN students_subjects ss ON ss.student_id = g.student_id AND ss.subject_id = g.subject_id "
+            "WHERE g.student_id = ? AND g.subject_id = ?");
+        pstmt->setInt(1, student_id);
+        pstmt->setInt(2, subject_id);
+        if (pstmt->executeUpdate() > 0) {
+            return GradeResult::Ok;
+        }
+
+        GradeState state = getGradeState(student_id, subject_id, con);
+        if (!state.student_exists) return GradeResult::StudentNotFound;
+        if (!state.assigned) return GradeResult::NotAssigned;
+        return GradeResult::GradeMissing;
+    }
+    // Funkcija leidžianti koreguoti studento pažymį. Tas pats pažymys neatnaujinamas (grade <> ?).
+    static GradeResult updateGrade(int student_id, int new_grade, int subject_id, MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt = con.prepare(
+            "UPDATE grades g "
+            "JOIN students_subjects ss ON ss.student_id = g.student_id AND ss.subject_id = g.subject_id "
+            "SET g.grade = ? "
+            "WHERE g.student_id = ? AND g.subject_id = ? AND g.grade <> ?");
+        pstmt->setInt(1, new_grade);
+        pstmt->setInt(2, student_id);
+        pstmt->setInt(3, subject_id);
+        pstmt->setInt(4, new_grade);
+        if (pstmt->executeUpdate() > 0) {
+            return GradeResult::Ok;
+        }
+
+        GradeState state = getGradeState(student_id, subject_id, con);
+        if (!state.student_exists) return GradeResult::StudentNotFound;
+        if (!state.assigned) return GradeResult::NotAssigned;
+        if (!state.has_grade) return GradeResult::GradeMissing;
+        return GradeResult::SameGrade;
+    }
+    // Klaidos pranešimas pagal nepavykusio pažymio keitimo priežastį.
+    static std::string gradeErrorMessage(GradeResult result) {
+        switch (result) {
+        case GradeResult::StudentNotFound:
+            return "Tokio studento nera.";
+        case GradeResult::NotAssigned:
+            return "Studentas nera priskirtas siam dalykui.";
+        case GradeResult::GradeExists:
+            return "Studentas jau turi pazymi siam dalykui.";
+        case GradeResult::GradeMissing:
+            return "Studentas neturi pazymio siam dalykui.";
+        case GradeResult::SameGrade:
+            return "Naujas pazymys yra toks pats kaip senas.";
+        default:
+            return "Vidine klaida.";
+        }
+    }
+    // Tas pats pranešimas JSON pavidalu (naudojamas pavienių pažymių maršrutuose).
+    static std::string gradeErrorJson(GradeResult result) {
+        return "{\"status\": \"error\", \"message\": \"" + gradeErrorMessage(result) + "\"}";
+    }
+
+    // Vienas paketinio pažymių keitimo įrašas: pažymio įrašymas/keitimas arba ištrynimas (remove)
+    struct GradeChange {
+        int student_id;
+        int grade;
+        bool remove;
+    };
+
+    struct GradeChangeResult {
+        int student_id;
+        GradeResult result;
+        std::string message;
+    };
+
+    // Pritaiko visus vieno dalyko pažymių pakeitimus vienoje transakcijoje.
+    // Sąrašas nuskaitomas viena užklausa prieš students_subjects su FOR UPDATE jau transakcijoje, todėl
+    // lygiagretus /add_grade ar /delete_grade laukia, kol paketas baigsis. Įrašai atliekami paketais
+    // (addBatch/executeBatch), o galutiniai rezultatai sudaromi pagal tikrą paveiktų eilučių skaičių.
+    // Jei tas pats studentas pasikartoja, pakeitimai taikomi iš eilės, bet į DB keliauja tik galutinė būsena.
+    static std::vector<GradeChangeResult> applyGradeBatch(int subject_id, const std::vector<GradeChange>& changes,
+        MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt_roster = con.prepare(
+            "SELECT ss.student_id, IFNULL(g.grade, 0) AS grade "
+            "FROM students_subjects ss "
+            "LEFT JOIN grades g ON g.student_id = ss.student_id AND g.subject_id = ss.subject_id "
+            "WHERE ss.subject_id = ? FOR UPDATE");
+        // IGNORE: jei pažymys vis dėlto atsirado (pvz., READ COMMITTED be tarpų užraktų), gauname 0 eilučių, o ne klaidą visam paketui
+        sql::PreparedStatement* pstmt_insert = con.prepare(
+            "INSERT IGNORE INTO grades (student_id, subject_id, grade) VALUES (?, ?, ?)");
+        sql::PreparedStatement* pstmt_update = con.prepare(
+            "UPDATE grades SET grade = ? WHERE student_id = ? AND subject_id = ?");
+        sql::PreparedStatement* pstmt_delete = con.prepare(
+            "DELETE FROM grades WHERE student_id = ? AND subject_id = ?");
+
+        con->setAutoCommit(false);
+        try {
+            // Dalyko sąrašas: studentas -> dabartinis pažymys (0, jei pažymio nėra)
+            std::unordered_map<int, int> roster;
+            pstmt_roster->setInt(1, subject_id);
+            {
+                std::unique_ptr<sql::ResultSet> res(pstmt_roster->executeQuery());
+                while (res->next()) {
+                    roster[res->getInt("student_id")] = res->getInt("grade");
+                }
+            }
+
+            std::vector<GradeChangeResult> results;
+            results.reserve(changes.size());
+            std::unordered_map<int, int> initial;  // Pakeistų studentų pažymys prieš paketą (0 - nebuvo)
+            std::unordered_map<int, std::vector<std::size_t>> accepted;  // Studento Ok rezultatų indeksai
+
+            for (const GradeChange& change : changes) {
+                auto it = roster.find(change.student_id);
+                if (it == roster.end()) {
+                    results.push_back({ change.student_id, GradeResult::NotAssigned, gradeErrorMessage(GradeResult::NotAssigned) });
+                    continue;
+                }
+
+                int& current = it->second;
+                initial.emplace(change.student_id, current);  // Įsimename tik pirmą kartą
+                if (change.remove) {
+                    if (current == 0) {
+                        results.push_back({ change.student_id, GradeResult::GradeMissing, gradeErrorMessage(GradeResult::GradeMissing) });
+                        continue;
+                    }
+                    current = 0;
+                    results.push_back({ change.student_id, GradeResult::Ok, "Pazymys sekmingai istrintas." });
+                }
+                else if (current == change.grade) {
+                    results.push_back({ change.student_id, GradeResult::SameGrade, gradeErrorMessage(GradeResult::SameGrade) });
+                    continue;
+                }
+                else {
+                    results.push_back({ change.student_id, GradeResult::Ok,
+                        current == 0 ? "Pazymys sekmingai pridetas." : "Pazymys sekmingai atnaujintas." });
+                    current = change.grade;
+                }
+                accepted[change.student_id].push_back(results.size() - 1);
+            }
+
+            // Kiekvienam studentui į DB siunčiame tik galutinę būseną: INSERT, UPDATE arba DELETE.
+            // Paketo eilučių tvarka įsimenama, kad executeBatch skaičius būtų galima priskirti studentams.
+            std::vector<int> deleted, inserted, updated;
+            for (const auto& entry : initial) {
+                int student_id = entry.first;
+                int before = entry.second;
+                int after = roster[student_id];
+                if (before == after) {
+                    continue;  // Pvz., pažymys pridėtas ir vėl ištrintas tame pačiame pakete
+                }
+                if (after == 0) {
+                    pstmt_delete->setInt(1, student_id);
+                    pstmt_delete->setInt(2, subject_id);
+                    pstmt_delete->addBatch();
+                    deleted.push_back(student_id);
+                }
+                else if (before == 0) {
+                    pstmt_insert->setInt(1, student_id);
+                    pstmt_insert->setInt(2, subject_id);
+                    pstmt_insert->setInt(3, after);
+                    pstmt_insert->addBatch();
+                    inserted.push_back(student_id);
+                }
+                else {
+                    pstmt_update->setInt(1, after);
+                    pstmt_update->setInt(2, student_id);
+                    pstmt_update->setInt(3, subject_id);
+                    pstmt_update->addBatch();
+                    updated.push_back(student_id);
+                }
+            }
+
+            // 0 paveiktų eilučių - pakeitimas neįvyko, todėl to studento Ok rezultatai pakeičiami klaida.
+            // Neigiamas skaičius (SUCCESS_NO_INFO) reiškia, kad tvarkyklė skaičiaus nežino - laikome sėkme.
+            auto check = [&](sql::PreparedStatement* pstmt, const std::vector<int>& students, GradeResult failure) {
+                if (students.empty()) {
+                    return;
+                }
+                const sql::Ints& counts = pstmt->executeBatch();
+                for (std::size_t i = 0; i < students.size(); i++) {
+                    if (i < counts.size() && counts[i] != 0) {
+                        continue;
+                    }
+                    for (std::size_t index : accepted[students[i]]) {
+                        results[index].result = failure;
+                        results[index].message = gradeErrorMessage(failure);
+                    }
+                }
+            };
+            check(pstmt_delete, deleted, GradeResult::GradeMissing);
+            check(pstmt_insert, inserted, GradeResult::GradeExists);
+            check(pstmt_update, updated, GradeResult::GradeMissing);
+
+            con->commit();
+            con->setAutoCommit(true);
+            return results;
+        }
+        catch (sql::SQLException&) {
+            // Talpykloje likę paketai neturi patekti į kitą užklausą
+            pstmt_delete->clearBatch();
+            pstmt_insert->clearBatch();
+            pstmt_update->clearBatch();
+            con->rollback();
+            con->setAutoCommit(true);
+            throw;
+        }
+    }
+
+private:
+    struct GradeState {
+        bool student_exists = false;
+        bool assigned = false;
+        bool has_grade = false;
+    };
+
+    // Viena diagnostinė užklausa, kviečiama tik kai pažymio keitimas nieko nepakeitė.
+    static GradeState getGradeState(int student_id, int subject_id, MySQLDatabase::ConnectionLease& con) {
+        sql::PreparedStatement* pstmt = con.prepare(
+            "SELECT EXISTS(SELECT 1 FROM students WHERE student_id = ?) AS student_exists, "
+            "EXISTS(SELECT 1 FROM students_subjects WHERE student_id = ? AND subject_id = ?) AS assigned, "
+            "EXISTS(SELECT 1 FROM grades WHERE student_id = ? AND subject_id = ?) AS has_grade");
+        pstmt->setInt(1, student_id);
+        pstmt->setInt(2, student_id);
+        pstmt->setInt(3, subject_id);
+        pstmt->setInt(4, student_id);
+        pstmt->setInt(5, subject_id);
+        std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+        GradeState state;
+        if (res->next()) {
+            state.student_exists = res->getInt("student_exists") != 0;
+            state.assigned = res->getInt("assigned") != 0;
+            state.has_grade = res->getInt("has_grade") != 0;
+        }
+        return state;
+    }
+
+};
+
+// Admino klasė (vaikas iš user klasės)
+class Administrator : public User {
+public:
+    Administrator(int id, const string& name, const string& surname)
+        : User(id, name, surname, "Administratorius") {}
+
+    // Pridėti studentą į duomenų bazę
+    std::string addStudentToDatabase(MySQLDatabase& db, const std::string& name, const std::string& surname) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (con) {
+            try {
+                // Patikriname, ar studentas su tokiu vardu ir pavarde jau egzistuoja
+                sql::PreparedStatement* pstmt_student =
+                    con.prepare("SELECT COUNT(*) FROM students WHERE name = ? AND surname = ?");
+                pstmt_student->setString(1, name);
+                pstmt_student->setString(2, surname);
+                unique_ptr<sql::ResultSet> res_student(pstmt_student->executeQuery());
+                if (res_student->next() && res_student->getInt(1) > 0) {
+                    return "Studentas su tokiu vardu ir pavarde jau egzistuoja!";
+                }
+
+                // Patikriname, ar dėstytojas su tokiu vardu ir pavarde jau egzistuoja
+                sql::PreparedStatement* pstmt_teacher =
+                    con.prepare("SELECT COUNT(*) FROM teachers WHERE name = ? AND surname = ?");
+                pstmt_teacher->setString(1, name);
+                pstmt_teacher->setString(2, surname);
+                unique_ptr<sql::ResultSet> res_teacher(pstmt_teacher->executeQuery());
+                if (res_teacher->next() && res_teacher->getInt(1) > 0) {
+                    return "Su tokiu vardu ir pavarde jau egzistuoja destytojas!";
+                }
+
+                // Pridėti studentą į duomenų bazę
+                sql::PreparedStatement* pstmt = con.prepare(
+                    "INSERT INTO students (name, surname, role, username, password) VALUES (?, ?, ?, ?, ?)");
+                pstmt->setString(1, name);
+                pstmt->setString(2, surname);
+                pstmt->setString(3, "Studentas");  // rolė - Studentas
+                pstmt->setString(4, name.substr(0, 1) + name.substr(1));  // username (pirmoji vardo raidė)
+                pstmt->setString(5, surname);  // Slaptažodis = pavardė
+
+                pstmt->executeUpdate();
+                db.touch(MySQLDatabase::Table::Students);
+                return "Studentas pridetas sekmingai!";
+            }
+            catch (sql::SQLException& e) {
+                return "Klaida uzklausoje: " + std::string(e.what());
+            }
+        }
+        else {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+    }
+
+    // Pašalinti studentą pagal ID iš visų susijusių lentelių (iš DB)
+    std::string deleteStudentFromDatabase(MySQLDatabase& db, int student_id) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // Egzistavimo patikrinimas sujungtas su trynimu: 0 ištrintų eilučių reiškia, kad įrašo nėra
+            if (cascadeDelete(db, con, kStudentCascade, { student_id }) == 0) {
+                return "Studentas su tokiu ID nerastas!";
+            }
+            // Pašalintas vartotojas nebeturi galėti prisijungti iš talpyklos
+            db.invalidateLoginCache();
+            return "Studentas pasalintas sekmingai!";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant studenta: " + std::string(e.what());
+        }
+    }
+
+    // Pašalinti kelis studentus vienu kartu (pvz. mokslo metų pabaigoje), viskas vienoje transakcijoje
+    std::string deleteStudentsFromDatabase(MySQLDatabase& db, const std::vector<int>& student_ids) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            std::size_t deleted = cascadeDelete(db, con, kStudentCascade, student_ids);
+            if (deleted > 0) {
+                db.invalidateLoginCache();
+            }
+            return "Pasalinta studentu: " + std::to_string(deleted) + " is " + std::to_string(student_ids.size()) + " nurodytu.";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant studenta: " + std::string(e.what());
+        }
+    }
+
+    // Gauti visus studentus iš duomenų bazės. ok == false - nėra ryšio arba užklausa nepavyko (sąrašas nepilnas)
+    std::vector<std::tuple<int, std::string, std::string>> getAllStudents(MySQLDatabase::ConnectionLease& conn, bool& ok) {
+        std::vector<std::tuple<int, std::string, std::string>> students;
+        ok = false;
+
+        if (conn) {
+            try {
+                sql::PreparedStatement* pstmt =
+                    conn.prepare("SELECT student_id, name, surname FROM students");
+                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                while (res->next()) {
+                    int student_id = res->getInt("student_id");
+                    std::string name = res->getString("name").c_str();
+                    std::string surname = res->getString("surname").c_str();
+
+                    students.push_back(std::make_tuple(student_id, name, surname));
+                }
+                ok = true;
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+            }
+        }
+        else {
+            CROW_LOG_ERROR << "Nepavyko prisijungti prie duomenų bazės!";
+        }
+
+        return students;
+    }
+
+
+    // Vienas studentų sąrašo puslapis: keyset puslapiavimas pagal student_id, be OFFSET.
+    // Vardo/pavardės pradžios filtrą aptarnauja idx_students_name ir idx_students_surname indeksai.
+    std::vector<std::tuple<int, std::string, std::string>> getStudentsPage(MySQLDatabase::ConnectionLease& conn,
+        const PageRequest& page, bool& has_more) {
+        std::vector<std::tuple<int, std::string, std::string>> students;
+        has_more = false;
+
+        if (!conn) {
+            CROW_LOG_ERROR << "Nepavyko prisijungti prie duomenų bazės!";
+            return students;
+        }
+
+        try {
+            sql::PreparedStatement* pstmt;
+            if (page.prefix.empty()) {
+                pstmt = conn.prepare(
+                    "SELECT student_id, name, surname FROM students WHERE student_id > ? "
+                    "ORDER BY student_id LIMIT ?");
+                pstmt->setInt(1, page.after);
+                pstmt->setInt(2, static_cast<int32_t>(page.limit + 1));
+            }
+            else {
+                pstmt = conn.prepare(
+                    "SELECT student_id, name, surname FROM students WHERE student_id > ? "
+                    "AND (name LIKE ? OR surname LIKE ?) ORDER BY student_id LIMIT ?");
+                std::string pattern = likePrefix(page.prefix);
+                pstmt->setInt(1, page.after);
+                pstmt->setString(2, pattern);
+                pstmt->setString(3, pattern);
+                pstmt->setInt(4, static_cast<int32_t>(page.limit + 1));
+            }
+
+            // Paimame viena eilute daugiau - taip žinome, ar yra kitas puslapis
+            std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            while (res->next()) {
+                students.emplace_back(res->getInt(1), res->getString(2).c_str(), res->getString(3).c_str());
+            }
+            if (students.size() > page.limit) {
+                students.pop_back();
+                has_more = true;
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+        }
+
+        return students;
+    }
+
+    // Pridėti dėstytoją į duomenų bazę
+    std::string addTeacherToDatabase(MySQLDatabase& db, const std::string& name, const std::string& surname) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Klaida: nepavyko prisijungti prie duomenų bazės.";
+        }
+
+        try {
+            // Patikrinti, ar dėstytojas jau egzistuoja
+            sql::PreparedStatement* checkTeacherStmt =
+                con.prepare("SELECT COUNT(*) FROM teachers WHERE name = ? AND surname = ?");
+            checkTeacherStmt->setString(1, name);
+            checkTeacherStmt->setString(2, surname);
+            unique_ptr<sql::ResultSet> teacherRes(checkTeacherStmt->executeQuery());
+            if (teacherRes->next() && teacherRes->getInt(1) > 0) {
+                return "Dėstytojas jau egzistuoja: " + name + " " + surname;
+            }
+
+            // Patikrinti, ar studentas jau egzistuoja su tokiu pačiu vardu ir pavarde
+            sql::PreparedStatement* checkStudentStmt =
+                con.prepare("SELECT COUNT(*) FROM students WHERE name = ? AND surname = ?");
+            checkStudentStmt->setString(1, name);
+            checkStudentStmt->setString(2, surname);
+            unique_ptr<sql::ResultSet> studentRes(checkStudentStmt->executeQuery());
+            if (studentRes->next() && studentRes->getInt(1) > 0) {
+                return "Studentas su tokiu vardu ir pavarde jau egzistuoja: " + name + " " + surname;
+            }
+
+            // Pridėti naują dėstytoją
+            sql::PreparedStatement* pstmt = con.prepare(
+                "INSERT INTO teachers (name, surname, role, username, password) VALUES (?, ?, ?, ?, ?)");
+            pstmt->setString(1, name);
+            pstmt->setString(2, surname);
+            pstmt->setString(3, "Destytojas");  // Rolė - Studentas
+            pstmt->setString(4, name.substr(0, 1) + name.substr(1));  // username (pirmoji vardo raidė)
+            pstmt->setString(5, surname);  // Slaptažodis = pavardė
+
+            pstmt->executeUpdate();
+            db.touch(MySQLDatabase::Table::Teachers);
+            return "Destytojas pridėtas sėkmingai!";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida pridedant dėstytoją: " + std::string(e.what());
+        }
+    }
+
+    // Metodas, kuris pašalina dėstytoją ir jo priskyrimus dalykams (jei jis egzistuoja)
+    std::string removeTeacherFromDatabase(MySQLDatabase& db, int teacher_id) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenų bazės.";
+        }
+
+        try {
+            if (cascadeDelete(db, con, kTeacherCascade, { teacher_id }) == 0) {
+                return "Destytojas su tokiu ID nerastas!";
+            }
+            // Pašalintas vartotojas nebeturi galėti prisijungti iš talpyklos
+            db.invalidateLoginCache();
+            return "Destytojas pasalintas sekmingai!";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant destytoja: " + std::string(e.what());
+        }
+    }
+
+    // Pašalinti kelis dėstytojus vienu kartu
+    std::string removeTeachersFromDatabase(MySQLDatabase& db, const std::vector<int>& teacher_ids) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenų bazės.";
+        }
+
+        try {
+            std::size_t deleted = cascadeDelete(db, con, kTeacherCascade, teacher_ids);
+            if (deleted > 0) {
+                db.invalidateLoginCache();
+            }
+            return "Pasalinta destytoju: " + std::to_string(deleted) + " is " + std::to_string(teacher_ids.size()) + " nurodytu.";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant destytoja: " + std::string(e.what());
+        }
+    }
+
+    // Randame dėstytojų info iš DB.
+    std::vector<std::tuple<int, std::string, std::string>> getAllTeachers(MySQLDatabase::ConnectionLease& con) {
+        std::vector<std::tuple<int, std::string, std::string>> teachers;
+
+        try {
+            sql::PreparedStatement* pstmt =
+                con.prepare("SELECT teacher_id, name, surname FROM teachers");
+            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+            while (res->next()) {
+                int teacher_id = res->getInt("teacher_id");
+                std::string name = res->getString("name").c_str();
+                std::string surname = res->getString("surname").c_str();
+
+                teachers.emplace_back(teacher_id, name, surname);
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Klaida gaunant dėstytojus: " << e.what();
+        }
+
+        return teachers;
+    }
+
+    // CSV importo ataskaita: kiek eilučių apdorota, įterpta ir kurios atmestos
+    struct ImportReport {
+        size_t rows = 0;
+        size_t inserted = 0;
+        size_t duplicates = 0;
+        size_t rejected = 0;
+        size_t batches = 0;
+        std::vector<std::pair<size_t, std::string>> errors;  // eilutės numeris ir priežastis
+        std::string failure;  // ne tuščias, jei visas importas atšauktas
+    };
+
+    static constexpr size_t kImportBatchRows = 200;  // eilučių viename INSERT sakinyje
+    static constexpr size_t kImportMaxErrors = 500;  // daugiau klaidų eilučių neišsaugome
+
+    // Importuoti studentus arba dėstytojus iš CSV (vardas,pavarde kiekvienoje eilutėje).
+    // Eilutės skaitomos po vieną tiesiai iš csv (be kopijų), o įrašymui atmintyje laikomas tik einamasis paketas.
+    // Pats failas nėra srautinis: Crow visą užklausą perskaito prieš kviesdamas maršrutą, todėl jos dydį
+    // riboja kMaxRequestBody (app.max_body_size).
+    ImportReport importPeopleFromCsv(MySQLDatabase& db, std::string_view csv, bool teachers) {
+        ImportReport report;
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            report.failure = "Nepavyko prisijungti prie duomenu bazes.";
+            return report;
+        }
+
+        const std::string table = teachers ? "teachers" : "students";
+        const std::string role = teachers ? "Destytojas" : "Studentas";
+
+        auto addError = [&report](size_t line_no, std::string reason) {
+            ++report.rejected;
+            if (report.errors.size() < kImportMaxErrors) {
+                report.errors.emplace_back(line_no, std::move(reason));
+            }
+        };
+
+        try {
+            // Esami vardai įkeliami vieną kartą, vietoj dviejų COUNT(*) kiekvienai eilutei
+            std::unordered_set<std::string> known;
+            sql::PreparedStatement* pstmt_names = con.prepare(
+                "SELECT name, surname FROM students UNION ALL SELECT name, surname FROM teachers");
+            unique_ptr<sql::ResultSet> res(pstmt_names->executeQuery());
+            while (res->next()) {
+                known.insert(personKey(res->getString(1).c_str(), res->getString(2).c_str()));
+            }
+
+            std::vector<std::pair<std::string, std::string>> pending;
+            pending.reserve(kImportBatchRows);
+
+            auto flush = [&]() {
+                if (pending.empty()) return;
+                std::string sql = "INSERT INTO " + table + " (name, surname, role, username, password) VALUES ";
+                for (size_t i = 0; i < pending.size(); ++i) {
+                    sql += i == 0 ? "(?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?)";
+                }
+                // Pilni paketai visada turi tą patį tekstą, todėl paruoštas sakinys imamas iš talpyklos
+                sql::PreparedStatement* pstmt = con.prepare(sql);
+                int param = 1;
+                for (const auto& person : pending) {
+                    pstmt->setString(param++, person.first);
+                    pstmt->setString(param++, person.second);
+                    pstmt->setString(param++, role);
+                    pstmt->setString(param++, person.first);   // username = vardas
+                    pstmt->setString(param++, person.second);  // Slaptažodis = pavardė
+                }
+                pstmt->executeUpdate();
+                report.inserted += pending.size();
+                ++report.batches;
+                pending.clear();
+            };
+
+            con->setAutoCommit(false);
+            try {
+                std::vector<std::string> fields;
+                size_t line_no = 0;
+                bool first_row = true;
+                size_t pos = 0;
+                while (pos < csv.size()) {
+                    size_t end = csv.find('\n', pos);
+                    if (end == std::string_view::npos) end = csv.size();
+                    std::string_view line = csv.substr(pos, end - pos);
+                    pos = end + 1;
+                    ++line_no;
+
+                    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                    splitCsvLine(line, fields);
+                    if (fields.size() == 1 && fields[0].empty()) continue;  // tuščia eilutė
+
+                    // Pirmoji eilutė gali būti antraštė
+                    if (first_row) {
+                        first_row = false;
+                        std::string head = lowerAscii(fields[0]);
+                        if (head == "vardas" || head == "name") continue;
+                    }
+
+                    ++report.rows;
+                    if (fields.size() != 2) {
+                        addError(line_no, "Tikimasi dvieju stulpeliu: vardas,pavarde");
+                        continue;
+                    }
+                    if (fields[0].empty() || fields[1].empty()) {
+                        addError(line_no, "Vardas ir pavarde negali buti tusti");
+                        continue;
+                    }
+                    if (!known.insert(personKey(fields[0], fields[1])).second) {
+                        ++report.duplicates;
+                        addError(line_no, "Jau egzistuoja: " + fields[0] + " " + fields[1]);
+                        continue;
+                    }
+
+                    pending.emplace_back(std::move(fields[0]), std::move(fields[1]));
+                    if (pending.size() == kImportBatchRows) flush();
+                }
+                flush();
+                con->commit();
+                con->setAutoCommit(true);
+                if (report.inserted > 0) {
+                    db.touch(teachers ? MySQLDatabase::Table::Teachers : MySQLDatabase::Table::Students);
+                }
+            }
+            catch (sql::SQLException&) {
+                con->rollback();
+                con->setAutoCommit(true);
+                throw;
+            }
+        }
+        catch (sql::SQLException& e) {
+            report.inserted = 0;
+            report.failure = "Klaida importuojant, niekas neissaugota: " + std::string(e.what());
+        }
+
+        return report;
+    }
+
+private:
+    // Kaskadinio trynimo aprašas: tėvinė lentelė ir priklausomų lentelių sakiniai (be " IN (...)" pabaigos).
+    // Priklausomi sakiniai vykdomi tik tada, kai schemoje nėra ON DELETE CASCADE raktų.
+    struct CascadeSpec {
+        const char* table;
+        const char* key;
+        std::vector<std::string> dependents;
+        std::vector<MySQLDatabase::Table> touched;  // kurių lentelių versijas padidinti po trynimo
+        bool touch_students;                        // ar ID yra studentų - tada padidinti ir jų juostų versijas
+    };
+
+    inline static const CascadeSpec kStudentCascade{ "students", "student_id", {
+        "DELETE FROM grades WHERE student_id",
+        "DELETE FROM students_subjects WHERE student_id",
+        "DELETE FROM group_students WHERE student_id" },
+        { MySQLDatabase::Table::Students, MySQLDatabase::Table::Grades }, true };
+    inline static const CascadeSpec kTeacherCascade{ "teachers", "teacher_id", {
+        "DELETE FROM teacher_subjects WHERE teacher_id" },
+        { MySQLDatabase::Table::Teachers, MySQLDatabase::Table::TeacherSubjects }, false };
+    inline static const CascadeSpec kSubjectCascade{ "subjects", "subject_id", {
+        "DELETE FROM grades WHERE subject_id",
+        "DELETE FROM group_subjects WHERE subject_id",
+        "DELETE FROM students_subjects WHERE subject_id",
+        "DELETE FROM teacher_subjects WHERE subject_id" },
+        { MySQLDatabase::Table::Subjects, MySQLDatabase::Table::GroupSubjects, MySQLDatabase::Table::TeacherSubjects,
+          MySQLDatabase::Table::Grades }, false };
+    inline static const CascadeSpec kGroupCascade{ "stud_groups", "group_id", {
+        "UPDATE students SET group_id = NULL WHERE group_id",
+        "DELETE FROM group_subjects WHERE group_id",
+        "DELETE FROM group_students WHERE group_id" },
+        { MySQLDatabase::Table::Groups, MySQLDatabase::Table::Students, MySQLDatabase::Table::GroupSubjects }, false };
+
+    static constexpr std::size_t kDeleteChunk = 500;  // ID viename IN (...) sąraše
+
+    // Ištrina nurodytus ID ir jų priklausomas eilutes vienoje transakcijoje.
+    // Grąžina ištrintų tėvinių eilučių skaičių; jei nieko nerasta, transakcija atšaukiama.
+    static std::size_t cascadeDelete(MySQLDatabase& db, MySQLDatabase::ConnectionLease& con,
+        const CascadeSpec& spec, std::vector<int> ids) {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        if (ids.empty()) {
+            return 0;
+        }
+
+        const bool schema_cascades = db.hasCascadeForeignKeys(con);
+        std::size_t deleted = 0;
+
+        con->setAutoCommit(false);
+        try {
+            for (std::size_t begin = 0; begin < ids.size(); begin += kDeleteChunk) {
+                const std::size_t count = std::min(kDeleteChunk, ids.size() - begin);
+                std::string in_list = " IN (?";
+                for (std::size_t i = 1; i < count; ++i) {
+                    in_list += ", ?";
+                }
+                in_list += ")";
+
+                auto run = [&](const std::string& sql) -> std::size_t {
+                    // Vieno ID sakiniai kartojasi, todėl imami iš talpyklos; ilgi sąrašai - vienkartiniai
+                    std::unique_ptr<sql::PreparedStatement> owned;
+                    sql::PreparedStatement* pstmt;
+                    if (count == 1) {
+                        pstmt = con.prepare(sql);
+                    }
+                    else {
+                        owned.reset(con->prepareStatement(sql));
+                        pstmt = owned.get();
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        pstmt->setInt(static_cast<int32_t>(i + 1), ids[begin + i]);
+                    }
+                    return static_cast<std::size_t>(pstmt->executeUpdate());
+                };
+
+                if (!schema_cascades) {
+                    for (const auto& dependent : spec.dependents) {
+                        run(dependent + in_list);
+                    }
+                }
+                deleted += run(std::string("DELETE FROM ") + spec.table + " WHERE " + spec.key + in_list);
+            }
+
+            if (deleted == 0) {
+                con->rollback();
+            }
+            else {
+                con->commit();
+                for (MySQLDatabase::Table table : spec.touched) {
+                    db.touch(table);
+                }
+                // Studento puslapio ETag neturi priklausyti nuo to, kurių lentelių versijos į jį įeina
+                if (spec.touch_students) {
+                    for (int id : ids) {
+                        db.touchStudent(id);
+                    }
+                }
+            }
+            con->setAutoCommit(true);
+        }
+        catch (sql::SQLException&) {
+            con->rollback();
+            con->setAutoCommit(true);
+            throw;
+        }
+        return deleted;
+    }
+
+    // Raktas vardų aibei; DB lygina be didžiųjų/mažųjų raidžių skirtumo, todėl ir mes
+    static std::string personKey(const std::string& name, const std::string& surname) {
+        return lowerAscii(name) + '\x1f' + lowerAscii(surname);
+    }
+
+    // LIKE šablonas "prefix%", kuriame vartotojo % ir _ neturi specialios reikšmės
+    static std::string likePrefix(const std::string& prefix) {
+        std::string pattern;
+        pattern.reserve(prefix.size() + 1);
+        for (char c : prefix) {
+            if (c == '%' || c == '_' || c == '\\') pattern += '\\';
+            pattern += c;
+        }
+        return pattern + '%';
+    }
+
+    static std::string lowerAscii(std::string text) {
+        for (char& c : text) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        return text;
+    }
+
+    // Išskaido CSV eilutę; palaikomi ',' ir ';' skyrikliai bei kabutėse esantys laukai
+    static void splitCsvLine(std::string_view line, std::vector<std::string>& fields) {
+        fields.clear();
+        fields.emplace_back();
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                    fields.back() += '"';
+                    ++i;
+                }
+                else if (c == '"') {
+                    quoted = false;
+                }
+                else {
+                    fields.back() += c;
+                }
+            }
+            else if (c == '"') {
+                quoted = true;
+            }
+            else if (c == ',' || c == ';') {
+                fields.emplace_back();
+            }
+            else {
+                fields.back() += c;
+            }
+        }
+        for (auto& field : fields) {
+            size_t first = field.find_first_not_of(" \t");
+            size_t last = field.find_last_not_of(" \t");
+            field = first == std::string::npos ? std::string() : field.substr(first, last - first + 1);
+        }
+    }
+
+public:
+
+    // Pridėti dėstytoją į duomenų bazę
+    std::string addSubjectToDatabase(MySQLDatabase& db, const std::string& subject_name) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (con) {
+            try {
+                // Patikrinimas, ar toks dalykas jau egzistuoja
+                sql::PreparedStatement* pstmt_check =
+                    con.prepare("SELECT COUNT(*) FROM subjects WHERE subject_name = ?");
+                pstmt_check->setString(1, subject_name);
+                unique_ptr<sql::ResultSet> res_check(pstmt_check->executeQuery());
+
+                if (res_check->next() && res_check->getInt(1) > 0) {
+                    // Jei dalykas jau egzistuoja
+                    return "Toks dalykas jau egzistuoja!";  // Pranešimas apie klaidą
+                }
+
+                // Jei dalykas neegzistuoja, pridedame į duomenų bazę
+                sql::PreparedStatement* pstmt_insert =
+                    con.prepare("INSERT INTO subjects (subject_name) VALUES (?)");
+                pstmt_insert->setString(1, subject_name);
+                pstmt_insert->executeUpdate();
+                db.touch(MySQLDatabase::Table::Subjects);
+
+                return "Dalykas pridėtas sėkmingai!";  // Sėkmės pranešimas
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida įrašant dalyką: " << e.what();
+                return "Įvyko klaida pridedant dalyką į duomenų bazę.";  // Klaidos pranešimas
+            }
+        }
+        else {
+            return "Nepavyko prisijungti prie duomenų bazės.";  // Klaida dėl ryšio su DB
+        }
+    }
+    // Ištrinti dėstomą dalyką iš DB kartu su pažymiais ir priskyrimais.
+    std::string deleteSubjectFromDatabase(MySQLDatabase& db, int subject_id) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenų bazės.";
+        }
+
+        try {
+            if (cascadeDelete(db, con, kSubjectCascade, { subject_id }) == 0) {
+                return "Dalykas su ID " + std::to_string(subject_id) + " nerastas.";
+            }
+            return "Dalykas su ID " + std::to_string(subject_id) + " pašalintas sėkmingai.";
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Klaida trinant dalyką: " << e.what();
+            return "Įvyko klaida trinant dalyką: " + std::string(e.what());
+        }
+    }
+
+    // Ištrinti kelis dalykus vienu kartu
+    std::string deleteSubjectsFromDatabase(MySQLDatabase& db, const std::vector<int>& subject_ids) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenų bazės.";
+        }
+
+        try {
+            std::size_t deleted = cascadeDelete(db, con, kSubjectCascade, subject_ids);
+            return "Pasalinta dalyku: " + std::to_string(deleted) + " is " + std::to_string(subject_ids.size()) + " nurodytu.";
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Klaida trinant dalyką: " << e.what();
+            return "Įvyko klaida trinant dalyką: " + std::string(e.what());
+        }
+    }
+    // Gauname visus dėstomus dalykus iš DB.
+    std::vector<std::tuple<int, std::string>> getSubjectsFromDatabase(MySQLDatabase::ConnectionLease& con) {
+        std::vector<std::tuple<int, std::string>> subjects;
+
+        if (con) {
+            try {
+                sql::PreparedStatement* pstmt =
+                    con.prepare("SELECT subject_id, subject_name FROM subjects");
+                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                // Įkrauname duomenis į vektorių
+                while (res->next()) {
+                    int subject_id = res->getInt("subject_id");
+                    std::string subject_name = res->getString("subject_name").c_str();
+
+                    // Pridedame tuple į vektorių
+                    subjects.push_back(std::make_tuple(subject_id, subject_name));
+                }
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+            }
+        }
+        else {
+            CROW_LOG_ERROR << "Nepavyko prisijungti prie duomenų bazės!";
+        }
+
+        return subjects;  // Grąžiname vektorių su dalykais
+    }
+
+    // Pridėjimo grupės funkcija (gavimas duomenų iš db). 
+    std::string addGroupToDatabase(MySQLDatabase& db, const std::string& group_name) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        bool group_exists = false;
+        std::string response_body;
+
+        if (!con) {
+            return "<html><body>Nepavyko prisijungti prie duomenu bazes.</body></html>";
+        }
+
+        try {
+            // Patikriname, ar grupė jau egzistuoja
+            sql::PreparedStatement* pstmt =
+                con.prepare("SELECT COUNT(*) FROM stud_groups WHERE group_name = ?");
+            pstmt->setString(1, group_name);
+            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            if (res->next() && res->getInt(1) > 0) {
+                group_exists = true;
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+        }
+
+        if (group_exists) {
+            // Jei grupė jau egzistuoja
+            response_body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
+                "Tokia grupe jau egzistuoja! "
+                "<br></body></html>";
+        }
+        else {
+            // Jei grupė neegzistuoja, pridedame ją į duomenų bazę
+            try {
+                sql::PreparedStatement* pstmt_insert =
+                    con.prepare("INSERT INTO stud_groups (group_name) VALUES (?)");
+                pstmt_insert->setString(1, group_name);
+                pstmt_insert->executeUpdate();
+                db.touch(MySQLDatabase::Table::Groups);
+
+                response_body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
+                    "Grupe prideta sekmingai! "
+                    "<br></body></html>";
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida uzklausoje irasant grupe: " << e.what();
+                response_body = "<html><body>Klaida pridedant grupe.</body></html>";
+            }
+        }
+
+        return response_body;
+    }
+    // Metodas panaikinti grupes iš DB (studentų group_id nustatomas NULL).
+    std::string removeGroupFromDatabase(MySQLDatabase& db, int group_id) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            if (cascadeDelete(db, con, kGroupCascade, { group_id }) == 0) {
+                return "Grupe su tokiu ID nerasta!";
+            }
+            return "Grupe su ID " + std::to_string(group_id) + " pasalinta sekmingai.";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant grupe: " + std::string(e.what());
+        }
+    }
+
+    // Pašalinti kelias grupes vienu kartu
+    std::string removeGroupsFromDatabase(MySQLDatabase& db, const std::vector<int>& group_ids) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            std::size_t deleted = cascadeDelete(db, con, kGroupCascade, group_ids);
+            return "Pasalinta grupiu: " + std::to_string(deleted) + " is " + std::to_string(group_ids.size()) + " nurodytu.";
+        }
+        catch (sql::SQLException& e) {
+            return "Klaida trinant grupe: " + std::string(e.what());
+        }
+    }
+
+    // Funkcija, kuri gauna grupių informaciją iš duomenų bazės ir grąžina vektorių su grupėmis
+    std::vector<std::tuple<int, std::string>> getAllGroupsFromDatabase(MySQLDatabase::ConnectionLease& con) {
+        std::vector<std::tuple<int, std::string>> groups;
+
+        if (con) {
+            try {
+                // Atlieka užklausą, kad gautų grupių informaciją
+                sql::PreparedStatement* pstmt =
+                    con.prepare("SELECT group_id, group_name FROM stud_groups");
+                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                // Užpildo vektorių su grupių ID ir pavadinimais
+                while (res->next()) {
+                    int group_id = res->getInt("group_id");
+                    std::string group_name = res->getString("group_name").c_str();
+
+                    groups.push_back(std::make_tuple(group_id, group_name));  // Prideda į vektorių kaip tuple
+                }
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+            }
+        }
+        return groups;  // Grąžina vektorių su grupėmis
+    }
+
+    // Pridėti dėstytoją į duomenų bazę
+    std::string addTeacherAndSubjectToDatabase(MySQLDatabase& db, int teacher_id, int subject_id) {
+        // Prisijungimas prie MariaDB duomenų bazės
+        MySQLDatabase::ConnectionLease con = db.acquire();
+
+        if (!con) {
+            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // 1. Tikriname, ar teacher_id egzistuoja
+            sql::PreparedStatement* check_teacher = con.prepare(
+                "SELECT COUNT(*) FROM teachers WHERE teacher_id = ?");
+            check_teacher->setInt(1, teacher_id);
+            std::unique_ptr<sql::ResultSet> teacher_res(check_teacher->executeQuery());
+            bool teacher_exists = teacher_res->next() && teacher_res->getInt(1) > 0;
+
+            // 2. Tikriname, ar subject_id egzistuoja
+            sql::PreparedStatement* check_subject = con.prepare(
+                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?");
+            check_subject->setInt(1, subject_id);
+            std::unique_ptr<sql::ResultSet> subject_res(check_subject->executeQuery());
+            bool subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+
+            // 3. Jei bet kuris neegzistuoja, grąžiname klaidą
+            if (!teacher_exists) {
+                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " neegzistuoja.";
+            }
+
+            if (!subject_exists) {
+                return "Klaida: Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+            }
+
+            // 4. Patikriname, ar jau egzistuoja ryšys tarp dėstytojo ir dalyko
+            sql::PreparedStatement* check_relation = con.prepare(
+                "SELECT COUNT(*) FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?");
+            check_relation->setInt(1, teacher_id);
+            check_relation->setInt(2, subject_id);
+            std::unique_ptr<sql::ResultSet> relation_res(check_relation->executeQuery());
+            bool relation_exists = relation_res->next() && relation_res->getInt(1) > 0;
+
+            if (relation_exists) {
+                return "Klaida: Sis dalykas jau priskirtas destytojui su ID " + std::to_string(teacher_id) + ".";
+            }
+
+            // 5. Jei visi patikrinimai praeina, atliekame įrašą į teacher_subjects
+            sql::PreparedStatement* insert_relation = con.prepare(
+                "INSERT INTO teacher_subjects (teacher_id, subject_id) VALUES (?, ?)");
+            insert_relation->setInt(1, teacher_id);
+            insert_relation->setInt(2, subject_id);
+            insert_relation->executeUpdate();
+            db.touch(MySQLDatabase::Table::TeacherSubjects);
+
+            return "success"; // Visos operacijos buvo atliktos sėkmingai
+        }
+        catch (sql::SQLException& e) {
+            return "SQL klaida: " + std::string(e.what());
+        }
+    }
+
+    // Pašalinti dėstytoją iš dalyko
+    std::string removeTeacherAndSubjectFromDatabase(MySQLDatabase& db, int teacher_id, int subject_id) {
+        // Prisijungimas prie MariaDB duomenų bazės
+        MySQLDatabase::ConnectionLease con = db.acquire();
+
+        if (!con) {
+            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // 1. Patikriname, ar egzistuoja dėstytojas ir dalykas
+            sql::PreparedStatement* check_teacher = con.prepare(
+                "SELECT COUNT(*) FROM teachers WHERE teacher_id = ?");
+            check_teacher->setInt(1, teacher_id);
+            std::unique_ptr<sql::ResultSet> teacher_res(check_teacher->executeQuery());
+            bool teacher_exists = teacher_res->next() && teacher_res->getInt(1) > 0;
+
+            sql::PreparedStatement* check_subject = con.prepare(
+                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?");
+            check_subject->setInt(1, subject_id);
+            std::unique_ptr<sql::ResultSet> subject_res(check_subject->executeQuery());
+            bool subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+
+            // 2. Jei dėstytojas arba dalykas neegzistuoja
+            if (!teacher_exists) {
+                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " neegzistuoja.";
+            }
+
+            if (!subject_exists) {
+                return "Klaida: Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+            }
+
+            // 3. Tikriname, ar egzistuoja ryšys tarp dėstytojo ir dalyko
+            sql::PreparedStatement* check_relationship = con.prepare(
+                "SELECT COUNT(*) FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?");
+            check_relationship->setInt(1, teacher_id);
+            check_relationship->setInt(2, subject_id);
+            std::unique_ptr<sql::ResultSet> relationship_res(check_relationship->executeQuery());
+            bool relationship_exists = relationship_res->next() && relationship_res->getInt(1) > 0;
+
+            if (!relationship_exists) {
+                return "Klaida: Destytojas su ID " + std::to_string(teacher_id) + " ir dalykas su ID " +
+                    std::to_string(subject_id) + " nera priskirti.";
+            }
+
+            // 4. Pašaliname ryšį iš teacher_subjects lentelės
+            sql::PreparedStatement* pstmt = con.prepare(
+                "DELETE FROM teacher_subjects WHERE teacher_id = ? AND subject_id = ?");
+            pstmt->setInt(1, teacher_id);
+            pstmt->setInt(2, subject_id);
+
+            int affectedRows = pstmt->executeUpdate();
+            if (affectedRows > 0) {
+                db.touch(MySQLDatabase::Table::TeacherSubjects);
+                return "success"; // Ryšys buvo sėkmingai pašalintas
+            }
+            else {
+                return "Klaida: Nepavyko pašalinti ryšio.";
+            }
+        }
+        catch (sql::SQLException& e) {
+            return "SQL klaida: " + std::string(e.what());
+        }
+    }
+
+    // Funkcija, kuri grąžina vektorių su dėstytojo ir dalyko informacija (ok == false - užklausa nepavyko)
+    std::vector<std::tuple<int, std::string, std::string, int, std::string>> getTeacherSubjectInfo(MySQLDatabase::ConnectionLease& con, bool& ok) {
+        std::vector<std::tuple<int, std::string, std::string, int, std::string>> teacherSubjectInfo;  // Vektorius su tuple..:)
+        ok = false;
+
+        if (con) {
+            try {
+                // Atlieka užklausą, kad gautų dėstytojų ir jų priskirtų dalykų informaciją
+                sql::PreparedStatement* pstmt =
+                    con.prepare("SELECT t.teacher_id, t.name, t.surname, s.subject_id, s.subject_name "
+                        "FROM teachers t "
+                        "LEFT JOIN teacher_subjects ts ON t.teacher_id = ts.teacher_id "
+                        "LEFT JOIN subjects s ON ts.subject_id = s.subject_id");
+                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                // Užpildo vektorių su dėstytojų ir dalykų informacija
+                while (res->next()) {
+                    int teacher_id = res->getInt("teacher_id");
+                    std::string teacher_name = res->getString("name").c_str();
+                    std::string teacher_surname = res->getString("surname").c_str();
+                    int subject_id = res->getInt("subject_id");
+                    std::string subject_name = res->getString("subject_name").c_str();
+
+                    // Jei dalykas nepriskirtas, įrašome "Nera dalyko" (kažkodėl neveikia UTF-8 koduotė)
+                    if (subject_id == 0) {
+                        teacherSubjectInfo.push_back(std::make_tuple(teacher_id, teacher_name, teacher_surname, 0, "Nera dalyko"));
+                    }
+                    else {
+                        teacherSubjectInfo.push_back(std::make_tuple(teacher_id, teacher_name, teacher_surname, subject_id, subject_name));
+                    }
+                }
+                ok = true;
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida uzklausoje: " << e.what();
+            }
+        }
+
+        return teacherSubjectInfo;  // Grąžina vektorių su dėstytojo ir dėstomo dalyko informacija
+    }
+
+    // Pridedame studentus su grupe.
+    std::string addGroupAndStudentToDatabase(MySQLDatabase& db, int group_id, int student_id) {
+        // Prisijungimas prie MariaDB
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return "Klaida: Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // Patikriname, ar group_id egzistuoja
+            sql::PreparedStatement* check_group = con.prepare(
+                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?");
+            check_group->setInt(1, group_id);
+            std::unique_ptr<sql::ResultSet> group_res(check_group->executeQuery());
+            bool group_exists = group_res->next() && group_res->getInt(1) > 0;
+
+            // Patikriname, ar student_id egzistuoja
+            sql::PreparedStatement* check_student = con.prepare(
+                "SELECT COUNT(*) FROM students WHERE student_id = ?");
+            check_student->setInt(1, student_id);
+            std::unique_ptr<sql::ResultSet> student_res(check_student->executeQuery());
             bool student_exists = student_res->next() && student_res->getInt(1) > 0;
 
-            // Grąžiname klaidą, jei bet kuris neegzistuoja
+            // Grąžiname klaidą, jei bet kuris neegzistuoja
+            if (!group_exists) {
+                return "Klaida: Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
+            }
+
+            if (!student_exists) {
+                return "Klaida: Studentas su ID " + std::to_string(student_id) + " neegzistuoja.";
+            }
+
+            // Tikriname, ar studentas jau priskirtas grupei
+            sql::PreparedStatement* pstmt_check_group = con.prepare(
+                "SELECT group_id FROM students WHERE student_id = ?");
+            pstmt_check_group->setInt(1, student_id);
+            std::unique_ptr<sql::ResultSet> check_group_res(pstmt_check_group->executeQuery());
+            if (check_group_res->next() && !check_group_res->isNull(1)) {
+                return "Klaida: Studentas su ID " + std::to_string(student_id) + " jau priskirtas kitai grupei.";
+            }
+
+            // Priskiriame studentą grupei ir atnaujiname lentelę
+            sql::PreparedStatement* insert_group_student = con.prepare(
+                "INSERT INTO group_students (group_id, student_id) VALUES (?, ?)");
+            insert_group_student->setInt(1, group_id);
+            insert_group_student->setInt(2, student_id);
+            insert_group_student->executeUpdate();
+
+            // Atnaujiname students.group_id
+            sql::PreparedStatement* update_student_group = con.prepare(
+                "UPDATE students SET group_id = ? WHERE student_id = ?");
+            update_student_group->setInt(1, group_id);
+            update_student_group->setInt(2, student_id);
+            update_student_group->executeUpdate();
+
+            // Priskiriame studentui dalyką (subject)
+            sql::PreparedStatement* pstmt_subjects = con.prepare(
+                "INSERT INTO students_subjects (student_id, subject_id) "
+                "SELECT ?, subject_id FROM group_subjects WHERE group_id = ?");
+            pstmt_subjects->setInt(1, student_id);
+            pstmt_subjects->setInt(2, group_id);
+            pstmt_subjects->executeUpdate();
+
+
+            db.touch(MySQLDatabase::Table::Students);
+            db.touchStudent(student_id);
+            return "Grupe su ID " + std::to_string(group_id) + " buvo priskirta studentui su ID " + std::to_string(student_id) + "!";
+        }
+        catch (sql::SQLException& e) {
+            return "SQL klaida: " + std::string(e.what());
+        }
+    }
+    // Panaikinti sąryšį tarp studentų ir grupės.
+    std::pair<int, std::string> removeGroupAndStudentFromDatabase(MySQLDatabase& db, int group_id, int student_id) {
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (!con) {
+            return { 500, "Klaida: Nepavyko prisijungti prie duomenų bazės." };
+        }
+
+        try {
+            // Tikriname, ar egzistuoja grupė
+            bool group_exists = false, student_exists = false, student_in_group = false;
+
+            sql::PreparedStatement* pstmt_group = con.prepare(
+                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?");
+            pstmt_group->setInt(1, group_id);
+            std::unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
+            group_exists = group_res->next() && group_res->getInt(1) > 0;
+
+            // Tikriname, ar egzistuoja studentas
+            sql::PreparedStatement* pstmt_student = con.prepare(
+                "SELECT COUNT(*) FROM students WHERE student_id = ?");
+            pstmt_student->setInt(1, student_id);
+            std::unique_ptr<sql::ResultSet> student_res(pstmt_student->executeQuery());
+            student_exists = student_res->next() && student_res->getInt(1) > 0;
+
+            // Tikriname, ar studentas yra priskirtas grupei
+            sql::PreparedStatement* pstmt_in_group = con.prepare(
+                "SELECT COUNT(*) FROM group_students WHERE group_id = ? AND student_id = ?");
+            pstmt_in_group->setInt(1, group_id);
+            pstmt_in_group->setInt(2, student_id);
+            std::unique_ptr<sql::ResultSet> in_group_res(pstmt_in_group->executeQuery());
+            student_in_group = in_group_res->next() && in_group_res->getInt(1) > 0;
+
+            // Grąžiname klaidų pranešimus, jei sąlygos nesutampa
             if (!group_exists) {
-                delete con; // Atlaisviname jungtį
-                return "Klaida: Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
+                return { 400, "Grupe su ID " + std::to_string(group_id) + " neegzistuoja!" };
+            }
+            if (!student_exists) {
+                return { 400, "Studentas su ID " + std::to_string(student_id) + " neegzistuoja!" };
+            }
+            if (!student_in_group) {
+                return { 400, "Studentas su ID " + std::to_string(student_id) + " nera priskirtas grupei su ID " + std::to_string(group_id) + "!" };
+            }
+
+            // Jei sąlygos tenkinamos, pašaliname duomenis
+            sql::PreparedStatement* pstmt_remove_group = con.prepare(
+                "DELETE FROM group_students WHERE group_id = ? AND student_id = ?");
+            pstmt_remove_group->setInt(1, group_id);
+            pstmt_remove_group->setInt(2, student_id);
+            pstmt_remove_group->executeUpdate();
+
+            // Pašaliname studentą iš students_subjects lentelės
+            sql::PreparedStatement* pstmt_remove_subject = con.prepare(
+                "DELETE FROM students_subjects WHERE student_id = ? AND subject_id IN "
+                "(SELECT subject_id FROM group_subjects WHERE group_id = ?)");
+            pstmt_remove_subject->setInt(1, student_id);
+            pstmt_remove_subject->setInt(2, group_id);
+            pstmt_remove_subject->executeUpdate();
+
+            // Atnaujiname students lentelę (group_id -> NULL)
+            sql::PreparedStatement* pstmt_update_student = con.prepare(
+                "UPDATE students SET group_id = NULL WHERE student_id = ?");
+            pstmt_update_student->setInt(1, student_id);
+            pstmt_update_student->executeUpdate();
+            db.touch(MySQLDatabase::Table::Students);
+            db.touchStudent(student_id);
+
+            return { 200, "Studentas su ID " + std::to_string(student_id) + " buvo pasalintas is grupes su ID " + std::to_string(group_id) + "!" };
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "SQL klaida: " << e.what();
+            return { 500, "Klaida salinant is duomenu bazes." };
+        }
+    }
+    // Gauname studentų su grupėmis sąrašą iš DB (ok == false - užklausa nepavyko).
+    std::vector<std::tuple<int, std::string, std::string, int, std::string>> getStudentGroupInfoFromDatabase(MySQLDatabase::ConnectionLease& con, bool& ok) {
+        std::vector<std::tuple<int, std::string, std::string, int, std::string>> studentGroupInfo;  
+        ok = false;
+
+        if (con) {
+            try {
+                // Atlieka užklausą, kad gautų studentų ir grupių informaciją
+                sql::PreparedStatement* pstmt =
+                    con.prepare("SELECT t.student_id, t.name, t.surname, s.group_id, s.group_name "
+                        "FROM students t "
+                        "LEFT JOIN group_students ts ON t.student_id = ts.student_id "
+                        "LEFT JOIN stud_groups s ON ts.group_id = s.group_id");
+                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                // Užpildo vektorių su studentų ir grupių informacija
+                while (res->next()) {
+                    int student_id = res->getInt("student_id");
+                    std::string student_name = res->getString("name").c_str();
+                    std::string student_surname = res->getString("surname").c_str();
+                    int group_id = res->getInt("group_id");
+                    std::string group_name = res->getString("group_name").c_str();
+
+                    // Įrašo į vektorių tuple su studento ir grupės informacija
+                    studentGroupInfo.push_back(std::make_tuple(student_id, student_name, student_surname, group_id, group_name));
+                }
+                ok = true;
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida užklausoje: " << e.what();
+            }
+        }
+        return studentGroupInfo;  // Grąžina vektorių su studentų ir grupių duomenimis
+    }
+
+    // Pridėti dėstytoją į duomenų bazę
+    std::string addGroupAndSubjectsToDatabase(MySQLDatabase& db, MySQLDatabase::ConnectionLease& con, int group_id, int subject_id) {
+        bool group_exists = false, subject_exists = false;
+
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // Patikriname, ar egzistuoja grupė
+            sql::PreparedStatement* pstmt_group = con.prepare(
+                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?");
+            pstmt_group->setInt(1, group_id);
+            unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
+            group_exists = group_res->next() && group_res->getInt(1) > 0;
+
+            // Patikriname, ar egzistuoja dalykas
+            sql::PreparedStatement* pstmt_subject = con.prepare(
+                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?");
+            pstmt_subject->setInt(1, subject_id);
+            unique_ptr<sql::ResultSet> subject_res(pstmt_subject->executeQuery());
+            subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+
+            // Patikriname, ar grupė jau turi priskirtą šį dalyką
+            sql::PreparedStatement* pstmt_existing_relation = con.prepare(
+                "SELECT COUNT(*) FROM group_subjects WHERE group_id = ? AND subject_id = ?");
+            pstmt_existing_relation->setInt(1, group_id);
+            pstmt_existing_relation->setInt(2, subject_id);
+            unique_ptr<sql::ResultSet> existing_res(pstmt_existing_relation->executeQuery());
+            bool already_assigned = existing_res->next() && existing_res->getInt(1) > 0;
+
+            // Jei jau egzistuoja tas pats ryšys, grąžiname klaidą
+            if (already_assigned) {
+                return "Sis dalykas jau priskirtas grupei su ID " + std::to_string(group_id);
+            }
+
+            // Jei visi patikrinimai praeina, atliekame įrašą į group_subjects
+            if (group_exists && subject_exists) {
+                sql::PreparedStatement* pstmt_add = con.prepare(
+                    "INSERT INTO group_subjects (group_id, subject_id) VALUES (?, ?)");
+                pstmt_add->setInt(1, group_id);
+                pstmt_add->setInt(2, subject_id);
+                pstmt_add->executeUpdate();
+                db.touch(MySQLDatabase::Table::GroupSubjects);
+                return "Dalykas su ID " + std::to_string(subject_id) + " buvo priskirtas grupei su ID " + std::to_string(group_id);
+            }
+            else {
+                if (!group_exists) {
+                    return "Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
+                }
+                if (!subject_exists) {
+                    return "Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+                }
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "SQL klaida: " << e.what();
+            return "Ivyko klaida dirbant su duomenu baze.";
+        }
+
+        return "";
+    }
+
+    // Funkcija, kuri pašalina grupę ir dalyką iš duomenų bazės
+    std::string deleteGroupAndSubjectsFromDatabase(MySQLDatabase& db, MySQLDatabase::ConnectionLease& con, int group_id, int subject_id) {
+        bool group_exists = false, subject_exists = false, group_in_subject = false;
+
+        if (!con) {
+            return "Nepavyko prisijungti prie duomenu bazes.";
+        }
+
+        try {
+            // Patikriname, ar egzistuoja grupė
+            sql::PreparedStatement* pstmt_group = con.prepare(
+                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?");
+            pstmt_group->setInt(1, group_id);
+            unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
+            group_exists = group_res->next() && group_res->getInt(1) > 0;
+
+            // Patikriname, ar egzistuoja dalykas
+            sql::PreparedStatement* pstmt_subject = con.prepare(
+                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?");
+            pstmt_subject->setInt(1, subject_id);
+            unique_ptr<sql::ResultSet> subject_res(pstmt_subject->executeQuery());
+            subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+
+            // Patikriname, ar grupė turi priskirtą šį dalyką
+            sql::PreparedStatement* pstmt_in_subject = con.prepare(
+                "SELECT COUNT(*) FROM group_subjects WHERE group_id = ? AND subject_id = ?");
+            pstmt_in_subject->setInt(1, group_id);
+            pstmt_in_subject->setInt(2, subject_id);
+            unique_ptr<sql::ResultSet> in_subject_res(pstmt_in_subject->executeQuery());
+            group_in_subject = in_subject_res->next() && in_subject_res->getInt(1) > 0;
+
+            // Jei grupė ir dalykas egzistuoja ir grupė yra priskirta šiam dalykui, pašaliname ryšį
+            if (group_exists && subject_exists && group_in_subject) {
+                sql::PreparedStatement* pstmt_remove = con.prepare(
+                    "DELETE FROM group_subjects WHERE group_id = ? AND subject_id = ?");
+                pstmt_remove->setInt(1, group_id);
+                pstmt_remove->setInt(2, subject_id);
+                pstmt_remove->executeUpdate();
+                db.touch(MySQLDatabase::Table::GroupSubjects);
+                return "Grupe su ID " + std::to_string(group_id) + " buvo pasalinta is dalyko su ID " + std::to_string(subject_id);
+            }
+            else {
+                if (!group_exists) {
+                    return "Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
+                }
+                if (!subject_exists) {
+                    return "Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+                }
+                if (!group_in_subject) {
+                    return "Grupe su ID " + std::to_string(group_id) + " nera priskirtas dalykui su ID " + std::to_string(subject_id) + ".";
+                }
+            }
+        }
+        catch (sql::SQLException& e) {
+            CROW_LOG_ERROR << "SQL klaida: " << e.what();
+            return "Įvyko klaida dirbant su duomenų baze.";
+        }
+
+        return "";
+    }
+
+    // Funkcija, kuri grąžina vektorių su grupių ir dalykų duomenimis (ok == false - užklausa nepavyko)
+    std::vector<std::tuple<int, std::string, int, std::string>> getGroupSubjects(MySQLDatabase::ConnectionLease& con, bool& ok) {
+        std::vector<std::tuple<int, std::string, int, std::string>> groupSubjects;
+        ok = false;
+
+        if (con) {
+            try {
+                sql::PreparedStatement* groupSubjectStmt =
+                    con.prepare(
+                        "SELECT g.group_id, g.group_name, s.subject_id, s.subject_name "
+                        "FROM stud_groups g "
+                        "LEFT JOIN group_subjects gs ON g.group_id = gs.group_id "
+                        "LEFT JOIN subjects s ON gs.subject_id = s.subject_id"
+                    );
+                unique_ptr<sql::ResultSet> groupSubjectRes(groupSubjectStmt->executeQuery());
+
+                while (groupSubjectRes->next()) {
+                    int group_id = groupSubjectRes->getInt("group_id");
+                    std::string group_name = groupSubjectRes->getString("group_name").c_str();
+                    int subject_id = groupSubjectRes->getInt("subject_id");
+                    std::string subject_name = groupSubjectRes->getString("subject_name").c_str();
+
+                    // Jei dalykas nepriskirtas, užrašome "Nėra dalyko"
+                    if (subject_id == 0) {
+                        subject_name = "Nera dalyko";
+                    }
+
+                    // Pridedame į vektorių kaip tuple
+                    groupSubjects.push_back(std::make_tuple(group_id, group_name, subject_id, subject_name));
+                }
+                ok = true;
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "SQL klaida: " << e.what();
+            }
+        }
+
+        return groupSubjects;
+    }
+    // Gauname visų grupių info iš DB.
+    vector<pair<int, string>> getAllGroups(MySQLDatabase& db) {
+        std::vector<std::pair<int, std::string>> groups;
+        MySQLDatabase::ConnectionLease con = db.acquire();
+        if (con) {
+            try {
+                sql::PreparedStatement* pstmt = con.prepare(
+                    "SELECT group_id, group_name FROM `stud_groups`"
+                );
+                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+
+                while (res->next()) {
+                    int group_id = res->getInt("group_id");
+                    std::string group_name = res->getString("group_name").c_str();
+                    groups.emplace_back(group_id, group_name);
+                }
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "Klaida gaunant grupes: " << e.what();
             }
+        }
+        return groups;
+    }
+};
 
-            if (!student_exists) {
-                delete con; // Atlaisviname jungtį
-                return "Klaida: Studentas su ID " + std::to_string(student_id) + " neegzistuoja.";
+MySQLDatabase* db = nullptr;
+
+
+
+// Retai besikeičiančių lentelių (dalykų, grupių, dėstytojų) talpykla atmintyje.
+// Skaitytojai užrakto neima: jie atomiškai pasiima nekintamos momentinės kopijos (snapshot) shared_ptr.
+// Kai lentelės versija MySQLDatabase pasikeičia (touch), kopija perkraunama ir atomiškai pakeičiama nauja,
+// o senąją skaitytojai naudoja tol, kol jos reikia.
+class ReferenceCache {
+public:
+    using Subjects = std::vector<std::tuple<int, std::string>>;
+    using Groups = std::vector<std::tuple<int, std::string>>;
+    using Teachers = std::vector<std::tuple<int, std::string, std::string>>;
+
+    explicit ReferenceCache(MySQLDatabase& db) : db_(db) {}
+
+    // current (jei nurodytas) == false, kai perkrauti nepavyko ir grąžinta pasenusi ar tuščia kopija
+
+    std::shared_ptr<const Subjects> subjects(bool* current = nullptr) {
+        return read(subjects_, MySQLDatabase::Table::Subjects, current, [](MySQLDatabase::ConnectionLease& con) {
+            Subjects rows;
+            sql::PreparedStatement* pstmt =
+                con.prepare("SELECT subject_id, subject_name FROM subjects ORDER BY subject_id");
+            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            while (res->next()) {
+                rows.emplace_back(res->getInt(1), res->getString(2).c_str());
             }
+            return rows;
+        });
+    }
 
-            // Tikriname, ar studentas jau priskirtas grupei
-            std::unique_ptr<sql::PreparedStatement> pstmt_check_group(con->prepareStatement(
-                "SELECT group_id FROM students WHERE student_id = ?"));
-            pstmt_check_group->setInt(1, student_id);
-            std::unique_ptr<sql::ResultSet> check_group_res(pstmt_check_group->executeQuery());
-            if (check_group_res->next() && !check_group_res->isNull(1)) {
-                delete con; // Atlaisviname jungtį
-                return "Klaida: Studentas su ID " + std::to_string(student_id) + " jau priskirtas kitai grupei.";
+    std::shared_ptr<const Groups> groups(bool* current = nullptr) {
+        return read(groups_, MySQLDatabase::Table::Groups, current, [](MySQLDatabase::ConnectionLease& con) {
+            Groups rows;
+            sql::PreparedStatement* pstmt =
+                con.prepare("SELECT group_id, group_name FROM stud_groups ORDER BY group_id");
+            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            while (res->next()) {
+                rows.emplace_back(res->getInt(1), res->getString(2).c_str());
             }
+            return rows;
+        });
+    }
 
-            // Priskiriame studentą grupei ir atnaujiname lentelę
-            std::unique_ptr<sql::PreparedStatement> insert_group_student(con->prepareStatement(
-                "INSERT INTO group_students (group_id, student_id) VALUES (?, ?)"));
-            insert_group_student->setInt(1, group_id);
-            insert_group_student->setInt(2, student_id);
-            insert_group_student->executeUpdate();
+    std::shared_ptr<const Teachers> teachers(bool* current = nullptr) {
+        return read(teachers_, MySQLDatabase::Table::Teachers, current, [](MySQLDatabase::ConnectionLease& con) {
+            Teachers rows;
+            sql::PreparedStatement* pstmt =
+                con.prepare("SELECT teacher_id, name, surname FROM teachers ORDER BY teacher_id");
+            unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+            while (res->next()) {
+                rows.emplace_back(res->getInt(1), res->getString(2).c_str(), res->getString(3).c_str());
+            }
+            return rows;
+        });
+    }
 
-            // Atnaujiname students.group_id
-            std::unique_ptr<sql::PreparedStatement> update_student_group(con->prepareStatement(
-                "UPDATE students SET group_id = ? WHERE student_id = ?"));
-            update_student_group->setInt(1, group_id);
-            update_student_group->setInt(2, student_id);
-            update_student_group->executeUpdate();
+private:
+    template <typename T>
+    struct Snapshot {
+        std::uint64_t version;  // lentelės versija, pagal kurią kopija sukurta
+        T rows;
+    };
+
+    template <typename T>
+    struct Slot {
+        std::shared_ptr<const Snapshot<T>> current;  // skaitoma ir keičiama tik per std::atomic_load/atomic_store
+        std::mutex reload_mutex;                     // kad tą pačią lentelę perkrautų tik viena gija
+    };
+
+    // Grąžina eilutes, kurios dalijasi nuosavybe su visa kopija
+    template <typename T>
+    static std::shared_ptr<const T> rowsOf(const std::shared_ptr<const Snapshot<T>>& snapshot) {
+        return std::shared_ptr<const T>(snapshot, &snapshot->rows);
+    }
 
-            // Priskiriame studentui dalyką (subject)
-            std::unique_ptr<sql::PreparedStatement> pstmt_subjects(con->prepareStatement(
-                "INSERT INTO students_subjects (student_id, subject_id) "
-                "SELECT ?, subject_id FROM group_subjects WHERE group_id = ?"));
-            pstmt_subjects->setInt(1, student_id);
-            pstmt_subjects->setInt(2, group_id);
-            pstmt_subjects->executeUpdate();
+    template <typename T, typename Loader>
+    std::shared_ptr<const T> read(Slot<T>& slot, MySQLDatabase::Table table, bool* current, Loader load) {
+        if (current) {
+            *current = true;
+        }
+        std::shared_ptr<const Snapshot<T>> snapshot = std::atomic_load(&slot.current);
+        if (snapshot && snapshot->version == db_.tableVersion(table)) {
+            return rowsOf(snapshot);
+        }
 
-            delete con; // Atlaisviname jungtį
+        std::lock_guard<std::mutex> lock(slot.reload_mutex);
+        // Kol laukėme, kita gija galėjo jau perkrauti
+        const std::uint64_t version = db_.tableVersion(table);
+        snapshot = std::atomic_load(&slot.current);
+        if (snapshot && snapshot->version == version) {
+            return rowsOf(snapshot);
+        }
 
-            return "Grupe su ID " + std::to_string(group_id) + " buvo priskirta studentui su ID " + std::to_string(student_id) + "!";
+        // Versiją paimame prieš užklausą: jei lentelė pasikeis jos metu, kopija iškart pasens
+        try {
+            MySQLDatabase::ConnectionLease con = db_.acquire();
+            if (con) {
+                std::shared_ptr<const Snapshot<T>> fresh =
+                    std::make_shared<const Snapshot<T>>(Snapshot<T>{ version, load(con) });
+                std::atomic_store(&slot.current, fresh);
+                return rowsOf(fresh);
+            }
         }
         catch (sql::SQLException& e) {
-            delete con; // Atlaisviname jungtį klaidos atveju
-            return "SQL klaida: " + std::string(e.what());
+            CROW_LOG_ERROR << "Nepavyko perkrauti talpyklos: " << e.what();
+        }
+
+        // Perkrauti nepavyko - geriau parodyti paskutinę turimą kopiją nei nieko
+        if (current) {
+            *current = false;
         }
+        if (snapshot) {
+            return rowsOf(snapshot);
+        }
+        return std::make_shared<const T>();
     }
-    // Panaikinti sąryšį tarp studentų ir grupės.
-    std::pair<int, std::string> removeGroupAndStudentFromDatabase(MySQLDatabase& db, int group_id, int student_id) {
-        sql::Connection* con = db.connect();
-        if (!con) {
-            return { 500, "Klaida: Nepavyko prisijungti prie duomenų bazės." };
+
+    MySQLDatabase& db_;
+    Slot<Subjects> subjects_;
+    Slot<Groups> groups_;
+    Slot<Teachers> teachers_;
+};
+
+
+// Iš anksto sukompiliuotų puslapių šablonų (crow::mustache) registras.
+// Šablonai įkeliami ir išanalizuojami vieną kartą paleidžiant serverį, todėl užklausos metu
+// kopijuojamos tik statinės dalys ir pildomos dinaminės eilutės.
+class TemplateRegistry {
+public:
+    explicit TemplateRegistry(std::string base_dir) : base_dir_(std::move(base_dir)) {}
+
+    // Įkelia ir sukompiliuoja šabloną. Kviečiama tik prieš app.run(), vėliau registras tik skaitomas.
+    void add(const std::string& name) {
+        std::string source = loadHTML(base_dir_ + name);
+        templates_[name] = std::unique_ptr<Entry>(new Entry(crow::mustache::compile(source), source.size()));
+    }
+
+    // Atvaizduoja šabloną į iš anksto rezervuotą buferį ir grąžina HTML atsakymą
+    crow::response render(const std::string& name, const crow::mustache::context& ctx) const {
+        Tracer::SpanTimer span("render");
+        auto it = templates_.find(name);
+        if (it == templates_.end()) {
+            CROW_LOG_ERROR << "Sablonas neuzregistruotas: " << name;
+            return crow::response(500, "Vidine klaida.");
         }
 
-        try {
-            // Tikriname, ar egzistuoja grupė
-            bool group_exists = false, student_exists = false, student_in_group = false;
+        const Entry& entry = *it->second;
+        std::string body;
+        // Paskutinio atvaizdavimo dydis yra geras spėjimas, kad buferio nereiktų plėsti
+        body.reserve(std::max(entry.source_size, entry.last_size.load(std::memory_order_relaxed)));
+        entry.tmpl.render_to(body, ctx);
+        entry.last_size.store(body.size(), std::memory_order_relaxed);
 
-            std::unique_ptr<sql::PreparedStatement> pstmt_group(con->prepareStatement(
-                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?"));
-            pstmt_group->setInt(1, group_id);
-            std::unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
-            group_exists = group_res->next() && group_res->getInt(1) > 0;
+        crow::response res;
+        res.set_header("Content-Type", "text/html");
+        res.body = std::move(body);
+        return res;
+    }
 
-            // Tikriname, ar egzistuoja studentas
-            std::unique_ptr<sql::PreparedStatement> pstmt_student(con->prepareStatement(
-                "SELECT COUNT(*) FROM students WHERE student_id = ?"));
-            pstmt_student->setInt(1, student_id);
-            std::unique_ptr<sql::ResultSet> student_res(pstmt_student->executeQuery());
-            student_exists = student_res->next() && student_res->getInt(1) > 0;
+private:
+    struct Entry {
+        Entry(crow::mustache::template_t compiled, std::size_t size)
+            : tmpl(std::move(compiled)), source_size(size) {}
 
-            // Tikriname, ar studentas yra priskirtas grupei
-            std::unique_ptr<sql::PreparedStatement> pstmt_in_group(con->prepareStatement(
-                "SELECT COUNT(*) FROM group_students WHERE group_id = ? AND student_id = ?"));
-            pstmt_in_group->setInt(1, group_id);
-            pstmt_in_group->setInt(2, student_id);
-            std::unique_ptr<sql::ResultSet> in_group_res(pstmt_in_group->executeQuery());
-            student_in_group = in_group_res->next() && in_group_res->getInt(1) > 0;
+        crow::mustache::template_t tmpl;
+        std::size_t source_size;
+        mutable std::atomic<std::size_t> last_size{ 0 };
+    };
 
-            // Grąžiname klaidų pranešimus, jei sąlygos nesutampa
-            if (!group_exists) {
-                return { 400, "Grupe su ID " + std::to_string(group_id) + " neegzistuoja!" };
+    std::string base_dir_;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> templates_;
+};
+
+// (ID, pavadinimas) eilutės šablonui: laukai id ir name
+std::vector<crow::mustache::context> namedRows(const std::vector<std::tuple<int, std::string>>& rows) {
+    std::vector<crow::mustache::context> result;
+    result.reserve(rows.size());
+    for (const auto& row : rows) {
+        crow::mustache::context item;
+        item["id"] = std::get<0>(row);
+        item["name"] = std::get<1>(row);
+        result.push_back(std::move(item));
+    }
+    return result;
+}
+
+// (ID, vardas, pavardė) eilutės šablonui: laukai id, name ir surname
+std::vector<crow::mustache::context> personRows(const std::vector<std::tuple<int, std::string, std::string>>& rows) {
+    std::vector<crow::mustache::context> result;
+    result.reserve(rows.size());
+    for (const auto& row : rows) {
+        crow::mustache::context item;
+        item["id"] = std::get<0>(row);
+        item["name"] = std::get<1>(row);
+        item["surname"] = std::get<2>(row);
+        result.push_back(std::move(item));
+    }
+    return result;
+}
+
+// Paprastas {{vardas}} vietų šablonas puslapiams, kurie pildomi keliomis reikšmėmis.
+// Tekstas vieną kartą suskaidomas į pastovias dalis ir vietas, o atvaizduojama vienu
+// praėjimu į tikslaus dydžio buferį. Kaip ir mustache, {{vardas}} reikšmė HTML-ekranuojama,
+// o {{{vardas}}} įstatoma kaip yra (jau paruoštam HTML). Nepateiktos vietos paliekamos kaip buvo.
+class PlaceholderTemplate {
+public:
+    using Values = std::initializer_list<std::pair<std::string_view, std::string_view>>;
+
+    PlaceholderTemplate() = default;
+
+    explicit PlaceholderTemplate(std::string source) : source_(std::move(source)) {
+        std::size_t literal_start = 0;
+        std::size_t open = source_.find("{{");
+        while (open != std::string::npos) {
+            bool raw = open + 2 < source_.size() && source_[open + 2] == '{';
+            std::size_t name_start = open + (raw ? 3 : 2);
+            std::size_t close = source_.find(raw ? "}}}" : "}}", name_start);
+            if (close == std::string::npos) {
+                break;
             }
-            if (!student_exists) {
-                return { 400, "Studentas su ID " + std::to_string(student_id) + " neegzistuoja!" };
+            std::string_view name(source_.data() + name_start, close - name_start);
+            if (!isSlotName(name)) {
+                open = source_.find("{{", open + 2);
+                continue;
             }
-            if (!student_in_group) {
-                return { 400, "Studentas su ID " + std::to_string(student_id) + " nera priskirtas grupei su ID " + std::to_string(group_id) + "!" };
+            std::size_t end = close + (raw ? 3 : 2);
+            if (open > literal_start) {
+                segments_.push_back({ literal_start, open - literal_start, -1, false });
             }
+            segments_.push_back({ open, end - open, slotIndex(name, raw), raw });
+            literal_start = end;
+            open = source_.find("{{", literal_start);
+        }
+        if (literal_start < source_.size()) {
+            segments_.push_back({ literal_start, source_.size() - literal_start, -1, false });
+        }
+    }
 
-            // Jei sąlygos tenkinamos, pašaliname duomenis
-            std::unique_ptr<sql::PreparedStatement> pstmt_remove_group(con->prepareStatement(
-                "DELETE FROM group_students WHERE group_id = ? AND student_id = ?"));
-            pstmt_remove_group->setInt(1, group_id);
-            pstmt_remove_group->setInt(2, student_id);
-            pstmt_remove_group->executeUpdate();
+    const std::string& source() const { return source_; }
 
-            // Pašaliname studentą iš students_subjects lentelės
-            std::unique_ptr<sql::PreparedStatement> pstmt_remove_subject(con->prepareStatement(
-                "DELETE FROM students_subjects WHERE student_id = ? AND subject_id IN "
-                "(SELECT subject_id FROM group_subjects WHERE group_id = ?)"));
-            pstmt_remove_subject->setInt(1, student_id);
-            pstmt_remove_subject->setInt(2, group_id);
-            pstmt_remove_subject->executeUpdate();
+    std::string render(Values values) const {
+        Tracer::SpanTimer span("render");
+        std::vector<Binding> bound = bind(values);
 
-            // Atnaujiname students lentelę (group_id -> NULL)
-            std::unique_ptr<sql::PreparedStatement> pstmt_update_student(con->prepareStatement(
-                "UPDATE students SET group_id = NULL WHERE student_id = ?"));
-            pstmt_update_student->setInt(1, student_id);
-            pstmt_update_student->executeUpdate();
+        std::size_t total = 0;
+        for (const Segment& segment : segments_) {
+            std::string_view value;
+            total += valueOf(segment, bound, value) ? value.size() : segment.length;
+        }
 
-            return { 200, "Studentas su ID " + std::to_string(student_id) + " buvo pasalintas is grupes su ID " + std::to_string(group_id) + "!" };
+        std::string out;
+        out.reserve(total);
+        for (const Segment& segment : segments_) {
+            std::string_view value;
+            if (valueOf(segment, bound, value)) {
+                out.append(value);
+            }
+            else {
+                out.append(source_, segment.offset, segment.length);
+            }
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "SQL klaida: " << e.what() << std::endl;
-            return { 500, "Klaida salinant is duomenu bazes." };
+        return out;
+    }
+
+    // Atvaizduoja į atsakymo segmentus: pastovios dalys nekopijuojamos, o rodo į šablono tekstą,
+    // kurį gyvą išlaiko owner (pvz., StaticPageStore puslapis); kopijuojamos tik įstatomos reikšmės.
+    void render_to(crow::response& res, Values values, std::shared_ptr<const void> owner) const {
+        Tracer::SpanTimer span("render");
+        std::vector<Binding> bound = bind(values);
+        res.segments.reserve(res.segments.size() + segments_.size());
+        for (const Segment& segment : segments_) {
+            std::string_view value;
+            if (valueOf(segment, bound, value)) {
+                res.add_segment(std::string(value));
+            }
+            else {
+                res.add_segment(source_.data() + segment.offset, segment.length, owner);
+            }
+        }
+    }
+
+private:
+    struct Segment {
+        std::size_t offset;
+        std::size_t length;
+        int slot; // -1 - pastovus tekstas
+        bool raw;
+    };
+
+    struct Slot {
+        std::string name;
+        bool escaped_use = false; // ar bent viena vieta naudoja {{vardas}} (ekranuojamą) formą
+    };
+
+    struct Binding {
+        const std::string_view* value = nullptr;
+        std::string escaped;
+    };
+
+    // Kiekvienai vietai susirandame reikšmę (nullptr - paliekamas originalus tekstas).
+    // Ekranuota reikšmė paskaičiuojama vieną kartą, nors vieta šablone kartotųsi.
+    std::vector<Binding> bind(Values values) const {
+        std::vector<Binding> bound(slots_.size());
+        for (const auto& value : values) {
+            for (std::size_t i = 0; i < slots_.size(); ++i) {
+                if (slots_[i].name == value.first) {
+                    bound[i].value = &value.second;
+                }
+            }
         }
-         {
-            delete con;
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (bound[i].value && slots_[i].escaped_use) {
+                crow::utility::html_escape_append(bound[i].value->data(), bound[i].value->size(), bound[i].escaped);
+            }
         }
+        return bound;
     }
-    // Gauname studentų su grupėmis sąrašą iš DB.
-    std::vector<std::tuple<int, std::string, std::string, int, std::string>> getStudentGroupInfoFromDatabase(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string, std::string, int, std::string>> studentGroupInfo;  
 
-        if (con) {
-            try {
-                // Atlieka užklausą, kad gautų studentų ir grupių informaciją
-                unique_ptr<sql::PreparedStatement> pstmt(
-                    con->prepareStatement("SELECT t.student_id, t.name, t.surname, s.group_id, s.group_name "
-                        "FROM students t "
-                        "LEFT JOIN group_students ts ON t.student_id = ts.student_id "
-                        "LEFT JOIN stud_groups s ON ts.group_id = s.group_id")
-                );
-                unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
+    static bool valueOf(const Segment& segment, const std::vector<Binding>& bound, std::string_view& value) {
+        if (segment.slot < 0 || !bound[segment.slot].value) {
+            return false;
+        }
+        value = segment.raw ? *bound[segment.slot].value : std::string_view(bound[segment.slot].escaped);
+        return true;
+    }
 
-                // Užpildo vektorių su studentų ir grupių informacija
-                while (res->next()) {
-                    int student_id = res->getInt("student_id");
-                    std::string student_name = res->getString("name").c_str();
-                    std::string student_surname = res->getString("surname").c_str();
-                    int group_id = res->getInt("group_id");
-                    std::string group_name = res->getString("group_name").c_str();
+    static bool isSlotName(std::string_view name) {
+        if (name.empty()) {
+            return false;
+        }
+        for (char c : name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+                return false;
+            }
+        }
+        return true;
+    }
 
-                    // Įrašo į vektorių tuple su studento ir grupės informacija
-                    studentGroupInfo.push_back(std::make_tuple(student_id, student_name, student_surname, group_id, group_name));
+    int slotIndex(std::string_view name, bool raw) {
+        std::size_t i = 0;
+        while (i < slots_.size() && slots_[i].name != name) {
+            ++i;
+        }
+        if (i == slots_.size()) {
+            slots_.push_back({ std::string(name) });
+        }
+        slots_[i].escaped_use = slots_[i].escaped_use || !raw;
+        return static_cast<int>(i);
+    }
+
+    std::string source_;
+    std::vector<Slot> slots_;
+    std::vector<Segment> segments_;
+};
+
+// Statinių puslapių (Login.htm, admin_dashboard.htm ir kt.) saugykla atmintyje.
+// Failai perskaitomi vieną kartą paleidžiant serverį; užklausos metu diskas neliečiamas.
+// Kiekvienas puslapis yra nekintamas momentinis vaizdas su iš anksto paskaičiuotu ETag,
+// Content-Length ir (jei Crow sukompiliuotas su CROW_ENABLE_COMPRESSION) gzip variantu.
+// Foninė gija periodiškai tikrina failų keitimo laiką ir pakeistus puslapius įkelia iš naujo.
+class StaticPageStore {
+public:
+    struct Page {
+        std::string body;
+        std::string gzip_body;      // tuščias, jei suspaudimas neįjungtas
+        std::string etag;
+        std::string content_length;
+        std::string gzip_content_length;
+        std::filesystem::file_time_type mtime;
+        PlaceholderTemplate layout;  // tas pats turinys, suskaidytas {{vietoms}} pildyti
+    };
+
+    explicit StaticPageStore(std::string base_dir, std::chrono::milliseconds poll_interval = std::chrono::seconds(2))
+        : base_dir_(std::move(base_dir)), poll_interval_(poll_interval) {}
+
+    StaticPageStore(const StaticPageStore&) = delete;
+    StaticPageStore& operator=(const StaticPageStore&) = delete;
+
+    ~StaticPageStore() {
+        {
+            std::lock_guard<std::mutex> lock(watch_mutex_);
+            stopping_ = true;
+        }
+        watch_cv_.notify_all();
+        if (watcher_.joinable()) {
+            watcher_.join();
+        }
+    }
+
+    // Užregistruoja ir įkelia puslapį. Kviečiama tik prieš watch() ir app.run().
+    void add(const std::string& name) {
+        std::unique_ptr<Slot> slot(new Slot());
+        slot->path = base_dir_ + name;
+        std::atomic_store(&slot->page, load(slot->path));
+        slots_[name] = std::move(slot);
+    }
+
+    // Paleidžia failų stebėjimo giją
+    void watch() {
+        watcher_ = std::thread([this]() { run(); });
+    }
+
+    // Dabartinis puslapio vaizdas (nullptr, jei puslapis neužregistruotas)
+    std::shared_ptr<const Page> page(const std::string& name) const {
+        auto it = slots_.find(name);
+        if (it == slots_.end()) {
+            return nullptr;
+        }
+        return std::atomic_load(&it->second->page);
+    }
+
+    // HTML atsakymas su ETag; jei naršyklė jau turi tą pačią versiją - 304 be turinio
+    crow::response serve(const crow::request& req, const std::string& name) const {
+        std::shared_ptr<const Page> current = page(name);
+        if (!current) {
+            CROW_LOG_ERROR << "Puslapis neuzregistruotas: " << name;
+            return crow::response(500, "Vidine klaida.");
+        }
+
+        crow::response res;
+        res.set_header("Cache-Control", "no-cache");
+        std::string matched;
+        if (etagMatches(req, current->etag, matched)) {
+            res.code = 304;
+            res.set_header("ETag", matched);
+            return res;
+        }
+
+        res.set_header("Content-Type", "text/html");
+        res.set_header("Vary", "Accept-Encoding");
+        // Turinys nekopijuojamas: atsakymo segmentas rodo į puslapio vaizdą, kurį laiko current
+        if (!current->gzip_body.empty() && acceptsGzip(req)) {
+            res.set_header("ETag", gzipETag(current->etag));
+            res.set_header("Content-Encoding", "gzip");
+            res.set_header("Content-Length", current->gzip_content_length);
+            res.add_segment(current->gzip_body.data(), current->gzip_body.size(), current);
+        }
+        else {
+            res.set_header("ETag", current->etag);
+            res.set_header("Content-Length", current->content_length);
+            res.add_segment(current->body.data(), current->body.size(), current);
+        }
+#ifdef CROW_ENABLE_COMPRESSION
+        // Jau suspausta (arba sąmoningai nesuspausta) - Crow antrą kartą nespaudžia
+        res.compressed = false;
+#endif
+        return res;
+    }
+
+private:
+    struct Slot {
+        std::string path;
+        std::shared_ptr<const Page> page;
+    };
+
+    static std::shared_ptr<const Page> load(const std::string& path) {
+        auto page = std::make_shared<Page>();
+        std::error_code ec;
+        page->mtime = std::filesystem::last_write_time(path, ec);
+        page->body = loadHTML(path);
+        page->etag = etagOf(page->body);
+        page->content_length = std::to_string(page->body.size());
+        page->layout = PlaceholderTemplate(page->body);
+#ifdef CROW_ENABLE_COMPRESSION
+        page->gzip_body = crow::compression::compress_string(page->body, crow::compression::algorithm::GZIP);
+        page->gzip_content_length = std::to_string(page->gzip_body.size());
+#endif
+        return page;
+    }
+
+    // Silpnas turinio ETag: FNV-1a 64 bitų maiša šešioliktaine forma
+    static std::string etagOf(std::string_view body) {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : body) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        char buffer[24];
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), hash, 16);
+        return "\"" + std::string(buffer, result.ptr) + "\"";
+    }
+
+    // Windows neturi inotify, todėl tikriname keitimo laiką kas poll_interval_
+    void run() {
+        std::unique_lock<std::mutex> lock(watch_mutex_);
+        while (!watch_cv_.wait_for(lock, poll_interval_, [this]() { return stopping_; })) {
+            for (auto& entry : slots_) {
+                Slot& slot = *entry.second;
+                std::error_code ec;
+                std::filesystem::file_time_type mtime = std::filesystem::last_write_time(slot.path, ec);
+                if (ec || mtime == std::atomic_load(&slot.page)->mtime) {
+                    continue;
                 }
+                std::atomic_store(&slot.page, load(slot.path));
+                CROW_LOG_INFO << "Puslapis perkrautas: " << slot.path;
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida užklausoje: " << e.what() << std::endl;
+        }
+    }
+
+    std::string base_dir_;
+    std::chrono::milliseconds poll_interval_;
+    std::unordered_map<std::string, std::unique_ptr<Slot>> slots_;
+
+    std::thread watcher_;
+    std::mutex watch_mutex_;
+    std::condition_variable watch_cv_;
+    bool stopping_ = false;
+};
+
+// Pilnai atvaizduotų administratoriaus apžvalgos puslapių talpykla.
+// Įrašas galioja, kol nepasikeičia nė viena lentelė, iš kurios puslapis sudarytas: versijų
+// skaitikliai tik didėja, todėl jų suma yra tinkamas bendras versijos žymuo.
+// Nepasikeitęs puslapis siunčiamas kaip nuoroda į talpykloje laikomą turinį (be kopijavimo).
+class RenderedPageCache {
+public:
+    using Tables = std::initializer_list<MySQLDatabase::Table>;
+
+    explicit RenderedPageCache(MySQLDatabase& db) : db_(db) {}
+
+    // Grąžina talpykloje esantį puslapį arba jį atvaizduoja su render ir įsimena.
+    // Atsakymai ne su kodu 200 neįsimenami.
+    crow::response serve(const crow::request& req, const std::string& key, Tables tables,
+        const std::function<crow::response()>& render) {
+        Slot& slot = slotFor(key);
+        std::shared_ptr<const Page> page = std::atomic_load(&slot.page);
+        if (!page || page->version != db_.tablesVersion(tables)) {
+            // Vienas atvaizduoja, kiti laukia ir paima jau atnaujintą įrašą
+            std::lock_guard<std::mutex> lock(slot.render_mutex);
+            page = std::atomic_load(&slot.page);
+            // Versija paimama prieš skaitant duomenis: jei jie pasikeistų atvaizduojant, įrašas pasens
+            const std::uint64_t version = db_.tablesVersion(tables);
+            if (!page || page->version != version) {
+                crow::response rendered = render();
+                if (rendered.code != 200) {
+                    return rendered;
+                }
+                page = build(std::move(rendered), version);
+                std::atomic_store(&slot.page, page);
+            }
+        }
+        return respond(req, page);
+    }
+
+private:
+    struct Page {
+        std::uint64_t version;
+        std::string content_type;
+        std::string body;
+        std::string gzip_body;  // tuščias, jei suspaudimas neįjungtas
+    };
+
+    struct Slot {
+        std::mutex render_mutex;
+        std::shared_ptr<const Page> page;
+    };
+
+    Slot& slotFor(const std::string& key) {
+        std::lock_guard<std::mutex> lock(slots_mutex_);
+        std::unique_ptr<Slot>& slot = slots_[key];
+        if (!slot) {
+            slot.reset(new Slot());
+        }
+        return *slot;
+    }
+
+    static std::shared_ptr<const Page> build(crow::response rendered, std::uint64_t version) {
+        rendered.flatten_body();
+        auto page = std::make_shared<Page>();
+        page->version = version;
+        page->content_type = rendered.get_header_value("Content-Type");
+        page->body = std::move(rendered.body);
+#ifdef CROW_ENABLE_COMPRESSION
+        page->gzip_body = crow::compression::compress_string(page->body, crow::compression::algorithm::GZIP);
+#endif
+        return page;
+    }
+
+    static crow::response respond(const crow::request& req, const std::shared_ptr<const Page>& page) {
+        crow::response res;
+        res.set_header("Content-Type", page->content_type);
+        res.set_header("Vary", "Accept-Encoding");
+        if (!page->gzip_body.empty() && acceptsGzip(req)) {
+            res.set_header("Content-Encoding", "gzip");
+            res.add_segment(page->gzip_body.data(), page->gzip_body.size(), page);
+        }
+        else {
+            res.add_segment(page->body.data(), page->body.size(), page);
+        }
+#ifdef CROW_ENABLE_COMPRESSION
+        res.compressed = false;
+#endif
+        return res;
+    }
+
+    MySQLDatabase& db_;
+    std::mutex slots_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Slot>> slots_;
+};
+
+// Užklausų metrikos /metrics maršrutui: vėlinimo histograma pagal maršrutą, metodą ir atsakymo kodą
+// bei šiuo metu vykdomų užklausų skaičius. Laikas matuojamas nuo before_handle iki after_handle, tad
+// asinchroniniams maršrutams apima ir laukimą DB eilėje, o srautiniams - tik iki antraščių.
+// Serijos raktas paverčiamas indeksu vieną kartą kiekvienoje gijoje; pats įrašymas - be užraktų.
+struct MetricsMiddleware {
+    struct context {
+        std::chrono::steady_clock::time_point start;
+        bool started = false;
+    };
+
+    static constexpr std::size_t kMaxSeries = 256;  // paskutinė serija - visoms netilpusioms
+
+    MetricsMiddleware() {
+        slots_[kMaxSeries - 1].reset(new Series("(kita)", "", 0));
+    }
+
+    void before_handle(crow::request& /*req*/, crow::response& /*res*/, context& ctx) {
+        ctx.start = std::chrono::steady_clock::now();
+        ctx.started = true;
+        in_flight_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void after_handle(crow::request& req, crow::response& res, context& ctx) {
+        // Nerastam maršrutui Crow before_handle nekviečia, o kontekstas gali likti iš ankstesnės užklausos
+        if (!ctx.started) {
+            return;
+        }
+        ctx.started = false;
+        in_flight_.fetch_sub(1, std::memory_order_relaxed);
+        series(crow::method_name(req.method), routeLabel(req.url), res.code).latency.record(std::chrono::steady_clock::now() - ctx.start);
+    }
+
+    // Prometheus tekstas: užklausų histogramos ir vykdomų užklausų skaičius
+    void write(std::string& out) const {
+        writePrometheusHeader(out, "http_requests_in_flight", "gauge", "Requests being handled right now.");
+        out += "http_requests_in_flight " + std::to_string(in_flight_.load(std::memory_order_relaxed)) + "\n";
+
+        writePrometheusHeader(out, "http_request_duration_seconds", "histogram", "Request latency by route, method and status.");
+        std::size_t count = count_.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < kMaxSeries; ++i) {
+            if (i >= count && i != kMaxSeries - 1) {
+                continue;
+            }
+            const Series& entry = *slots_[i];
+            LatencyHistogram::Snapshot snapshot = entry.latency.snapshot();
+            if (snapshot.count == 0) {
+                continue;
+            }
+            std::string labels = "route=\"" + labelValue(entry.route) + "\",method=\"" + entry.method +
+                "\",status=\"" + std::to_string(entry.status) + "\"";
+            writePrometheusHistogram(out, "http_request_duration_seconds", labels, snapshot);
+        }
+    }
+
+private:
+    struct Series {
+        Series(std::string route, std::string method, int status)
+            : route(std::move(route)), method(std::move(method)), status(status) {}
+
+        std::string route;
+        std::string method;
+        int status;
+        LatencyHistogram latency;
+    };
+
+    // Skaitiniai kelio segmentai (/subject_students/12) keičiami ":id", kad serijų skaičius būtų ribotas
+    static std::string routeLabel(const std::string& url) {
+        std::string label;
+        label.reserve(url.size());
+        std::size_t pos = 0;
+        while (pos < url.size()) {
+            std::size_t end = url.find('/', pos + 1);
+            if (end == std::string::npos) end = url.size();
+            std::string_view segment(url.data() + pos + 1, end - pos - 1);
+            bool numeric = !segment.empty() &&
+                std::all_of(segment.begin(), segment.end(), [](char c) { return c >= '0' && c <= '9'; });
+            label += '/';
+            if (numeric) {
+                label += ":id";
+            }
+            else {
+                label.append(segment.data(), segment.size());
             }
+            pos = end;
         }
-        return studentGroupInfo;  // Grąžina vektorių su studentų ir grupių duomenimis
+        return label.empty() ? "/" : label;
     }
 
-    // Pridėti dėstytoją į duomenų bazę
-    std::string addGroupAndSubjectsToDatabase(sql::Connection* con, int group_id, int subject_id) {
-        bool group_exists = false, subject_exists = false;
-
-        try {
-            // Patikriname, ar egzistuoja grupė
-            unique_ptr<sql::PreparedStatement> pstmt_group(con->prepareStatement(
-                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?"));
-            pstmt_group->setInt(1, group_id);
-            unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
-            group_exists = group_res->next() && group_res->getInt(1) > 0;
-
-            // Patikriname, ar egzistuoja dalykas
-            unique_ptr<sql::PreparedStatement> pstmt_subject(con->prepareStatement(
-                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?"));
-            pstmt_subject->setInt(1, subject_id);
-            unique_ptr<sql::ResultSet> subject_res(pstmt_subject->executeQuery());
-            subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
-
-            // Patikriname, ar grupė jau turi priskirtą šį dalyką
-            unique_ptr<sql::PreparedStatement> pstmt_existing_relation(con->prepareStatement(
-                "SELECT COUNT(*) FROM group_subjects WHERE group_id = ? AND subject_id = ?"));
-            pstmt_existing_relation->setInt(1, group_id);
-            pstmt_existing_relation->setInt(2, subject_id);
-            unique_ptr<sql::ResultSet> existing_res(pstmt_existing_relation->executeQuery());
-            bool already_assigned = existing_res->next() && existing_res->getInt(1) > 0;
+    static std::string labelValue(const std::string& text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '\\' || c == '"') out += '\\';
+            out += c == '\n' ? ' ' : c;
+        }
+        return out;
+    }
 
-            // Jei jau egzistuoja tas pats ryšys, grąžiname klaidą
-            if (already_assigned) {
-                return "Sis dalykas jau priskirtas grupei su ID " + std::to_string(group_id);
-            }
+    Series& series(const std::string& method, const std::string& route, int status) {
+        std::string key = method + ' ' + std::to_string(status) + ' ' + route;
+        thread_local std::unordered_map<std::string, std::size_t> local;  // ši gija jau žino šiuos indeksus
+        auto it = local.find(key);
+        if (it != local.end()) {
+            return *slots_[it->second];
+        }
 
-            // Jei visi patikrinimai praeina, atliekame įrašą į group_subjects
-            if (group_exists && subject_exists) {
-                unique_ptr<sql::PreparedStatement> pstmt_add(con->prepareStatement(
-                    "INSERT INTO group_subjects (group_id, subject_id) VALUES (?, ?)"));
-                pstmt_add->setInt(1, group_id);
-                pstmt_add->setInt(2, subject_id);
-                pstmt_add->executeUpdate();
-                return "Dalykas su ID " + std::to_string(subject_id) + " buvo priskirtas grupei su ID " + std::to_string(group_id);
+        std::size_t index;
+        {
+            std::lock_guard<std::mutex> lock(index_mutex_);
+            auto found = index_.find(key);
+            if (found != index_.end()) {
+                index = found->second;
             }
             else {
-                if (!group_exists) {
-                    return "Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
+                index = count_.load(std::memory_order_relaxed);
+                if (index < kMaxSeries - 1) {
+                    slots_[index].reset(new Series(route, method, status));
+                    count_.store(index + 1, std::memory_order_release);
                 }
-                if (!subject_exists) {
-                    return "Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
+                else {
+                    index = kMaxSeries - 1;
                 }
+                index_.emplace(key, index);
             }
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "SQL klaida: " << e.what() << std::endl;
-            return "Ivyko klaida dirbant su duomenu baze.";
+        local.emplace(std::move(key), index);
+        return *slots_[index];
+    }
+
+    std::atomic<std::int64_t> in_flight_{ 0 };
+    std::array<std::unique_ptr<Series>, kMaxSeries> slots_;
+    std::atomic<std::size_t> count_{ 0 };
+    std::mutex index_mutex_;
+    std::unordered_map<std::string, std::size_t> index_;
+};
+
+// Sukuria kiekvienos užklausos Tracer trace ir padaro jį dabartiniu IO gijoje, kol veikia maršrutas
+// (DbExecutor jį paima ir perduoda DB gijai). Paskutinis intervalas - "write", iki atsakymas išsiųstas.
+struct TraceMiddleware {
+    struct context {
+        std::shared_ptr<Tracer::Trace> trace;
+    };
+
+    void before_handle(crow::request& req, crow::response& /*res*/, context& ctx) {
+        ctx.trace = Tracer::begin(crow::method_name(req.method), req.url);
+        Tracer::current() = ctx.trace;
+    }
+
+    void after_handle(crow::request& /*req*/, crow::response& res, context& ctx) {
+        // Kaip ir MetricsMiddleware: nerastam maršrutui before_handle nebuvo kviestas
+        if (!ctx.trace) {
+            return;
+        }
+        std::shared_ptr<Tracer::Trace> trace = std::move(ctx.trace);
+        ctx.trace.reset();
+        if (Tracer::current() == trace) {
+            Tracer::current().reset();
         }
 
-        return "";
+        trace->status = res.code;
+        auto completed = std::chrono::steady_clock::now();
+        res.on_sent = [trace, completed]() {
+            trace->add("write", completed, std::chrono::steady_clock::now());
+            Tracer::finish(trace);
+        };
     }
+};
 
-    // Funkcija, kuri pašalina grupę ir dalyką iš duomenų bazės
-    std::string deleteGroupAndSubjectsFromDatabase(sql::Connection* con, int group_id, int subject_id) {
-        bool group_exists = false, subject_exists = false, group_in_subject = false;
+// Prisijungimo bandymų ribojimas: žetonų kibirai (token bucket) pagal kliento IP ir pagal vartotojo vardą.
+// Kibirai laikomi fiksuoto dydžio maišos lentelėje, padalintoje į šukes su atskirais mutex'ais, todėl
+// atmintis neauga nuo suklastotų vardų, o lygiagrečios užklausos retai laukia viena kitos.
+// Nebenaudojami kibirai išvalomi laikmačių ratu (timer wheel) foninėje gijoje.
+class LoginRateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        double ip_rate = 1.0;          // žetonai per sekundę vienam IP (per NAT jungiasi daug studentų)
+        double ip_burst = 30;
+        double user_rate = 1.0 / 12;   // vienam vartotojo vardui - 5 bandymai per minutę
+        double user_burst = 5;
+        int lockout_failures = 5;      // nesėkmingi bandymai iš eilės iki užrakinimo
+        std::chrono::seconds lockout{ 30 };        // kiekvienas tolesnis nesėkmingas bandymas jį dvigubina
+        std::chrono::seconds max_lockout{ 900 };
+        std::chrono::seconds idle_ttl{ 900 };      // tiek nenaudotas kibiras pamirštamas
+    };
+
+    enum class Kind : std::uint64_t { Ip = 0x6970ull, User = 0x75736572ull };
+
+    struct Decision {
+        bool allowed;
+        std::chrono::seconds retry_after;
+    };
+
+    struct Stats {
+        std::uint64_t allowed;
+        std::uint64_t limited_ip;
+        std::uint64_t limited_user;
+        std::uint64_t lockouts;
+        std::uint64_t evicted;
+        std::uint64_t expired;
+        std::uint64_t buckets;
+    };
+
+    static constexpr std::size_t kShards = 16;
+    static constexpr std::size_t kSlotsPerShard = 1024;
+    static constexpr std::size_t kProbe = 8;
+    static constexpr std::size_t kWheelSlots = 128;
+    static constexpr std::chrono::seconds kTick{ 10 };
+
+    LoginRateLimiter() : shards_(std::make_unique<Shard[]>(kShards)), epoch_(Clock::now()) {
+        std::random_device random;
+        seed_ = (static_cast<std::uint64_t>(random()) << 32) ^ random();
+    }
 
-        try {
-            // Patikriname, ar egzistuoja grupė
-            unique_ptr<sql::PreparedStatement> pstmt_group(con->prepareStatement(
-                "SELECT COUNT(*) FROM stud_groups WHERE group_id = ?"));
-            pstmt_group->setInt(1, group_id);
-            unique_ptr<sql::ResultSet> group_res(pstmt_group->executeQuery());
-            group_exists = group_res->next() && group_res->getInt(1) > 0;
+    ~LoginRateLimiter() {
+        {
+            std::lock_guard<std::mutex> lock(sweep_mutex_);
+            stopping_ = true;
+        }
+        sweep_cv_.notify_all();
+        if (sweeper_.joinable()) {
+            sweeper_.join();
+        }
+    }
 
-            // Patikriname, ar egzistuoja dalykas
-            unique_ptr<sql::PreparedStatement> pstmt_subject(con->prepareStatement(
-                "SELECT COUNT(*) FROM subjects WHERE subject_id = ?"));
-            pstmt_subject->setInt(1, subject_id);
-            unique_ptr<sql::ResultSet> subject_res(pstmt_subject->executeQuery());
-            subject_exists = subject_res->next() && subject_res->getInt(1) > 0;
+    LoginRateLimiter(const LoginRateLimiter&) = delete;
+    LoginRateLimiter& operator=(const LoginRateLimiter&) = delete;
 
-            // Patikriname, ar grupė turi priskirtą šį dalyką
-            unique_ptr<sql::PreparedStatement> pstmt_in_subject(con->prepareStatement(
-                "SELECT COUNT(*) FROM group_subjects WHERE group_id = ? AND subject_id = ?"));
-            pstmt_in_subject->setInt(1, group_id);
-            pstmt_in_subject->setInt(2, subject_id);
-            unique_ptr<sql::ResultSet> in_subject_res(pstmt_in_subject->executeQuery());
-            group_in_subject = in_subject_res->next() && in_subject_res->getInt(1) > 0;
+    // Keičiama tik prieš start()
+    void configure(const Config& config) {
+        config_ = config;
+    }
 
-            // Jei grupė ir dalykas egzistuoja ir grupė yra priskirta šiam dalykui, pašaliname ryšį
-            if (group_exists && subject_exists && group_in_subject) {
-                unique_ptr<sql::PreparedStatement> pstmt_remove(con->prepareStatement(
-                    "DELETE FROM group_subjects WHERE group_id = ? AND subject_id = ?"));
-                pstmt_remove->setInt(1, group_id);
-                pstmt_remove->setInt(2, subject_id);
-                pstmt_remove->executeUpdate();
-                return "Grupe su ID " + std::to_string(group_id) + " buvo pasalinta is dalyko su ID " + std::to_string(subject_id);
+    // Paleidžia pasenusių kibirų valymo giją
+    void start() {
+        sweeper_ = std::thread([this]() { sweep(); });
+    }
+
+    // Kibiro raktas: maiša su atsitiktine sėkla, kad užpuolikas negalėtų parinkti susiduriančių vardų.
+    // Vardas normalizuojamas kaip ir MySQL palyginime (be didžiųjų raidžių ir tarpų kraštuose).
+    std::uint64_t key(Kind kind, std::string_view text) const {
+        std::uint64_t hash = 14695981039346656037ull ^ seed_ ^ static_cast<std::uint64_t>(kind);
+        std::size_t begin = text.find_first_not_of(" \t");
+        std::size_t end = text.find_last_not_of(" \t");
+        if (begin != std::string_view::npos) {
+            for (std::size_t i = begin; i <= end; i++) {
+                hash ^= static_cast<unsigned char>(std::tolower(static_cast<unsigned char>(text[i])));
+                hash *= 1099511628211ull;
             }
-            else {
-                if (!group_exists) {
-                    return "Grupe su ID " + std::to_string(group_id) + " neegzistuoja.";
-                }
-                if (!subject_exists) {
-                    return "Dalykas su ID " + std::to_string(subject_id) + " neegzistuoja.";
-                }
-                if (!group_in_subject) {
-                    return "Grupe su ID " + std::to_string(group_id) + " nera priskirtas dalykui su ID " + std::to_string(subject_id) + ".";
-                }
+        }
+        hash = mix(hash);
+        return hash == 0 ? 1 : hash;
+    }
+
+    // Paima po žetoną iš IP ir vartotojo kibirų. user_key == 0 - vardas nenurodytas.
+    // Kai IP kibiras tuščias, vartotojo kibiras neliečiamas.
+    Decision admit(std::uint64_t ip_key, std::uint64_t user_key) {
+        Clock::time_point now = Clock::now();
+        Decision decision = take(ip_key, config_.ip_rate, config_.ip_burst, now);
+        if (!decision.allowed) {
+            limited_ip_.fetch_add(1, std::memory_order_relaxed);
+            return decision;
+        }
+        if (user_key != 0) {
+            decision = take(user_key, config_.user_rate, config_.user_burst, now);
+            if (!decision.allowed) {
+                limited_user_.fetch_add(1, std::memory_order_relaxed);
+                return decision;
             }
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "SQL klaida: " << e.what() << std::endl;
-            return "Įvyko klaida dirbant su duomenų baze.";
+        allowed_.fetch_add(1, std::memory_order_relaxed);
+        return decision;
+    }
+
+    // Prisijungimo rezultatas: nesėkmės kaupiamos ir po lockout_failures vardas užrakinamas
+    void record(std::uint64_t user_key, bool success) {
+        if (user_key == 0) {
+            return;
+        }
+        Clock::time_point now = Clock::now();
+        Shard& shard = shards_[shardOf(user_key)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Bucket& bucket = find(shard, user_key, config_.user_burst, now);
+        if (success) {
+            bucket.failures = 0;
+            bucket.locked_until = Clock::time_point();
+            return;
+        }
+        if (bucket.failures < std::numeric_limits<std::uint16_t>::max()) {
+            bucket.failures++;
         }
+        if (bucket.failures >= config_.lockout_failures) {
+            int doublings = std::min(bucket.failures - config_.lockout_failures, 16);
+            std::chrono::seconds lockout = std::min(config_.lockout * (1 << doublings), config_.max_lockout);
+            bucket.locked_until = now + lockout;
+            lockouts_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
 
-        return "";
+    Stats stats() const {
+        return { allowed_.load(std::memory_order_relaxed), limited_ip_.load(std::memory_order_relaxed),
+            limited_user_.load(std::memory_order_relaxed), lockouts_.load(std::memory_order_relaxed),
+            evicted_.load(std::memory_order_relaxed), expired_.load(std::memory_order_relaxed),
+            buckets_.load(std::memory_order_relaxed) };
     }
 
-    // Funkcija, kuri grąžina vektorių su grupių ir dalykų duomenimis
-    std::vector<std::tuple<int, std::string, int, std::string>> getGroupSubjects(sql::Connection* con) {
-        std::vector<std::tuple<int, std::string, int, std::string>> groupSubjects;
+private:
+    struct Bucket {
+        std::uint64_t key = 0;  // 0 - laisva vieta
+        std::uint32_t generation = 0;
+        std::uint16_t failures = 0;
+        double tokens = 0;
+        Clock::time_point updated;
+        Clock::time_point locked_until;
+    };
+
+    // Rato įrašas rodo į kibirą; jei vieta jau atiduota kitam kibirui, kartos nesutampa ir įrašas metamas
+    struct WheelEntry {
+        std::uint16_t slot;
+        std::uint32_t generation;
+        std::uint64_t due_tick;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::array<Bucket, kSlotsPerShard> buckets;
+        std::array<std::vector<WheelEntry>, kWheelSlots> wheel;
+    };
+
+    static std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
 
-        if (con) {
-            try {
-                unique_ptr<sql::PreparedStatement> groupSubjectStmt(
-                    con->prepareStatement(
-                        "SELECT g.group_id, g.group_name, s.subject_id, s.subject_name "
-                        "FROM stud_groups g "
-                        "LEFT JOIN group_subjects gs ON g.group_id = gs.group_id "
-                        "LEFT JOIN subjects s ON gs.subject_id = s.subject_id"
-                    )
-                );
-                unique_ptr<sql::ResultSet> groupSubjectRes(groupSubjectStmt->executeQuery());
+    static std::size_t shardOf(std::uint64_t key) {
+        return static_cast<std::size_t>(key >> 60) % kShards;
+    }
 
-                while (groupSubjectRes->next()) {
-                    int group_id = groupSubjectRes->getInt("group_id");
-                    std::string group_name = groupSubjectRes->getString("group_name").c_str();
-                    int subject_id = groupSubjectRes->getInt("subject_id");
-                    std::string subject_name = groupSubjectRes->getString("subject_name").c_str();
+    std::uint64_t tickOf(Clock::time_point time) const {
+        return time <= epoch_ ? 0 : static_cast<std::uint64_t>((time - epoch_) / kTick);
+    }
 
-                    // Jei dalykas nepriskirtas, užrašome "Nėra dalyko"
-                    if (subject_id == 0) {
-                        subject_name = "Nera dalyko";
-                    }
+    Decision take(std::uint64_t key, double rate, double burst, Clock::time_point now) {
+        Shard& shard = shards_[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        Bucket& bucket = find(shard, key, burst, now);
 
-                    // Pridedame į vektorių kaip tuple
-                    groupSubjects.push_back(std::make_tuple(group_id, group_name, subject_id, subject_name));
-                }
-            }
-            catch (sql::SQLException& e) {
-                std::cerr << "SQL klaida: " << e.what() << std::endl;
-            }
+        if (bucket.locked_until > now) {
+            auto wait = std::chrono::ceil<std::chrono::seconds>(bucket.locked_until - now);
+            return { false, wait };
         }
 
-        return groupSubjects;
+        std::chrono::duration<double> elapsed = now - bucket.updated;
+        bucket.tokens = std::min(burst, bucket.tokens + elapsed.count() * rate);
+        bucket.updated = now;
+        if (bucket.tokens < 1.0) {
+            auto wait = std::chrono::seconds(static_cast<std::int64_t>(std::ceil((1.0 - bucket.tokens) / rate)));
+            return { false, wait };
+        }
+        bucket.tokens -= 1.0;
+        return { true, std::chrono::seconds(0) };
     }
-    // Gauname visų grupių info iš DB.
-    vector<pair<int, string>> getAllGroups(MySQLDatabase& db) {
-        std::vector<std::pair<int, std::string>> groups;
-        sql::Connection* con = db.connect();
-        if (con) {
-            try {
-                std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                    "SELECT group_id, group_name FROM `stud_groups`"
-                ));
-                std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
-                while (res->next()) {
-                    int group_id = res->getInt("group_id");
-                    std::string group_name = res->getString("group_name").c_str();
-                    groups.emplace_back(group_id, group_name);
+    // Randa kibirą arba jį sukuria pilną. Jei visos zondavimo vietos užimtos, išstumiamas seniausiai
+    // naudotas neužrakintas kibiras. Kviečiama laikant shard.mutex.
+    Bucket& find(Shard& shard, std::uint64_t key, double burst, Clock::time_point now) {
+        std::size_t home = static_cast<std::size_t>(key) & (kSlotsPerShard - 1);
+        std::size_t free_slot = kSlotsPerShard;
+        std::size_t victim = home;
+        for (std::size_t i = 0; i < kProbe; i++) {
+            std::size_t slot = (home + i) & (kSlotsPerShard - 1);
+            Bucket& bucket = shard.buckets[slot];
+            if (bucket.key == key) {
+                return bucket;
+            }
+            if (bucket.key == 0) {
+                if (free_slot == kSlotsPerShard) {
+                    free_slot = slot;
                 }
+                continue;
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida gaunant grupes: " << e.what() << std::endl;
+            const Bucket& current = shard.buckets[victim];
+            bool locked = bucket.locked_until > now;
+            bool current_locked = current.locked_until > now;
+            if (current.key == 0 || (current_locked && !locked) || (locked == current_locked && bucket.updated < current.updated)) {
+                victim = slot;
             }
-            delete con;
         }
-        return groups;
-    }
-};
-
-MySQLDatabase* db = nullptr;
-
 
-int main() {
-    crow::SimpleApp app;
+        std::size_t slot = free_slot;
+        if (slot == kSlotsPerShard) {
+            slot = victim;
+            evicted_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            buckets_.fetch_add(1, std::memory_order_relaxed);
+        }
 
-    // Sukuriame MySQLDatabase objektą
-    MySQLDatabase db("127.0.0.1", "root", "Advokatinukas2134", "sys");
+        Bucket& bucket = shard.buckets[slot];
+        bucket.key = key;
+        bucket.generation++;
+        bucket.failures = 0;
+        bucket.tokens = burst;
+        bucket.updated = now;
+        bucket.locked_until = Clock::time_point();
+        schedule(shard, slot, now + config_.idle_ttl, now);
+        return bucket;
+    }
 
-    // Pateikti prisijungimo puslapį
-    CROW_ROUTE(app, "/")([]() {
-        std::string htmlContent = loadHTML("Login.htm");  // Perskaityti Login.htm failą
-        crow::response res;
-        res.set_header("Content-Type", "text/html");  // Užtikrinti teisingą turinio tipą
-        res.body = htmlContent;
-        return res;
-        });
+    // Įrašas dedamas ne toliau nei vienas rato apsisukimas; vėlesni terminai patikrinami ir perkeliami
+    void schedule(Shard& shard, std::size_t slot, Clock::time_point due, Clock::time_point now) {
+        std::uint64_t now_tick = tickOf(now);
+        std::uint64_t due_tick = std::clamp(tickOf(due), now_tick + 1, now_tick + kWheelSlots - 1);
+        shard.wheel[due_tick % kWheelSlots].push_back({ static_cast<std::uint16_t>(slot), shard.buckets[slot].generation, due_tick });
+    }
 
-    // Endpointas prisijungimui
-    CROW_ROUTE(app, "/login").methods("POST"_method)([&db](const crow::request& req) {
-        std::string body = req.body;
-        std::string username;
-        std::string password;
-
-        // Suskaidyti POST duomenis
-        
-        db.parseLoginData(body, username, password);
-
-        // Patikrinti, ar įvestas vartotojas yra teisingas ir gauti vartotojo rolę ir ID
-        std::pair<std::string, int> user = db.validateUser(username, password);  // Grąžinsime tiek rolę, tiek ID
-        std::string role = user.first;  // Pirmas elementas yra role
-        int user_id = user.second;  // Antras elementas yra user_id
-
-        if (!role.empty()) {
-            // Prisijungimas sėkmingas, nukreipiame į atitinkamą puslapį pagal vaidmenį
-            crow::response res;
-            res.code = 302;  // HTTP statusas - peradresavimas
+    // Kas kTick apdorojamos visų šukių tos pačios rato vietos; kiekviena šukė užrakinama trumpam atskirai
+    void sweep() {
+        std::uint64_t processed = tickOf(Clock::now());
+        std::unique_lock<std::mutex> lock(sweep_mutex_);
+        while (!sweep_cv_.wait_for(lock, kTick, [this]() { return stopping_; })) {
+            Clock::time_point now = Clock::now();
+            std::uint64_t current = tickOf(now);
+            // Jei gija vėlavo, praleistos vietos apdorojamos, bet ne daugiau nei vienas apsisukimas
+            processed = std::max(processed, current > kWheelSlots ? current - kWheelSlots : 0);
+            for (; processed < current; processed++) {
+                for (std::size_t s = 0; s < kShards; s++) {
+                    expire(shards_[s], processed + 1, now);
+                }
+            }
+        }
+    }
 
-            // Perduodame user_id URL kaip parametru
-            if (role == "Destytojas") {
-                res.add_header("Location", "/destytojas?teacher_id=" + std::to_string(user_id));  // Nukreipiame į dėstytojo puslapį su teacher_id
+    void expire(Shard& shard, std::uint64_t tick, Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::vector<WheelEntry> entries;
+        entries.swap(shard.wheel[tick % kWheelSlots]);
+        for (const WheelEntry& entry : entries) {
+            if (entry.due_tick > tick) {
+                shard.wheel[tick % kWheelSlots].push_back(entry);
+                continue;
             }
-            else if (role == "Studentas") {
-                res.add_header("Location", "/studentas?student_id=" + std::to_string(user_id));  // Nukreipiame į studento puslapį su student_id
+            Bucket& bucket = shard.buckets[entry.slot];
+            if (bucket.key == 0 || bucket.generation != entry.generation) {
+                continue;
             }
-            else if (role == "Administratorius") {
-                res.add_header("Location", "/administratorius");
+            Clock::time_point due = std::max(bucket.updated + config_.idle_ttl, bucket.locked_until);
+            if (due > now) {
+                schedule(shard, entry.slot, due, now);
+                continue;
             }
+            bucket.key = 0;
+            buckets_.fetch_sub(1, std::memory_order_relaxed);
+            expired_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Nenaudojamos rato vietos atmintis grąžinama tik kai jos prireikia vėl
+        if (shard.wheel[tick % kWheelSlots].empty()) {
+            entries.clear();
+            shard.wheel[tick % kWheelSlots].swap(entries);
+        }
+    }
 
-            return res;
+    Config config_;
+    std::unique_ptr<Shard[]> shards_;
+    Clock::time_point epoch_;
+    std::uint64_t seed_ = 0;
+
+    std::atomic<std::uint64_t> allowed_{ 0 };
+    std::atomic<std::uint64_t> limited_ip_{ 0 };
+    std::atomic<std::uint64_t> limited_user_{ 0 };
+    std::atomic<std::uint64_t> lockouts_{ 0 };
+    std::atomic<std::uint64_t> evicted_{ 0 };
+    std::atomic<std::uint64_t> expired_{ 0 };
+    std::atomic<std::uint64_t> buckets_{ 0 };
+
+    std::thread sweeper_;
+    std::mutex sweep_mutex_;
+    std::condition_variable sweep_cv_;
+    bool stopping_ = false;
+};
+
+// POST /login ribojimas prieš bet kokį DB darbą: per daug bandymų - 429 su Retry-After.
+// Rezultatas (302 - sėkmė, 400 - blogi duomenys) įrašomas after_handle, kai DB gija baigia.
+// IP imamas iš jungties: X-Forwarded-For nepasitikime, nes jį gali nustatyti pats klientas.
+struct LoginRateLimitMiddleware {
+    struct context {
+        bool active = false;
+        bool admitted = false;
+        std::uint64_t user_key = 0;
+    };
+
+    LoginRateLimiter& limiter() {
+        return limiter_;
+    }
+
+    void before_handle(crow::request& req, crow::response& res, context& ctx) {
+        ctx.active = false;
+        if (req.method != crow::HTTPMethod::Post || req.url != "/login") {
+            return;
         }
-        else {
-            // Prisijungimas nesėkmingas, grąžiname klaidos pranešimą
-            crow::response res(400);
-            res.body = "<html><body>Netinkami prisijungimo duomenys.<br></body>"
-                "<head><meta http-equiv='refresh' content='2.5; url=/'></head></html>";
-            return res;
+        ctx.active = true;
+        ctx.admitted = false;
+        ctx.user_key = 0;
+        std::optional<std::string_view> username = FormData(req.body).get("username");
+        if (username && !username->empty()) {
+            ctx.user_key = limiter_.key(LoginRateLimiter::Kind::User, *username);
         }
-        });
 
-    // Administratoriaus puslapis
-    CROW_ROUTE(app, "/administratorius")([&db]() {
-        std::string htmlContent = loadHTML("admin_dashboard.htm");
-        crow::response res;
+        LoginRateLimiter::Decision decision = limiter_.admit(limiter_.key(LoginRateLimiter::Kind::Ip, req.remote_ip_address), ctx.user_key);
+        if (decision.allowed) {
+            ctx.admitted = true;
+            return;
+        }
+        res.code = 429;
+        res.set_header("Retry-After", std::to_string(std::max<std::int64_t>(1, decision.retry_after.count())));
         res.set_header("Content-Type", "text/html");
-        res.body = htmlContent;
-        return res;
-        });
-    // Dėstytojo puslapis
-    CROW_ROUTE(app, "/destytojas")([&db](const crow::request& req) {
-        std::string htmlContent;
+        res.body = "<html><body>Per daug prisijungimo bandymu. Bandykite veliau.<br></body>"
+            "<head><meta http-equiv='refresh' content='5; url=/'></head></html>";
+        res.end();
+    }
 
-        htmlContent += "<button onclick=\"window.location.href='/';\" style='padding: 10px; font-size: 1.2em; position: absolute; top: 10px; right: 10px;'>Atsijungti</button>";
+    void after_handle(crow::request& /*req*/, crow::response& res, context& ctx) {
+        if (!ctx.active) {
+            return;
+        }
+        ctx.active = false;
+        // DB klaidos (500/503) nieko nepasako apie slaptažodį, todėl neskaičiuojamos
+        if (ctx.admitted && (res.code == 302 || res.code == 400)) {
+            limiter_.record(ctx.user_key, res.code == 302);
+        }
+    }
 
-        // Gauti dėstytojo ID iš URL parametrų (pvz., teacher_id=1)
-        std::string teacher_id_str = req.url_params.get("teacher_id");
-        int teacher_id = 0;
+private:
+    LoginRateLimiter limiter_;
+};
 
-        if (!teacher_id_str.empty()) {
-            teacher_id = std::stoi(teacher_id_str);
-        }
+// Su zlib (CROW_ENABLE_COMPRESSION) atsakymai suspaudžiami middleware, kitaip siunčiami kaip yra
+#ifdef CROW_ENABLE_COMPRESSION
+using WebApp = crow::App<MetricsMiddleware, TraceMiddleware, LoginRateLimitMiddleware, crow::CompressionMiddleware>;
+#else
+using WebApp = crow::App<MetricsMiddleware, TraceMiddleware, LoginRateLimitMiddleware>;
+#endif
 
-        sql::Connection* con = db.connect();
+int main() {
+    // Crow ir programos žurnalas rašomas foninėje gijoje: klaidų lavina (pvz., perkraunant DB)
+    // nebeužblokuoja darbo gijų ant stderr. Turi gyventi ilgiau už visas gijas, todėl kuriamas pirmas.
+    crow::AsyncLogHandler log_handler;
+    crow::logger::setHandler(&log_handler);
+
+    WebApp app;
+    // Visas užklausos turinys laikomas atmintyje (ir CSV importo failas), todėl didesnės užklausos
+    // atmetamos dar skaitant: jungtis uždaroma, o turinys nebuferizuojamas
+    constexpr std::size_t kMaxRequestBody = 8 * 1024 * 1024;
+    app.max_body_size(kMaxRequestBody);
+#ifdef CROW_ENABLE_COMPRESSION
+    // Mažų atsakymų ir jau suspaustų turinio tipų nespaudžiame; 6 lygis - geras santykis tarp CPU ir dydžio
+    app.get_middleware<crow::CompressionMiddleware>().level(6).min_size(1024);
+#endif
+
+    // Prisijungimo bandymai ribojami prieš DB: numatytosios ribos (žr. LoginRateLimiter::Config)
+    app.get_middleware<LoginRateLimitMiddleware>().limiter().start();
+
+    // Sukuriame MySQLDatabase objektą su ryšių telkiniu
+    MySQLDatabase::PoolConfig pool_config;
+    pool_config.min_size = 4;
+    pool_config.max_size = 32;
+    pool_config.idle_timeout = std::chrono::seconds(300);
+    pool_config.wait_timeout = std::chrono::milliseconds(2000);
+    MySQLDatabase db("127.0.0.1", "root", "Advokatinukas2134", "sys", pool_config);
+
+    // IO gijų ir DB gijų skaičiai parenkami atskirai: IO gijos tik skaito/rašo jungtis,
+    // o DB gijų neturi būti daugiau nei ryšių telkinyje.
+    const std::uint16_t io_threads = static_cast<std::uint16_t>(std::max(2u, std::thread::hardware_concurrency()));
+    const std::size_t db_threads = pool_config.max_size;
+    const std::size_t db_queue_limit = 1024;
+    DbExecutor db_executor(db_threads, db_queue_limit);
+
+    // Dalykų, grupių ir dėstytojų sąrašai administratoriaus puslapiams
+    ReferenceCache ref_cache(db);
+
+    // Apžvalgos puslapiai (/groupandsubjects ir kt.) perpiešiami tik pasikeitus jų lentelėms
+    RenderedPageCache page_cache(db);
+
+    // Administratoriaus puslapių šablonai (templates/ kataloge) kompiliuojami vieną kartą
+    TemplateRegistry templates("templates/");
+    for (const char* name : { "students.html", "teachers.html", "subjects.html", "groups.html",
+        "groupandsubjects.html", "teacherandsubjects.html", "groupandstudents.html" }) {
+        templates.add(name);
+    }
 
-        if (con) {
-            try {
-                std::string name, surname;
-                std::vector<std::pair<int, std::string>> subjects;
+    // Statiniai puslapiai laikomi atmintyje ir perkraunami pasikeitus failui
+    StaticPageStore pages("");
+    for (const char* name : { "Login.htm", "admin_dashboard.htm", "subject_students.html" }) {
+        pages.add(name);
+    }
+    pages.watch();
 
-                // Gauti dėstytojo informaciją
-                if (Teacher::getTeacherInfo(teacher_id, con, name, surname)) {
-                    htmlContent += "<h2>Sveiki, " + name + " " + surname + "!</h2>";
-                    htmlContent += "<h3>Jums priskirti destomi dalykai:</h3>";
+    // Bendras CSV importo apdorojimas studentams ir dėstytojams (multipart/form-data, laukas "file")
+    auto importCsv = [&db](const crow::request& req, bool teachers) {
+        const std::string back_url = teachers ? "/teachers" : "/students";
+        auto page = [&back_url](int code, const std::string& content) {
+            crow::response res(code);
+            res.set_header("Content-Type", "text/html");
+            res.body = "<html><body>" + content +
+                "<br><button onclick=\"window.location.href='" + back_url + "';\">Atgal</button></body></html>";
+            return res;
+        };
 
-                    // Gauti dėstytojui priskirtus dalykus
-                    if (Teacher::getSubjects(teacher_id, con, subjects)) {
-                        htmlContent += "<table border='1' style='width: 100%;'>";
-                        htmlContent += "<tr><th>Dalyko pavadinimas</th><th>Studentu sarasas</th></tr>";
+        if (req.get_header_value("Content-Type").find("multipart/form-data") == std::string::npos) {
+            return page(400, "Tikimasi multipart/form-data uzklausos su CSV failu.");
+        }
+        crow::multipart::message msg(req);
+        auto file_it = msg.part_map.find("file");
+        if (file_it == msg.part_map.end() || file_it->second.body.empty()) {
+            return page(400, "CSV failas nepateiktas arba tuscias.");
+        }
 
-                        // Užpildome lentelę
-                        for (const auto& subject : subjects) {
-                            htmlContent += "<tr><td>" + subject.second + "</td>";
-                            htmlContent += "<td><a href='/subject_students/" + std::to_string(subject.first) + "'>Perziureti studentus</a></td></tr>";
-                        }
-                        htmlContent += "</table>";
-                    }
-                    else {
-                        htmlContent += "<p>Jums nera priskirtu destomu dalyku.</p>";
-                    }
-                }
-                else {
-                    htmlContent += "<h2>Destytojas nerastas.</h2>";
-                }
+        Administrator admin(1, "Test", "Testas");
+        Administrator::ImportReport report = admin.importPeopleFromCsv(db, file_it->second.body, teachers);
+        if (!report.failure.empty()) {
+            return page(500, htmlEscape(report.failure));
+        }
+
+        std::string content = "<h1>Importo rezultatai</h1>";
+        content += "<p>Apdorota eiluciu: " + std::to_string(report.rows) + "</p>";
+        content += "<p>Prideta: " + std::to_string(report.inserted) +
+            " (paketu: " + std::to_string(report.batches) + ")</p>";
+        content += "<p>Dublikatu: " + std::to_string(report.duplicates) + "</p>";
+        content += "<p>Atmesta eiluciu: " + std::to_string(report.rejected) + "</p>";
+        if (!report.errors.empty()) {
+            content += "<table border='1'><tr><th>Eilute</th><th>Priezastis</th></tr>";
+            for (const auto& error : report.errors) {
+                content += "<tr><td>" + std::to_string(error.first) + "</td><td>" + htmlEscape(error.second) + "</td></tr>";
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida uzklausoje: " << e.what() << std::endl;
-                htmlContent = "<h2>Klaida uzklausoje: " + std::string(e.what()) + "</h2>";
+            content += "</table>";
+            if (report.errors.size() < report.rejected) {
+                content += "<p>Rodomos pirmos " + std::to_string(report.errors.size()) + " klaidos.</p>";
             }
-            delete con;
-        }
-        else {
-            htmlContent = "<h2>Nepavyko prisijungti prie duomenu bazes.</h2>";
         }
+        return page(200, content);
+    };
 
-        // HTML pabaiga
-        htmlContent += "</body></html>";
+    // Bendras masinio trynimo apdorojimas: forma siunčia lauką "ids" su ID sąrašu
+    auto bulkDelete = [&db](const crow::request& req, const std::string& back_url,
+        std::string (Administrator::*remove)(MySQLDatabase&, const std::vector<int>&)) {
+        FormData form(req.body);
+        std::optional<std::string_view> ids_value = form.get("ids");
+        std::vector<int> ids = ids_value ? parseIdList(*ids_value) : std::vector<int>();
 
-        // Grąžiname HTML turinį su UTF-8 antrašte
         crow::response res;
-        res.set_header("Content-Type", "text/html; charset=utf-8"); // Neveikia UTF-8 koduotė.....
-        res.body = htmlContent;
+        res.code = ids.empty() ? 400 : 200;
+        std::string message = "ID sarasas tuscias!";
+        if (!ids.empty()) {
+            Administrator admin(1, "Test", "Testas");
+            message = (admin.*remove)(db, ids);
+        }
+        res.body = "<html><head><meta http-equiv='refresh' content='3; url=" + back_url + "'></head><body>"
+            + message +
+            "<br></body></html>";
         return res;
+    };
+
+    // Pateikti prisijungimo puslapį
+    CROW_ROUTE(app, "/")([&pages](const crow::request& req) {
+        return pages.serve(req, "Login.htm");
         });
-    // Studento puslapis
-    CROW_ROUTE(app, "/studentas")([&db](const crow::request& req) {
-        std::string htmlContent;
 
-        // Gauti studento ID iš URL parametrų (pvz., ?student_id=1)
-        std::string student_id_str = req.url_params.get("student_id");
-        int student_id = 0;  // Numatytoji reikšmė, jei parametras nėra pateiktas
+    // Endpointas prisijungimui
+    CROW_ROUTE(app, "/login").methods("POST"_method)([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            std::string username;
+            std::string password;
+
+            // Suskaidyti POST duomenis
+            db.parseLoginData(req.body, username, password);
 
-        if (!student_id_str.empty()) {
-            student_id = std::stoi(student_id_str);  // Jei parametras yra, konvertuoti į int
-        }
+            // Patikrinti, ar įvestas vartotojas yra teisingas ir gauti vartotojo rolę ir ID
+            std::pair<std::string, int> user = db.validateUser(username, password);  // Grąžinsime tiek rolę, tiek ID
+            std::string role = user.first;  // Pirmas elementas yra role
+            int user_id = user.second;  // Antras elementas yra user_id
 
-        sql::Connection* con = db.connect();
+            if (!role.empty()) {
+                // Prisijungimas sėkmingas, nukreipiame į atitinkamą puslapį pagal vaidmenį
+                crow::response res;
+                res.code = 302;  // HTTP statusas - peradresavimas
 
-        if (con) {
-            try {
-                std::string name, surname;
-                std::vector<std::pair<std::string, std::string>> subjects;
-                htmlContent += "<button onclick=\"window.location.href='/';\" style='padding: 10px; font-size: 1.2em; position: absolute; top: 10px; right: 10px;'>Atsijungti</button>";
+                // Perduodame user_id URL kaip parametru
+                if (role == "Destytojas") {
+                    res.add_header("Location", "/destytojas?teacher_id=" + std::to_string(user_id));  // Nukreipiame į dėstytojo puslapį su teacher_id
+                }
+                else if (role == "Studentas") {
+                    res.add_header("Location", "/studentas?student_id=" + std::to_string(user_id));  // Nukreipiame į studento puslapį su student_id
+                }
+                else if (role == "Administratorius") {
+                    res.add_header("Location", "/administratorius");
+                }
+
+                return res;
+            }
+            else {
+                // Prisijungimas nesėkmingas, grąžiname klaidos pranešimą
+                crow::response res(400);
+                res.body = "<html><body>Netinkami prisijungimo duomenys.<br></body>"
+                    "<head><meta http-equiv='refresh' content='2.5; url=/'></head></html>";
+                return res;
+            }
+        });
+        });
+
+    // Administratoriaus puslapis
+    CROW_ROUTE(app, "/administratorius")([&pages](const crow::request& req) {
+        return pages.serve(req, "admin_dashboard.htm");
+        });
+    // Dėstytojo puslapis
+    CROW_ROUTE(app, "/destytojas")([&db, &db_executor](const crow::request& req, crow::response& res) {
+        // Gauti dėstytojo ID iš URL parametrų (pvz., teacher_id=1)
+        int teacher_id = 0;
+        if (!parseId(req.url_params.get("teacher_id"), teacher_id)) {
+            res.code = 400;
+            res.end("Blogai nurodytas destytojo ID.");
+            return;
+        }
+        std::string etag = versionETag("te", db.tablesVersion({
+            MySQLDatabase::Table::Teachers, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::TeacherSubjects }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, teacher_id]() {
+            std::string htmlContent;
+            int code = 200;  // klaidos puslapiai grąžinami ne su 200, kad negautų ETag
 
-                // Naudojame Student klasės metodą gauti informacijai apie studentą
-                if (Student::getStudentData(student_id, con, name, surname, subjects)) {
-                    // Pasisveikinimas su studentu
-                    htmlContent += "<h2>Sveiki, " + name + " " + surname + "!</h2>";
-                    htmlContent += "<h3>Destomu dalyku lentele su pazymiais:</h3>";
+            htmlContent += "<button onclick=\"window.location.href='/';\" style='padding: 10px; font-size: 1.2em; position: absolute; top: 10px; right: 10px;'>Atsijungti</button>";
 
-                    // Lentelės pradžia
-                    htmlContent += "<table border='1' style='width: 100%;'>";
-                    htmlContent += "<tr><th>Dalyko pavadinimas</th><th>Pazymys</th></tr>";
+            MySQLDatabase::ConnectionLease con = db.acquire();
 
-                    // Užpildome lentelę su dalykais ir pažymiais
-                    if (subjects.empty()) {
-                        htmlContent += "<tr><td colspan='2'>Studentas neturi priskirtu dalyku.</td></tr>";
+            if (con) {
+                try {
+                    std::string name, surname;
+                    std::vector<std::pair<int, std::string>> subjects;
+
+                    // Gauti dėstytojo informaciją
+                    if (Teacher::getTeacherInfo(teacher_id, con, name, surname)) {
+                        htmlContent += "<h2>Sveiki, " + htmlEscape(name) + " " + htmlEscape(surname) + "!</h2>";
+                        htmlContent += "<h3>Jums priskirti destomi dalykai:</h3>";
+
+                        // Gauti dėstytojui priskirtus dalykus
+                        if (Teacher::getSubjects(teacher_id, con, subjects)) {
+                            htmlContent += "<table border='1' style='width: 100%;'>";
+                            htmlContent += "<tr><th>Dalyko pavadinimas</th><th>Studentu sarasas</th></tr>";
+
+                            // Užpildome lentelę
+                            for (const auto& subject : subjects) {
+                                htmlContent += "<tr><td>" + htmlEscape(subject.second) + "</td>";
+                                htmlContent += "<td><a href='/subject_students/" + std::to_string(subject.first) + "'>Perziureti studentus</a></td></tr>";
+                            }
+                            htmlContent += "</table>";
+                        }
+                        else {
+                            htmlContent += "<p>Jums nera priskirtu destomu dalyku.</p>";
+                        }
                     }
                     else {
-                        for (const auto& subject : subjects) {
-                            htmlContent += "<tr><td>" + subject.first + "</td><td>" + subject.second + "</td></tr>";
-                        }
+                        htmlContent += "<h2>Destytojas nerastas.</h2>";
                     }
-
-                    htmlContent += "</table>";
                 }
-                else {
-                    htmlContent += "<h2>Studentas nerastas.</h2>";
+                catch (sql::SQLException& e) {
+                    CROW_LOG_ERROR << "Klaida uzklausoje: " << e.what();
+                    htmlContent = "<h2>Klaida uzklausoje: " + std::string(e.what()) + "</h2>";
+                    code = 500;
                 }
             }
-            catch (sql::SQLException& e) {
-                std::cerr << "Klaida uzklausoje: " << e.what() << std::endl;
-                htmlContent = "<h2>Ivyko klaida apdorojant uzklausa.</h2>";
+            else {
+                htmlContent = "<h2>Nepavyko prisijungti prie duomenu bazes.</h2>";
+                code = 503;
             }
-            delete con;
-        }
-        else {
-            htmlContent = "<h2>Nepavyko prisijungti prie duomenu bazes.</h2>";
-        }
 
-        // Grąžiname HTML turinį
-        crow::response res;
-        res.set_header("Content-Type", "text/html; charset=utf-8");
-        res.body = htmlContent;
-        return res;
+            // HTML pabaiga
+            htmlContent += "</body></html>";
+
+            // Grąžiname HTML turinį su UTF-8 antrašte
+            crow::response res(code);
+            res.set_header("Content-Type", "text/html; charset=utf-8"); // Neveikia UTF-8 koduotė.....
+            res.body = htmlContent;
+            return res;
+        });
         });
+    // Studento puslapis
+    CROW_ROUTE(app, "/studentas")([&db, &db_executor](const crow::request& req, crow::response& res) {
+        // Gauti studento ID iš URL parametrų (pvz., ?student_id=1); tas pats ID naudojamas ir ETag, ir puslapiui
+        int student_id = 0;
+        if (!parseId(req.url_params.get("student_id"), student_id)) {
+            res.code = 400;
+            res.end("Blogai nurodytas studento ID.");
+            return;
+        }
+        // Puslapis priklauso nuo studento pažymių ir dalykų, dalykų pavadinimų ir paties studento įrašo
+        std::string etag = versionETag("st", db.studentVersion(student_id) + db.tablesVersion({
+            MySQLDatabase::Table::Students, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::GroupSubjects }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, student_id]() {
+            std::string htmlContent;
+            int code = 200;  // klaidos puslapiai grąžinami ne su 200, kad negautų ETag
+
+            MySQLDatabase::ConnectionLease con = db.acquire();
 
-    // Studentų sąrašo (pagal dėstomus dalykus) maršrutas
-    CROW_ROUTE(app, "/subject_students/<int>").methods("GET"_method)([&db](const crow::request& req, int subject_id) {
-        std::string htmlContent = loadHTML("subject_students.html");
-        if (req.method == crow::HTTPMethod::GET) {
-            sql::Connection* con = db.connect();
             if (con) {
                 try {
-                    std::string subject_name;
-                    std::string students_html;
-
-                    // Gauti dalyko informaciją
-                    if (Teacher::getSubjectInfo(subject_id, con, subject_name)) {
-                        // Pakeičiame {{subject_name}} vietas su tikru pavadinimu
-                        size_t pos = 0;
-                        while ((pos = htmlContent.find("{{subject_name}}", pos)) != std::string::npos) {
-                            htmlContent.replace(pos, 16, subject_name);
-                            pos += subject_name.length(); // pereina prie kitos vietos
-                        }
+                    std::string name, surname;
+                    std::vector<std::pair<std::string, std::string>> subjects;
+                    htmlContent += "<button onclick=\"window.location.href='/';\" style='padding: 10px; font-size: 1.2em; position: absolute; top: 10px; right: 10px;'>Atsijungti</button>";
 
-                        // Pakeičiame {{subject_id}} vietas su tikru subject_id
-                        pos = 0;
-                        while ((pos = htmlContent.find("{{subject_id}}", pos)) != std::string::npos) {
-                            htmlContent.replace(pos, 14, std::to_string(subject_id));
-                            pos += std::to_string(subject_id).length(); // pereina prie kitos vietos
-                        }
+                    // Naudojame Student klasės metodą gauti informacijai apie studentą
+                    if (Student::getStudentData(student_id, con, name, surname, subjects)) {
+                        // Pasisveikinimas su studentu
+                        htmlContent += "<h2>Sveiki, " + htmlEscape(name) + " " + htmlEscape(surname) + "!</h2>";
+                        htmlContent += "<h3>Destomu dalyku lentele su pazymiais:</h3>";
 
-                        // Gauti studentus susijusius su šiuo dalyku
-                        if (Teacher::getStudentsForSubject(subject_id, con, students_html)) {
-                            // Pakeičiame {{students}} su studentų sąrašu
-                            size_t pos = htmlContent.find("{{students}}");
-                            if (pos != std::string::npos) {
-                                htmlContent.replace(pos, 12, students_html);
-                            }
+                        // Lentelės pradžia
+                        htmlContent += "<table border='1' style='width: 100%;'>";
+                        htmlContent += "<tr><th>Dalyko pavadinimas</th><th>Pazymys</th></tr>";
+
+                        // Užpildome lentelę su dalykais ir pažymiais
+                        if (subjects.empty()) {
+                            htmlContent += "<tr><td colspan='2'>Studentas neturi priskirtu dalyku.</td></tr>";
                         }
                         else {
-                            // Jei nėra studentų
-                            size_t pos = htmlContent.find("{{students}}");
-                            if (pos != std::string::npos) {
-                                htmlContent.replace(pos, 12, "<tr><td colspan='4'>Nera studentu siam dalykui.</td></tr>");
+                            for (const auto& subject : subjects) {
+                                htmlContent += "<tr><td>" + htmlEscape(subject.first) + "</td><td>" + htmlEscape(subject.second) + "</td></tr>";
                             }
                         }
+
+                        htmlContent += "</table>";
                     }
                     else {
-                        htmlContent += "<p>Dalykas nerastas.</p>";
+                        htmlContent += "<h2>Studentas nerastas.</h2>";
                     }
                 }
                 catch (sql::SQLException& e) {
-                    std::cerr << "SQL klaida: " << e.what() << std::endl;
-                    htmlContent = "<h2>SQL klaida: " + std::string(e.what()) + "</h2>";
+                    CROW_LOG_ERROR << "Klaida uzklausoje: " << e.what();
+                    htmlContent = "<h2>Ivyko klaida apdorojant uzklausa.</h2>";
+                    code = 500;
                 }
-                delete con;
+            }
+            else {
+                htmlContent = "<h2>Nepavyko prisijungti prie duomenu bazes.</h2>";
+                code = 503;
             }
 
-            crow::response res;
-            res.set_header("Content-Type", "text/html");
+            // Grąžiname HTML turinį
+            crow::response res(code);
+            res.set_header("Content-Type", "text/html; charset=utf-8");
             res.body = htmlContent;
             return res;
-        }
-
-        return crow::response(404, "Nerasta.");
         });
-    // Maršrutas pažymio pridėjimui
-    CROW_ROUTE(app, "/add_grade")
-        .methods("POST"_method)([&db](const crow::request& req) {
-        try {
-            auto json = crow::json::load(req.body);
-            if (!json) {
-                return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
-            }
+        });
 
-            int student_id = json["student_id"].i();
-            int grade = json["grade"].i();
-            int subject_id = json["subject_id"].i();
+    // Studentų sąrašo (pagal dėstomus dalykus) maršrutas
+    CROW_ROUTE(app, "/subject_students/<int>").methods("GET"_method)([&db, &db_executor, &pages](const crow::request& req, crow::response& res, int subject_id) {
+        db_executor.respond(req, res, [&db, &req, &pages, subject_id]() {
+            // Puslapio šablonas jau suskaidytas į dalis, todėl pildoma vienu praėjimu
+            std::shared_ptr<const StaticPageStore::Page> page = pages.page("subject_students.html");
+            std::string htmlContent;
+            if (req.method == crow::HTTPMethod::GET) {
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (con) {
+                    try {
+                        std::string subject_name;
+                        std::string students_html;
+
+                        // Gauti dalyko informaciją
+                        if (Teacher::getSubjectInfo(subject_id, con, subject_name)) {
+                            // Gauti studentus susijusius su šiuo dalyku
+                            if (!Teacher::getStudentsForSubject(subject_id, con, students_html)) {
+                                students_html = "<tr><td colspan='5'>Nera studentu siam dalykui.</td></tr>";
+                            }
 
-            sql::Connection* con = db.connect();
-            if (con) {
-                try {
-                    // Patikriname, ar studentas egzistuoja
-                    if (!Teacher::checkStudentExistence(student_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Tokio studento nera.\"}");
+                            // Puslapio karkasas siunčiamas iš atminties be kopijavimo, kopijuojamos tik įstatomos reikšmės
+                            std::string id_text = std::to_string(subject_id);
+                            crow::response res;
+                            res.set_header("Content-Type", "text/html");
+                            page->layout.render_to(res, {
+                                { "subject_name", subject_name },
+                                { "subject_id", id_text },
+                                { "students", students_html } }, page);
+                            return res;
+                        }
+                        else {
+                            htmlContent = page->body + "<p>Dalykas nerastas.</p>";
+                        }
                     }
-
-                    // Patikriname, ar studentas yra priskirtas tam tikram dalykui
-                    if (!Teacher::checkStudentSubjectAssignment(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas nera priskirtas siam dalykui.\"}");
+                    catch (sql::SQLException& e) {
+                        CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                        htmlContent = "<h2>SQL klaida: " + std::string(e.what()) + "</h2>";
                     }
+                }
+                else {
+                    htmlContent = page->body;
+                }
 
-                    // Patikriname, ar studentas jau turi pažymį šiam dalykui
-                    if (Teacher::checkStudentGradeExistence(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas jau turi pazymi siam dalykui.\"}");
-                    }
+                crow::response res;
+                res.set_header("Content-Type", "text/html");
+                res.body = std::move(htmlContent);
+                return res;
+            }
+
+            return crow::response(404, "Nerasta.");
+        });
+        });
+    // Maršrutas pažymio pridėjimui
+    CROW_ROUTE(app, "/add_grade")
+        .methods("POST"_method)([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            try {
+                auto json = crow::json::load(req.body);
+                if (!json) {
+                    return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
+                }
+
+                int student_id = json["student_id"].i();
+                int grade = json["grade"].i();
+                int subject_id = json["subject_id"].i();
 
-                    // Pridedame naują pažymį
-                    if (Teacher::addGrade(student_id, subject_id, grade, con)) {
-                        return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai pridetas.\"}");
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (con) {
+                    try {
+                        // Vienas sakinys patikrina priskyrimą bei esamą pažymį ir įrašo naują
+                        Teacher::GradeResult result = Teacher::addGrade(student_id, subject_id, grade, con);
+                        if (result == Teacher::GradeResult::Ok) {
+                            db.touchGrades(student_id);
+                            return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai pridetas.\"}");
+                        }
+                        return crow::response(400, Teacher::gradeErrorJson(result));
                     }
-                    else {
-                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Nepavyko prideti pazymio.\"}");
+                    catch (sql::SQLException& e) {
+                        CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
                     }
                 }
-                catch (sql::SQLException& e) {
-                    std::cerr << "SQL klaida: " << e.what() << std::endl;
-                    return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
-                }
-                delete con;
-            }
 
-            return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
-        }
-        catch (const std::exception& e) {
-            return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
-        }
+                return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
+            catch (const std::exception& e) {
+                return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
+            }
+        });
             });
 
 // Maršrutas pažymio ištrynimui pagal studento ID
     CROW_ROUTE(app, "/delete_grade/<int>") // Maršrutas priima <subject_id>
-        .methods("POST"_method)([&db](const crow::request& req, int subject_id) {
-        try {
-            auto json = crow::json::load(req.body);
-            if (!json) {
-                return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
-            }
-
-            auto student_id = json["student_id"].i();
-
-            sql::Connection* con = db.connect();
-            if (con) {
-                try {
-                    // Patikriname, ar studentas egzistuoja
-                    if (!Teacher::checkStudentExistence(student_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Tokio studento nera.\"}");
-                    }
-
-                    // Patikriname, ar studentas yra priskirtas tam tikram dalykui
-                    if (!Teacher::checkStudentSubjectAssignment(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas nera priskirtas siam dalykui.\"}");
-                    }
+        .methods("POST"_method)([&db, &db_executor](const crow::request& req, crow::response& res, int subject_id) {
+        db_executor.respond(req, res, [&db, &req, subject_id]() {
+            try {
+                auto json = crow::json::load(req.body);
+                if (!json) {
+                    return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
+                }
 
-                    // Patikriname, ar studentas turi pažymį šiam dalykui
-                    if (!Teacher::checkStudentGradeExistence(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas neturi pazymio siam dalykui.\"}");
-                    }
+                auto student_id = json["student_id"].i();
 
-                    // Ištriname pažymį
-                    if (Teacher::deleteGrade(student_id, subject_id, con)) {
-                        return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai istrintas.\"}");
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (con) {
+                    try {
+                        // Ištriname pažymį, jei studentas priskirtas dalykui ir pažymį turi
+                        Teacher::GradeResult result = Teacher::deleteGrade(student_id, subject_id, con);
+                        if (result == Teacher::GradeResult::Ok) {
+                            db.touchGrades(static_cast<int>(student_id));
+                            return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai istrintas.\"}");
+                        }
+                        return crow::response(400, Teacher::gradeErrorJson(result));
                     }
-                    else {
-                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Nepavyko istrinti pazymio.\"}");
+                    catch (sql::SQLException& e) {
+                        CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
                     }
                 }
-                catch (sql::SQLException& e) {
-                    std::cerr << "SQL klaida: " << e.what() << std::endl;
-                    return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
-                }
-                delete con;
-            }
 
-            return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
-        }
-        catch (const std::exception& e) {
-            return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
-        }
-            });
-    // Pažymio koregavimo maršrutas
-    CROW_ROUTE(app, "/update_grade").methods("POST"_method)([&db](const crow::request& req) {
-        try {
-            auto json = crow::json::load(req.body);
-            if (!json) {
+                return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
+            catch (const std::exception& e) {
                 return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
             }
+        });
+            });
+    // Pažymio koregavimo maršrutas
+    CROW_ROUTE(app, "/update_grade").methods("POST"_method)([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            try {
+                auto json = crow::json::load(req.body);
+                if (!json) {
+                    return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
+                }
 
-            int student_id = json["student_id"].i();
-            int new_grade = json["grade"].i();
-            int subject_id = json["subject_id"].i();
+                int student_id = json["student_id"].i();
+                int new_grade = json["grade"].i();
+                int subject_id = json["subject_id"].i();
 
-            sql::Connection* con = db.connect();
-            if (con) {
-                try {
-                    // Patikriname, ar studentas egzistuoja
-                    if (!Teacher::checkStudentExistence(student_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Tokio studento nera.\"}");
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (con) {
+                    try {
+                        // Atnaujiname pažymį, jei jis yra ir skiriasi nuo naujo
+                        Teacher::GradeResult result = Teacher::updateGrade(student_id, new_grade, subject_id, con);
+                        if (result == Teacher::GradeResult::Ok) {
+                            db.touchGrades(student_id);
+                            return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai atnaujintas.\"}");
+                        }
+                        return crow::response(400, Teacher::gradeErrorJson(result));
                     }
-
-                    // Patikriname, ar studentas yra priskirtas tam tikram dalykui
-                    if (!Teacher::checkStudentSubjectAssignment(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas nera priskirtas siam dalykui.\"}");
+                    catch (sql::SQLException& e) {
+                        CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
                     }
+                }
 
-                    // Patikriname, ar studentas turi pažymį šiam dalykui
-                    if (!Teacher::checkStudentGradeExistence(student_id, subject_id, con)) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Studentas neturi pazymio siam dalykui.\"}");
-                    }
+                return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
+            catch (const std::exception& e) {
+                return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
+            }
+        });
+        });
+    // Viso dalyko studentų sąrašo pažymių keitimas vienu kartu.
+    // Laukiamas JSON masyvas: [{"student_id": 1, "grade": 9}, {"student_id": 2, "delete": true}, ...]
+    CROW_ROUTE(app, "/subjects/<int>/grades/batch").methods("POST"_method)
+        ([&db, &db_executor](const crow::request& req, crow::response& res, int subject_id) {
+        db_executor.respond(req, res, [&db, &req, subject_id]() {
+            std::vector<Teacher::GradeChange> changes;
+            try {
+                auto json = crow::json::load(req.body);
+                if (!json || json.t() != crow::json::type::List) {
+                    return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON array\"}");
+                }
+                changes.reserve(json.size());
+                for (const auto& item : json) {
+                    bool remove = item.has("delete") && item["delete"].b();
+                    int grade = remove ? 0 : static_cast<int>(item["grade"].i());
+                    changes.push_back({ static_cast<int>(item["student_id"].i()), grade, remove });
+                }
+            }
+            catch (const std::exception& e) {
+                return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON array\"}");
+            }
 
-                    // Patikriname, ar naujas pažymys nesutampa su esamu
-                    int current_grade = Teacher::getCurrentGrade(student_id, subject_id, con);
-                    if (current_grade == new_grade) {
-                        return crow::response(400, "{\"status\": \"error\", \"message\": \"Naujas pazymys yra toks pats kaip senas.\"}");
-                    }
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
 
-                    // Atnaujiname pažymį
-                    if (Teacher::updateGrade(student_id, new_grade, subject_id, con)) {
-                        return crow::response(200, "{\"status\": \"success\", \"message\": \"Pazymys sekmingai atnaujintas.\"}");
-                    }
-                    else {
-                        return crow::response(500, "{\"status\": \"error\", \"message\": \"Nepavyko atnaujinti pazymio.\"}");
+            try {
+                std::vector<Teacher::GradeChangeResult> results = Teacher::applyGradeBatch(subject_id, changes, con);
+                for (const auto& result : results) {
+                    if (result.result == Teacher::GradeResult::Ok) {
+                        db.touchGrades(result.student_id);
                     }
                 }
-                catch (sql::SQLException& e) {
-                    std::cerr << "SQL klaida: " << e.what() << std::endl;
-                    return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
+
+                crow::json::wvalue body;
+                body["status"] = "success";
+                std::vector<crow::json::wvalue> rows;
+                rows.reserve(results.size());
+                for (const auto& result : results) {
+                    crow::json::wvalue row;
+                    row["student_id"] = result.student_id;
+                    row["status"] = result.result == Teacher::GradeResult::Ok ? "success" : "error";
+                    row["message"] = result.message;
+                    rows.push_back(std::move(row));
                 }
-                delete con;
+                body["results"] = std::move(rows);
+                return crow::response(200, body);
             }
-
-            return crow::response(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
-        }
-        catch (const std::exception& e) {
-            return crow::response(400, "{\"status\": \"error\", \"message\": \"Invalid JSON object\"}");
-        }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                return crow::response(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
+            }
+        });
         });
     // Maršrutas grupės ir dėstomo dalyko ištrinimui
     CROW_ROUTE(app, "/delete_groupandsubjects").methods("POST"_method)
-        ([&db](const crow::request& req) {
-        std::string body = req.body;
-        int group_id, subject_id;
-        try {
-            // Parsiname parametrus iš užklausos
-            group_id = std::stoi(body.substr(body.find("group_id=") + 9));
-            subject_id = std::stoi(body.substr(body.find("subject_id=") + 11));
-        }
-        catch (...) {
-            return crow::response(400, "Blogai pateikti duomenys.");
-        }
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            FormData form(req.body);
+            int group_id, subject_id;
+            if (!form.getInt("group_id", group_id) || !form.getInt("subject_id", subject_id)) {
+                return crow::response(400, "Blogai pateikti duomenys.");
+            }
 
-        sql::Connection* con = db.connect();
-        Administrator admin(1, "Test", "Testas");
-        std::string result = admin.deleteGroupAndSubjectsFromDatabase(con, group_id, subject_id);
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            Administrator admin(1, "Test", "Testas");
+            std::string result = admin.deleteGroupAndSubjectsFromDatabase(db, con, group_id, subject_id);
+
+            // Jei atsakymas turi klaidą
+            if (result.find("Grupe su ID") != std::string::npos ||
+                result.find("Dalykas su ID") != std::string::npos ||
+                result.find("Grupe su ID") != std::string::npos) {
+                return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head>"
+                    "<body>" + result + "<br></body></html>");
+            }
 
-        // Jei atsakymas turi klaidą
-        if (result.find("Grupe su ID") != std::string::npos ||
-            result.find("Dalykas su ID") != std::string::npos ||
-            result.find("Grupe su ID") != std::string::npos) {
+            // Jei pašalinimas sėkmingas:
             return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head>"
                 "<body>" + result + "<br></body></html>");
-        }
-
-        // Jei pašalinimas sėkmingas:
-        return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head>"
-            "<body>" + result + "<br></body></html>");
+        });
             });
     // Grupės su dėstomų dalykų pridėjimas (maršrutas)
     CROW_ROUTE(app, "/add_groupandsubjects").methods("POST"_method)
-        ([&db](const crow::request& req) {
-        std::string body = req.body;
-        int group_id, subject_id;
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            FormData form(req.body);
+            int group_id, subject_id;
+            if (!form.getInt("group_id", group_id) || !form.getInt("subject_id", subject_id)) {
+                return crow::response(400, "Blogai pateikti duomenys.");
+            }
 
-        try {
-            // Parsiname parametrus iš užklausos
-            group_id = std::stoi(body.substr(body.find("group_id=") + 9));
-            subject_id = std::stoi(body.substr(body.find("subject_id=") + 11));
-        }
-        catch (...) {
-            return crow::response(400, "Blogai pateikti duomenys.");
-        }
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            Administrator admin(1, "Test", "Testas");
+            std::string result = admin.addGroupAndSubjectsToDatabase(db, con, group_id, subject_id);
 
-        sql::Connection* con = db.connect();
-        Administrator admin(1, "Test", "Testas");
-        std::string result = admin.addGroupAndSubjectsToDatabase(con, group_id, subject_id);
+            // Patikriname, ar rezultatas nėra tuščias klaidos pranešimui
+            if (result.find("Šis dalykas jau priskirtas") != std::string::npos ||
+                result.find("Grupe su ID") != std::string::npos ||
+                result.find("Dalykas su ID") != std::string::npos) {
+                return crow::response(400, "<html><body>" + result + "<br></body>"
+                    "<head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head></html>");
+            }
 
-        // Patikriname, ar rezultatas nėra tuščias klaidos pranešimui
-        if (result.find("Šis dalykas jau priskirtas") != std::string::npos ||
-            result.find("Grupe su ID") != std::string::npos ||
-            result.find("Dalykas su ID") != std::string::npos) {
-            return crow::response(400, "<html><body>" + result + "<br></body>"
+            // Jei viskas gerai, grąžiname sėkmės pranešimą
+            return crow::response(200, "<html><body>" + result + "!</body>"
                 "<head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head></html>");
-        }
-
-        // Jei viskas gerai, grąžiname sėkmės pranešimą
-        return crow::response(200, "<html><body>" + result + "!</body>"
-            "<head><meta http-equiv='refresh' content='2.5; url=/groupandsubjects'></head></html>");
+        });
             });
     // pgr. Langas grupių ir dėstomų dalykų
     CROW_ROUTE(app, "/groupandsubjects")
-        ([&db]() {
-        sql::Connection* con = db.connect();
-        std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-        // Kairėje - visų grupių ir dalykų lentelės
-        htmlContent += "<h2></h2>";
-        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-        htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-
-        // 1. Lentelė - Grupės
-        htmlContent += "<h2>Grupes</h2>";
-        htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-        htmlContent += "<tr><th>ID</th><th>Grupes pavadinimas</th></tr>";
-
-        // Naudojame getAllGroupsFromDatabase funkciją
-        Administrator admin(1, "Test", "Testas");
-        std::vector<std::tuple<int, std::string>> groups = admin.getAllGroupsFromDatabase(con);
-        for (const auto& group : groups) {
-            int group_id = std::get<0>(group);
-            std::string group_name = std::get<1>(group);
-            htmlContent += "<tr><td>" + std::to_string(group_id) + "</td><td>" + group_name + "</td></tr>";
-        }
-        htmlContent += "</table>";
-
-        // 2. Lentelė - Dalykų sąrašas
-        htmlContent += "<h2>Destomi Dalykai</h2>";
-        htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-        htmlContent += "<tr><th>ID</th><th>Pavadinimas</th></tr>";
-
-        // Naudojame getSubjectsFromDatabase funkciją
-        std::vector<std::tuple<int, std::string>> subjects = admin.getSubjectsFromDatabase(con);
-        for (const auto& subject : subjects) {
-            int subject_id = std::get<0>(subject);
-            std::string subject_name = std::get<1>(subject);
-            htmlContent += "<tr><td>" + std::to_string(subject_id) + "</td><td>" + subject_name + "</td></tr>";
-        }
-        htmlContent += "</table>";
-
-        // 3. Lentelė - Grupės su priskirtais dalykais
-        htmlContent += "<h2>Grupes su priskirtais dalykais</h2>";
-        htmlContent += "<table border='1' style='width: 100%;'>";
-        htmlContent += "<tr><th>Grupes ID</th><th>Grupes pavadinimas</th><th>Dalyko ID</th><th>Destomo dalyko pavadinimas</th></tr>";
-
-        // Naudojame getGroupSubjects funkciją
-        std::vector<std::tuple<int, std::string, int, std::string>> groupSubjects = admin.getGroupSubjects(con);
-        for (const auto& groupSubject : groupSubjects) {
-            int group_id = std::get<0>(groupSubject);
-            std::string group_name = std::get<1>(groupSubject);
-            int subject_id = std::get<2>(groupSubject);
-            std::string subject_name = std::get<3>(groupSubject);
-
-            // Jei dalykas nepriskirtas, rodyti "Nėra dalyko"
-            if (subject_id == 0) {
-                htmlContent += "<tr><td>" + std::to_string(group_id) + "</td><td>" + group_name + "</td><td colspan='2'>Nera destomo dalyko</td></tr>";
-            }
-            else {
-                htmlContent += "<tr><td>" + std::to_string(group_id) + "</td><td>" + group_name + "</td><td>" + std::to_string(subject_id) + "</td><td>" + subject_name + "</td></tr>";
-            }
-        }
-        htmlContent += "</table>";
-
-        htmlContent += "</div>";  // Užbaigiame kairės pusės div'ą
-
-        // Dešinėje - forma grupės ir dalyko priskyrimui
-        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-        htmlContent += "<h1>Priskirti grupe destomui dalykui</h1>";
-
-        // Forma priskyrimo
-        htmlContent += "<form action='/add_groupandsubjects' method='POST'>";
-        htmlContent += "<label for='group_id'>Grupes ID:</label><br>";
-        htmlContent += "<input type='number' name='group_id' required><br><br>";
-        htmlContent += "<label for='subject_id'>Dalyko ID:</label><br>";
-        htmlContent += "<input type='number' name='subject_id' required><br><br>";
-        htmlContent += "<button type='submit'>Priskirti grupe destomui dalykui</button>";
-        htmlContent += "</form>";
-
-        htmlContent += "<h1>Pasalinti destoma dalyka is grupes</h1>";
-
-        // Forma pašalinimo
-        htmlContent += "<form action='/delete_groupandsubjects' method='POST'>";
-        htmlContent += "<label for='group_id'>Grupes ID:</label><br>";
-        htmlContent += "<input type='number' name='group_id' required><br><br>";
-        htmlContent += "<label for='subject_id'>Dalyko ID:</label><br>";
-        htmlContent += "<input type='number' name='subject_id' required><br><br>";
-        htmlContent += "<button type='submit'>Pasalinti destoma dalyka is grupes</button>";
-        htmlContent += "</form>";
+        ([&db, &db_executor, &ref_cache, &templates, &page_cache](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("ov", db.tablesVersion({ MySQLDatabase::Table::Groups, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::GroupSubjects }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, &ref_cache, &templates, &page_cache, &req]() {
+            return page_cache.serve(req, "/groupandsubjects", { MySQLDatabase::Table::Groups, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::GroupSubjects }, [&]() {
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (!con) {
+                    return crow::response(503, "Nepavyko prisijungti prie duomenu bazes.");
+                }
+                Administrator admin(1, "Test", "Testas");
 
-        htmlContent += "</div>";  // Užbaigiame dešinės pusės div'ą
-        htmlContent += "</div>";  // Užbaigiame pagrindinį div'ą
+                // Nepilnas puslapis negrąžinamas su 200, kad neliktų talpykloje iki kito lentelių pakeitimo
+                bool groups_ok, subjects_ok, rows_ok;
+                crow::mustache::context ctx;
+                ctx["groups"] = namedRows(*ref_cache.groups(&groups_ok));
+                ctx["subjects"] = namedRows(*ref_cache.subjects(&subjects_ok));
 
-        // Grąžiname HTML turinį
-        crow::response res;
-        res.set_header("Content-Type", "text/html");
-        res.body = htmlContent;
-        return res;
+                // Grupės su priskirtais dalykais (subject_id == 0 - dalykas nepriskirtas)
+                std::vector<std::tuple<int, std::string, int, std::string>> groupSubjects = admin.getGroupSubjects(con, rows_ok);
+                if (!groups_ok || !subjects_ok || !rows_ok) {
+                    return crow::response(503, "Nepavyko nuskaityti duomenu, bandykite veliau.");
+                }
+                std::vector<crow::mustache::context> rows;
+                rows.reserve(groupSubjects.size());
+                for (const auto& groupSubject : groupSubjects) {
+                    crow::mustache::context row;
+                    row["group_id"] = std::get<0>(groupSubject);
+                    row["group_name"] = std::get<1>(groupSubject);
+                    row["assigned"] = std::get<2>(groupSubject) != 0;
+                    row["subject_id"] = std::get<2>(groupSubject);
+                    row["subject_name"] = std::get<3>(groupSubject);
+                    rows.push_back(std::move(row));
+                }
+                ctx["group_subjects"] = std::move(rows);
+                return templates.render("groupandsubjects.html", ctx);
+            });
+        });
             });
 
 
     // Trinimo maršrutas su student_id egzistavimo patikrinimu
       CROW_ROUTE(app, "/delete_teacherandsubjects").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                int teacher_id, subject_id;
-                try {
-                    teacher_id = std::stoi(body.substr(body.find("teacher_id=") + 11));
-                    subject_id = std::stoi(body.substr(body.find("subject_id=") + 11));
-                }
-                catch (...) {
-                    return crow::response(400, "Blogai pateikti duomenys.");
-                }
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    int teacher_id, subject_id;
+                    if (!form.getInt("teacher_id", teacher_id) || !form.getInt("subject_id", subject_id)) {
+                        return crow::response(400, "Blogai pateikti duomenys.");
+                    }
 
-                // Naudojame funkciją, kad pašalintume dėstytoją iš dalyko
-                Administrator admin(1, "Test", "Testas");
-                std::string result = admin.removeTeacherAndSubjectFromDatabase(db, teacher_id, subject_id);
+                    // Naudojame funkciją, kad pašalintume dėstytoją iš dalyko
+                    Administrator admin(1, "Test", "Testas");
+                    std::string result = admin.removeTeacherAndSubjectFromDatabase(db, teacher_id, subject_id);
 
-                if (result == "success") {
-                    return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/teacherandsubjects'></head>"
-                        "<body>Destytojas su ID " + std::to_string(teacher_id) + " buvo pasalintas is destomo dalyko su ID " +
-                        std::to_string(subject_id) + "!</body></html>");
-                }
-                else {
-                    return crow::response(400, result); // Grąžiname klaidos pranešimą
-                }
+                    if (result == "success") {
+                        return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/teacherandsubjects'></head>"
+                            "<body>Destytojas su ID " + std::to_string(teacher_id) + " buvo pasalintas is destomo dalyko su ID " +
+                            std::to_string(subject_id) + "!</body></html>");
+                    }
+                    else {
+                        return crow::response(400, result); // Grąžiname klaidos pranešimą
+                    }
+                });
                     });
             // Pridėti dėstytoją prie dėstomo dalyko (maršrutas)
     CROW_ROUTE(app, "/add_teacherandsubjects").methods("POST"_method)
-        ([&db](const crow::request& req) {
-        std::string body = req.body;
-        int teacher_id, subject_id;
-
-        try {
-            // Parsiname parametrus iš užklausos
-            teacher_id = std::stoi(body.substr(body.find("teacher_id=") + 11));
-            subject_id = std::stoi(body.substr(body.find("subject_id=") + 11));
-        }
-        catch (...) {
-            return crow::response(400, "Blogai pateikti duomenys.");
-        }
-
-        // Naudojame bendrą funkciją, kad išvengtume dubliavimo
-        Administrator admin(1, "Test", "Testas");
-        std::string result = admin.addTeacherAndSubjectToDatabase(db, teacher_id, subject_id);
-
-        if (result == "success") {
-            return crow::response(200, "<html><body>Destytojas su ID " + std::to_string(teacher_id) +
-                " buvo priskirtas destomui dalykui su ID " + std::to_string(subject_id) + "!</body>"
-                "<head><meta http-equiv='refresh' content='2.5; url=/teacherandsubjects'></head></html>");
-        }
-        else {
-            return crow::response(400, result); // Grąžiname klaidos pranešimą
-        }
-            });
-    // pgr. dėstytojų ir dalykų lango maršrutas
-    CROW_ROUTE(app, "/teacherandsubjects")
-        ([&db]() {
-        sql::Connection* con = db.connect();
-        std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-        // Kairėje - visų dėstytojų, dalykų ir dėstytojų su jų dalykais lentelės
-        htmlContent += "<h2></h2>";
-        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-        htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            FormData form(req.body);
+            int teacher_id, subject_id;
+            if (!form.getInt("teacher_id", teacher_id) || !form.getInt("subject_id", subject_id)) {
+                return crow::response(400, "Blogai pateikti duomenys.");
+            }
 
-        // 1. Lentelė - Dėstytojai
-        htmlContent += "<h2>Destytojai</h2>";
-        htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-        htmlContent += "<tr><th>ID</th><th>Vardas</th><th>Pavarde</th></tr>";
+            // Naudojame bendrą funkciją, kad išvengtume dubliavimo
+            Administrator admin(1, "Test", "Testas");
+            std::string result = admin.addTeacherAndSubjectToDatabase(db, teacher_id, subject_id);
 
-        // Naudojame anksčiau aprašytą funkciją getAllTeachers
-        Administrator admin(1, "Test", "Testas");
-        std::vector<std::tuple<int, std::string, std::string>> teachers = admin.getAllTeachers(con);
-        for (const auto& teacher : teachers) {
-            int teacher_id = std::get<0>(teacher);
-            std::string teacher_name = std::get<1>(teacher);
-            std::string teacher_surname = std::get<2>(teacher);
-            htmlContent += "<tr><td>" + std::to_string(teacher_id) + "</td><td>" + teacher_name + "</td><td>" + teacher_surname + "</td></tr>";
-        }
-        htmlContent += "</table>";
-
-        // 2. Lentelė - Dalykų sąrašas
-        htmlContent += "<h2>Destomi dalykai</h2>";
-        htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-        htmlContent += "<tr><th>ID</th><th>Pavadinimas</th></tr>";
-
-        // Naudojame funkciją getSubjectsFromDatabase
-        std::vector<std::tuple<int, std::string>> subjects = admin.getSubjectsFromDatabase(con);
-        for (const auto& subject : subjects) {
-            int subject_id = std::get<0>(subject);
-            std::string subject_name = std::get<1>(subject);
-            htmlContent += "<tr><td>" + std::to_string(subject_id) + "</td><td>" + subject_name + "</td></tr>";
-        }
-        htmlContent += "</table>";
-
-        // 3. Lentelė - Dėstytojai su priskirtais dalykais
-        htmlContent += "<h2>Destytojai su priskirtais destomais dalykais</h2>";
-        htmlContent += "<table border='1' style='width: 100%;'>";
-        htmlContent += "<tr><th>Destytojo ID</th><th>Vardas ir Pavarde</th><th>Destomo dalyko ID</th><th>Destomo dalyko pavadinimas</th></tr>";
-
-        // Naudojame funkciją getTeacherSubjectInfo
-        std::vector<std::tuple<int, std::string, std::string, int, std::string>> teacherSubjectInfo = admin.getTeacherSubjectInfo(con);
-        for (const auto& item : teacherSubjectInfo) {
-            int teacher_id = std::get<0>(item);
-            std::string teacher_name = std::get<1>(item);
-            std::string teacher_surname = std::get<2>(item);
-            int subject_id = std::get<3>(item);
-            std::string subject_name = std::get<4>(item);
-
-            // Jei dalykas nepriskirtas, rodyti "Nėra dalyko"
-            if (subject_id == 0) {
-                htmlContent += "<tr><td>" + std::to_string(teacher_id) + "</td><td>" + teacher_name + " " + teacher_surname + "</td><td colspan='2'>Nera destomo dalyko</td></tr>";
+            if (result == "success") {
+                return crow::response(200, "<html><body>Destytojas su ID " + std::to_string(teacher_id) +
+                    " buvo priskirtas destomui dalykui su ID " + std::to_string(subject_id) + "!</body>"
+                    "<head><meta http-equiv='refresh' content='2.5; url=/teacherandsubjects'></head></html>");
             }
             else {
-                htmlContent += "<tr><td>" + std::to_string(teacher_id) + "</td><td>" + teacher_name + " " + teacher_surname + "</td><td>" + std::to_string(subject_id) + "</td><td>" + subject_name + "</td></tr>";
+                return crow::response(400, result); // Grąžiname klaidos pranešimą
             }
-        }
-        htmlContent += "</table>";
-
-        htmlContent += "</div>";  // Užbaigiamas kairės pusės div'as
-
-        // Dešinėje - forma dėstytojo pridėjimui prie dalyko
-        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-        htmlContent += "<h1>Priskirti destytoja destomui dalykui</h1>";
-
-        // Forma priskyrimo
-        htmlContent += "<form action='/add_teacherandsubjects' method='POST'>";
-        htmlContent += "<label for='teacher_id'>Destytojo ID:</label><br>";
-        htmlContent += "<input type='number' name='teacher_id' required><br><br>";
-        htmlContent += "<label for='subject_id'>Dalyko ID:</label><br>";
-        htmlContent += "<input type='number' name='subject_id' required><br><br>";
-        htmlContent += "<button type='submit'>Priskirti destytoja destomui dalykui</button>";
-        htmlContent += "</form>";
-
-        htmlContent += "<h1>Pasalinti destytoja is destomo dalyko</h1>";
-
-        // Forma pašalinimo
-        htmlContent += "<form action='/delete_teacherandsubjects' method='POST'>";
-        htmlContent += "<label for='teacher_id'>Destytojo ID:</label><br>";
-        htmlContent += "<input type='number' name='teacher_id' required><br><br>";
-        htmlContent += "<label for='subject_id'>Dalyko ID:</label><br>";
-        htmlContent += "<input type='number' name='subject_id' required><br><br>";
-        htmlContent += "<button type='submit'>Pasalinti destytoja is destomo dalyko</button>";
-        htmlContent += "</form>";
+        });
+            });
+    // pgr. dėstytojų ir dalykų lango maršrutas
+    CROW_ROUTE(app, "/teacherandsubjects")
+        ([&db, &db_executor, &ref_cache, &templates, &page_cache](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("ov", db.tablesVersion({ MySQLDatabase::Table::Teachers, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::TeacherSubjects }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, &ref_cache, &templates, &page_cache, &req]() {
+            return page_cache.serve(req, "/teacherandsubjects", { MySQLDatabase::Table::Teachers, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::TeacherSubjects }, [&]() {
+                MySQLDatabase::ConnectionLease con = db.acquire();
+                if (!con) {
+                    return crow::response(503, "Nepavyko prisijungti prie duomenu bazes.");
+                }
+                Administrator admin(1, "Test", "Testas");
 
-        htmlContent += "</div>";  // Užbaigiamas dešinės pusės div'as
-        htmlContent += "</div>";  // Užbaigiamas pagrindinis div'as
+                bool teachers_ok, subjects_ok, rows_ok;
+                crow::mustache::context ctx;
+                ctx["teachers"] = personRows(*ref_cache.teachers(&teachers_ok));
+                ctx["subjects"] = namedRows(*ref_cache.subjects(&subjects_ok));
 
-        // Grąžiname HTML turinį
-        crow::response res;
-        res.set_header("Content-Type", "text/html");
-        res.body = htmlContent;
-        return res;
+                // Dėstytojai su priskirtais dalykais (subject_id == 0 - dalykas nepriskirtas)
+                std::vector<std::tuple<int, std::string, std::string, int, std::string>> teacherSubjectInfo = admin.getTeacherSubjectInfo(con, rows_ok);
+                if (!teachers_ok || !subjects_ok || !rows_ok) {
+                    return crow::response(503, "Nepavyko nuskaityti duomenu, bandykite veliau.");
+                }
+                std::vector<crow::mustache::context> rows;
+                rows.reserve(teacherSubjectInfo.size());
+                for (const auto& item : teacherSubjectInfo) {
+                    crow::mustache::context row;
+                    row["teacher_id"] = std::get<0>(item);
+                    row["name"] = std::get<1>(item);
+                    row["surname"] = std::get<2>(item);
+                    row["assigned"] = std::get<3>(item) != 0;
+                    row["subject_id"] = std::get<3>(item);
+                    row["subject_name"] = std::get<4>(item);
+                    rows.push_back(std::move(row));
+                }
+                ctx["teacher_subjects"] = std::move(rows);
+                return templates.render("teacherandsubjects.html", ctx);
+            });
+        });
             });
     // maršrutas ištrinti grupe ir studentą.
             CROW_ROUTE(app, "/delete_groupandstudents").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                int group_id, student_id;
-                try {
-                    group_id = std::stoi(body.substr(body.find("group_id=") + 9));
-                    student_id = std::stoi(body.substr(body.find("student_id=") + 11));
-                }
-                catch (...) {
-                    return crow::response(400, "Blogai pateikti duomenys.");
-                }
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    int group_id, student_id;
+                    if (!form.getInt("group_id", group_id) || !form.getInt("student_id", student_id)) {
+                        return crow::response(400, "Blogai pateikti duomenys.");
+                    }
 
-                // Kvietimas į duomenų bazės funkciją
-                Administrator admin(1, "Test", "Testas");
-                auto result = admin.removeGroupAndStudentFromDatabase(db, group_id, student_id);
+                    // Kvietimas į duomenų bazės funkciją
+                    Administrator admin(1, "Test", "Testas");
+                    auto result = admin.removeGroupAndStudentFromDatabase(db, group_id, student_id);
 
-                // Generuojamas HTML atsakymas
-                if (result.first == 200) {
-                    return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head>"
-                        "<body>" + result.second + "<br></body></html>");
-                }
-                else {
-                    return crow::response(result.first, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head>"
-                        "<body>" + result.second + "<br></body></html>");
-                }
+                    // Generuojamas HTML atsakymas
+                    if (result.first == 200) {
+                        return crow::response(200, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head>"
+                            "<body>" + result.second + "<br></body></html>");
+                    }
+                    else {
+                        return crow::response(result.first, "<html><head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head>"
+                            "<body>" + result.second + "<br></body></html>");
+                    }
+                });
                     });
             // pridėti grupę su studentu-ais.
             CROW_ROUTE(app, "/add_groupandstudents").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                int group_id, student_id;
-
-                try {
-                    // Parsiname parametrus iš užklausos
-                    group_id = std::stoi(body.substr(body.find("group_id=") + 9));
-                    student_id = std::stoi(body.substr(body.find("student_id=") + 11));
-                }
-                catch (...) {
-                    return crow::response(400, "Blogai pateikti duomenys.");
-                }
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    int group_id, student_id;
+                    if (!form.getInt("group_id", group_id) || !form.getInt("student_id", student_id)) {
+                        return crow::response(400, "Blogai pateikti duomenys.");
+                    }
 
-                // Kviečiame addGroupAndStudentToDatabase funkciją
-                Administrator admin(1, "Test", "Testas");
-                std::string result = admin.addGroupAndStudentToDatabase(db, group_id, student_id);
+                    // Kviečiame addGroupAndStudentToDatabase funkciją
+                    Administrator admin(1, "Test", "Testas");
+                    std::string result = admin.addGroupAndStudentToDatabase(db, group_id, student_id);
 
-                // Grąžiname atsakymą priklausomai nuo rezultato
-                if (result.find("Klaida") != std::string::npos) {
-                    return crow::response(400, "<html><body>" + result + "<br></body>"
-                        "<head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head></html>");
-                }
-                else {
-                    return crow::response(200, "<html><body>" + result + "<br></body>"
-                        "<head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head></html>");
-                }
-                    });
-            // pgr. grupių ir studentų langas (maršrutas)
-            CROW_ROUTE(app, "/groupandstudents")
-                ([&db]() {
-                sql::Connection* con = db.connect();
-                std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-                // Kairėje - visų dėstytojų, dalykų ir dėstytojų su jų dalykais lentelės
-                htmlContent += "<h2></h2>";
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-
-                // 1. Lentelė - Grupės
-                htmlContent += "<h2>Grupes</h2>";
-                htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-                htmlContent += "<tr><th>ID</th><th>Grupes pavadinimas</th></tr>";
-
-                // Paimame grupių informaciją
-                Administrator admin(1, "Test", "Testas"); // Sukuriame administratorių, čia tik pavyzdys
-                std::vector<std::tuple<int, std::string>> groups = admin.getAllGroupsFromDatabase(con);
-                for (const auto& group : groups) {
-                    int group_id = std::get<0>(group);
-                    std::string group_name = std::get<1>(group);
-                    htmlContent += "<tr><td>" + std::to_string(group_id) + "</td><td>" + group_name + "</td></tr>";
-                }
-                htmlContent += "</table>";
-
-                // 2. Lentelė - Studentai
-                htmlContent += "<h2>Studentai</h2>";
-                htmlContent += "<table border='1' style='width: 100%; margin-bottom: 20px;'>";
-                htmlContent += "<tr><th>ID</th><th>Vardas</th><th>Pavarde</th></tr>";
-
-                // Paimame studentų informaciją
-                
-                std::vector<std::tuple<int, std::string, std::string>> students = admin.getAllStudents(con);
-                for (const auto& student : students) {
-                    int student_id = std::get<0>(student);
-                    std::string student_name = std::get<1>(student);
-                    std::string student_surname = std::get<2>(student);
-                    htmlContent += "<tr><td>" + std::to_string(student_id) + "</td><td>" + student_name + "</td><td>" + student_surname + "</td></tr>";
-                }
-                htmlContent += "</table>";
-
-                // 3. Lentelė - Studentai su paskirtomis grupėmis
-                htmlContent += "<h2>Studentai su paskirta grupe</h2>";
-                htmlContent += "<table border='1' style='width: 100%;'>";
-                htmlContent += "<tr><th>Studento ID</th><th>Vardas ir Pavarde</th><th>Grupes ID</th><th>Grupes pavadinimas</th></tr>";
-
-                // Paimame studentų ir grupių informaciją
-                
-                std::vector<std::tuple<int, std::string, std::string, int, std::string>> studentGroupInfo = admin.getStudentGroupInfoFromDatabase(con);
-                for (const auto& entry : studentGroupInfo) {
-                    int student_id = std::get<0>(entry);
-                    std::string student_name = std::get<1>(entry);
-                    std::string student_surname = std::get<2>(entry);
-                    int group_id = std::get<3>(entry);
-                    std::string group_name = std::get<4>(entry);
-
-                    // Jei grupė nepriskirta, rodyti "Nėra grupės"
-                    if (group_id == 0) {
-                        htmlContent += "<tr><td>" + std::to_string(student_id) + "</td><td>" + student_name + " " + student_surname + "</td><td colspan='2'>Nera grupės</td></tr>";
+                    // Grąžiname atsakymą priklausomai nuo rezultato
+                    if (result.find("Klaida") != std::string::npos) {
+                        return crow::response(400, "<html><body>" + result + "<br></body>"
+                            "<head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head></html>");
                     }
                     else {
-                        htmlContent += "<tr><td>" + std::to_string(student_id) + "</td><td>" + student_name + " " + student_surname + "</td><td>" + std::to_string(group_id) + "</td><td>" + group_name + "</td></tr>";
+                        return crow::response(200, "<html><body>" + result + "<br></body>"
+                            "<head><meta http-equiv='refresh' content='2.5; url=/groupandstudents'></head></html>");
                     }
-                }
-                htmlContent += "</table>";
-
-                htmlContent += "</div>";  // Užbaigiamas kairės pusės div'as
-
-                // Dešinėje - forma dėstytojo pridėjimui prie dalyko
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<h1>Priskirti studenta grupei</h1>";
-
-                // Forma priskyrimo
-                htmlContent += "<form action='/add_groupandstudents' method='POST'>";
-                htmlContent += "<label for='student_id'>Studento ID:</label><br>";
-                htmlContent += "<input type='number' name='student_id' required><br><br>";
-                htmlContent += "<label for='group_id'>Grupes ID:</label><br>";
-                htmlContent += "<input type='number' name='group_id' required><br><br>";
-                htmlContent += "<button type='submit'>Priskirti studenta grupei</button>";
-                htmlContent += "</form>";
-
-                htmlContent += "<h1>Pasalinti studenta is grupes</h1>";
-
-                // Forma pašalinimo
-                htmlContent += "<form action='/delete_groupandstudents' method='POST'>";
-                htmlContent += "<label for='student_id'>Studento ID:</label><br>";
-                htmlContent += "<input type='number' name='student_id' required><br><br>";
-                htmlContent += "<label for='group_id'>Grupes ID:</label><br>";
-                htmlContent += "<input type='number' name='group_id' required><br><br>";
-                htmlContent += "<button type='submit'>Pasalinti studenta is grupes</button>";
-                htmlContent += "</form>";
-
-                htmlContent += "</div>";  // Užbaigiamas dešinės pusės div'as
+                });
+                    });
+            // pgr. grupių ir studentų langas (maršrutas)
+            CROW_ROUTE(app, "/groupandstudents")
+                ([&db, &db_executor, &ref_cache, &templates, &page_cache](const crow::request& req, crow::response& res) {
+                std::string etag = versionETag("ov", db.tablesVersion({ MySQLDatabase::Table::Groups, MySQLDatabase::Table::Students }));
+                db_executor.respondWithETag(req, res, std::move(etag), [&db, &ref_cache, &templates, &page_cache, &req]() {
+                    return page_cache.serve(req, "/groupandstudents", { MySQLDatabase::Table::Groups, MySQLDatabase::Table::Students }, [&]() {
+                        MySQLDatabase::ConnectionLease con = db.acquire();
+                        if (!con) {
+                            return crow::response(503, "Nepavyko prisijungti prie duomenu bazes.");
+                        }
+                        Administrator admin(1, "Test", "Testas"); // Sukuriame administratorių, čia tik pavyzdys
 
-                htmlContent += "</div>";  // Užbaigiamas pagrindinis div'as
+                        bool groups_ok, students_ok, rows_ok;
+                        crow::mustache::context ctx;
+                        ctx["groups"] = namedRows(*ref_cache.groups(&groups_ok));
+                        ctx["students"] = personRows(admin.getAllStudents(con, students_ok));
 
-                // Grąžiname HTML turinį
-                crow::response res;
-                res.set_header("Content-Type", "text/html");
-                res.body = htmlContent;
-                return res;
+                        // Studentai su paskirtomis grupėmis (group_id == 0 - grupė nepriskirta)
+                        std::vector<std::tuple<int, std::string, std::string, int, std::string>> studentGroupInfo = admin.getStudentGroupInfoFromDatabase(con, rows_ok);
+                        if (!groups_ok || !students_ok || !rows_ok) {
+                            return crow::response(503, "Nepavyko nuskaityti duomenu, bandykite veliau.");
+                        }
+                        std::vector<crow::mustache::context> rows;
+                        rows.reserve(studentGroupInfo.size());
+                        for (const auto& entry : studentGroupInfo) {
+                            crow::mustache::context row;
+                            row["student_id"] = std::get<0>(entry);
+                            row["name"] = std::get<1>(entry);
+                            row["surname"] = std::get<2>(entry);
+                            row["assigned"] = std::get<3>(entry) != 0;
+                            row["group_id"] = std::get<3>(entry);
+                            row["group_name"] = std::get<4>(entry);
+                            rows.push_back(std::move(row));
+                        }
+                        ctx["student_groups"] = std::move(rows);
+                        return templates.render("groupandstudents.html", ctx);
+                    });
+                });
                     });
+                    // Masinis dalykų trynimas (ID sąrašas vienoje transakcijoje)
+                    CROW_ROUTE(app, "/delete_subjects").methods("POST"_method)
+                        ([&db_executor, &bulkDelete](const crow::request& req, crow::response& res) {
+                        db_executor.respond(req, res, [&req, &bulkDelete]() {
+                            return bulkDelete(req, "/subjects", &Administrator::deleteSubjectsFromDatabase);
+                        });
+                            });
                     // Maršrutas dėstomo dalyko ištrinimui.
                     CROW_ROUTE(app, "/delete_subject").methods("POST"_method)
-                        ([&db](const crow::request& req) {
-                        std::string body = req.body;
-                        std::string subject_id_str;
-                        std::size_t pos = body.find("subject_id=");
-
-                        if (pos != std::string::npos) {
-                            subject_id_str = body.substr(pos + 11);
-                        }
-
-                        int subject_id = std::stoi(subject_id_str);
+                        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                        db_executor.respond(req, res, [&db, &req]() {
+                            FormData form(req.body);
+                            int subject_id;
+                            if (!form.getInt("subject_id", subject_id)) {
+                                return crow::response(400, "Blogai pateikti duomenys.");
+                            }
 
-                        // Naudojame Administrator klasę ir jos metodą, kad pašalintume dalyką
-                        Administrator admin(1, "Test", "Testas");  // Pvz., administratoriaus ID ir vardas/pavardė
-                        std::string message = admin.deleteSubjectFromDatabase(db, subject_id);
+                            // Naudojame Administrator klasę ir jos metodą, kad pašalintume dalyką
+                            Administrator admin(1, "Test", "Testas");  // Pvz., administratoriaus ID ir vardas/pavardė
+                            std::string message = admin.deleteSubjectFromDatabase(db, subject_id);
 
-                        crow::response res;
-                        res.code = 200;
-                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
-                            + message +
-                            "<br></body></html>";
+                            crow::response res;
+                            res.code = 200;
+                            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
+                                + message +
+                                "<br></body></html>";
 
-                        return res;
+                            return res;
+                        });
                             });
 
 
     // Pridėjimo maršrutas su vardu ir pavarde egzistavimo patikrinimu
                     CROW_ROUTE(app, "/add_subject").methods("POST"_method)
-                        ([&db](const crow::request& req) {
-                        std::string body = req.body;
-                        std::map<std::string, std::string> form_data;
-                        std::istringstream body_stream(body);
-                        std::string key_value_pair;
-
-                        // Išskiriame duomenis iš POST užklausos
-                        while (std::getline(body_stream, key_value_pair, '&')) {
-                            size_t delimiter_pos = key_value_pair.find('=');
-                            if (delimiter_pos != std::string::npos) {
-                                std::string key = key_value_pair.substr(0, delimiter_pos);
-                                std::string value = key_value_pair.substr(delimiter_pos + 1);
-                                form_data[key] = value;
+                        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                        db_executor.respond(req, res, [&db, &req]() {
+                            FormData form(req.body);
+                            std::optional<std::string_view> subject_name_value = form.get("subject_name");
+
+                            crow::response res;
+                            if (subject_name_value) {
+                                std::string subject_name(subject_name_value->begin(), subject_name_value->end());
+
+                                // Naudojame addSubjectToDatabase funkciją, kad patikrintume ir įrašytume dalyką
+                                Administrator admin(1, "Test", "Testas");  // Pvz., administratoriaus ID ir vardas/pavardė
+                                std::string message = admin.addSubjectToDatabase(db, subject_name);
+
+                                // Atsakymas su pranešimu
+                                res.code = 200;
+                                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
+                                    + message +
+                                    "<br></body></html>";
                             }
-                        }
-
-                        auto subject_name_it = form_data.find("subject_name");
-
-                        crow::response res;
-                        if (subject_name_it != form_data.end()) {
-                            std::string subject_name = subject_name_it->second;
-
-                            // Naudojame addSubjectToDatabase funkciją, kad patikrintume ir įrašytume dalyką
-                            Administrator admin(1, "Test", "Testas");  // Pvz., administratoriaus ID ir vardas/pavardė
-                            std::string message = admin.addSubjectToDatabase(db, subject_name);
-
-                            // Atsakymas su pranešimu
-                            res.code = 200;
-                            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
-                                + message +
-                                "<br></body></html>";
-                        }
-                        else {
-                            res.code = 400; // Netinkama užklausa, nes trūksta dalyko pavadinimo
-                            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
-                                "Destomo dalyko pavadinimas negali buti tuscias! "
-                                "<br></body></html>";
-                        }
-                        return res;
+                            else {
+                                res.code = 400; // Netinkama užklausa, nes trūksta dalyko pavadinimo
+                                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/subjects'></head><body>"
+                                    "Destomo dalyko pavadinimas negali buti tuscias! "
+                                    "<br></body></html>";
+                            }
+                            return res;
+                        });
                             });
                     // Pačių dėstomų dalykų langas (maršrutas)
                     CROW_ROUTE(app, "/subjects")
-                        ([&db]() {
-                        sql::Connection* con = db.connect();
-                        std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-                        // Studentų sąrašo dalis (kairėje)
-                        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                        htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-                        htmlContent += "<h1>Destomu Dalyku sarasas</h1>";
-
-                        // Naudojame Administratorius klasę, kad gautume dalykų sąrašą
-                        Administrator admin(1, "Test", "Testas");
-                        std::vector<std::tuple<int, std::string>> subjects = admin.getSubjectsFromDatabase(con);
-
-                        // Dinamiškai generuojame HTML turinį pagal gautus dalykus
-                        for (const auto& subject : subjects) {
-                            int subject_id = std::get<0>(subject);  // Gauname dalyko ID
-                            const std::string& subject_name = std::get<1>(subject);  // Gauname dalyko pavadinimą
-
-                            htmlContent += "<div class='subject' style='margin-bottom: 20px; padding: 10px; font-size: 0.9em; border-bottom: 1px solid #ddd;'>";
-                            htmlContent += "<p><strong>Destomo dalyko ID:</strong> " + std::to_string(subject_id) + "</p>";
-                            htmlContent += "<p><strong>Destomo dalyko pavadinimas:</strong> " + subject_name + "</p>";
-                            htmlContent += "</div>";
-                        }
+                        ([&db, &db_executor, &ref_cache, &templates](const crow::request& req, crow::response& res) {
+                        std::string etag = versionETag("lsu", db.tableVersion(MySQLDatabase::Table::Subjects));
+                        db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req, &templates]() {
+                            PageRequest page;
+                            if (!parsePageRequest(req, page)) {
+                                return crow::response(400, "Blogi puslapiavimo parametrai.");
+                            }
 
-                        htmlContent += "</div>";  // Uždaryti pirmą div'ą
-
-                        // Formos dalis (dešinėje)
-                        htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                        htmlContent += "<h1>Valdymo panele</h1>";
-
-                        // Pašalinti dalyką formą
-                        htmlContent += "<h2>Pasalinti destoma dalyka pagal ID</h2>";
-                        htmlContent += "<form action='/delete_subject' method='POST'>";
-                        htmlContent += "<label for='subject_id'>Dalyko ID:</label>";
-                        htmlContent += "<input type='number' id='subject_id' name='subject_id' required>";
-                        htmlContent += "<button type='submit'>Pasalinti</button>";
-                        htmlContent += "</form>";
-
-                        // Pridėti dalyką formą
-                        htmlContent += "<h2>Prideti nauja destoma dalyka</h2>";
-                        htmlContent += "<form action='/add_subject' method='POST'>";
-                        htmlContent += "<label for='subject_name'>Dalyko Pavadinimas:</label>";
-                        htmlContent += "<input type='text' id='subject_name' name='subject_name' required><br>";
-                        htmlContent += "<button type='submit'>Prideti</button>";
-                        htmlContent += "</form>";
-
-                        htmlContent += "</div></div>";  // Uždaryti antrą div'ą
-
-                        // Grąžiname HTML turinį
-                        crow::response res;
-                        res.set_header("Content-Type", "text/html");
-                        res.body = htmlContent;
-                        return res;
+                            // Dalykų sąrašas iš talpyklos (DB užklausa tik pasikeitus dalykams), puslapiuojamas atmintyje
+                            std::shared_ptr<const ReferenceCache::Subjects> all_subjects = ref_cache.subjects();
+                            bool has_more = false;
+                            ReferenceCache::Subjects subjects = pageOf(*all_subjects, page,
+                                [&page](const std::tuple<int, std::string>& row) { return startsWithIgnoreCase(std::get<1>(row), page.prefix); },
+                                has_more);
+
+                            crow::mustache::context ctx;
+                            ctx["search_form"] = pageSearchForm("/subjects", page);
+                            ctx["subjects"] = namedRows(subjects);
+                            ctx["page_links"] = pageLinks("/subjects", page, subjects.empty() ? page.after : std::get<0>(subjects.back()), has_more);
+                            return templates.render("subjects.html", ctx);
+                        });
                             });
+    // Masinis grupių trynimas (ID sąrašas vienoje transakcijoje)
+    CROW_ROUTE(app, "/delete_groups").methods("POST"_method)
+        ([&db_executor, &bulkDelete](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&req, &bulkDelete]() {
+            return bulkDelete(req, "/groups", &Administrator::removeGroupsFromDatabase);
+        });
+            });
                     //Maršrutas skirtas grupių ištrinimui.
     CROW_ROUTE(app, "/delete_group").methods("POST"_method)
-        ([&db](const crow::request& req) {
-        std::string body = req.body;
-        std::string group_id_str;
-        std::size_t pos = body.find("group_id=");
-
-        if (pos != std::string::npos) {
-            group_id_str = body.substr(pos + 9);
-        }
-
-        int group_id = std::stoi(group_id_str);
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            FormData form(req.body);
+            int group_id;
+            if (!form.getInt("group_id", group_id)) {
+                return crow::response(400, "Blogai pateikti duomenys.");
+            }
 
-        // Administrator objekto sukūrimas
-        Administrator admin(1, "Test", "Testas");
+            // Administrator objekto sukūrimas
+            Administrator admin(1, "Test", "Testas");
 
-        // Pašalinti studentą iš duomenų bazės
-        std::string result = admin.removeGroupFromDatabase(db, group_id);
+            // Pašalinti studentą iš duomenų bazės
+            std::string result = admin.removeGroupFromDatabase(db, group_id);
 
-        crow::response res;
-        if (result == "Grupe pasalinta sėkmingai!") {
-            res.code = 200;
-            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
-                "Grupe su ID " + std::to_string(group_id) + " pašalinta sėkmingai. "
-                "<br></body></html>";
-        }
-        else {
-            res.code = 200;
-            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
-                + result +
-                "<br></body></html>";
-        }
+            crow::response res;
+            if (result == "Grupe pasalinta sėkmingai!") {
+                res.code = 200;
+                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
+                    "Grupe su ID " + std::to_string(group_id) + " pašalinta sėkmingai. "
+                    "<br></body></html>";
+            }
+            else {
+                res.code = 200;
+                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
+                    + result +
+                    "<br></body></html>";
+            }
 
-        return res;
+            return res;
 
+        });
             });
 
     // Pridėjimo maršrutas su vardu ir pavarde egzistavimo patikrinimu
             CROW_ROUTE(app, "/add_group").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                std::map<std::string, std::string> form_data;
-                std::istringstream body_stream(body);
-                std::string key_value_pair;
-
-                while (std::getline(body_stream, key_value_pair, '&')) {
-                    size_t delimiter_pos = key_value_pair.find('=');
-                    if (delimiter_pos != std::string::npos) {
-                        std::string key = key_value_pair.substr(0, delimiter_pos);
-                        std::string value = key_value_pair.substr(delimiter_pos + 1);
-                        form_data[key] = value;
-                    }
-                }
-
-                auto group_name_it = form_data.find("group_name");
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    std::optional<std::string_view> group_name_value = form.get("group_name");
 
-                crow::response res;
-                if (group_name_it != form_data.end()) {
-                    std::string group_name = group_name_it->second;
-
-                    // Prisijungiam prie duomenų bazės
-                    sql::Connection* con = db.connect();
-                    Administrator admin(1, "Test", "Testas");
+                    crow::response res;
+                    if (group_name_value) {
+                        std::string group_name(group_name_value->begin(), group_name_value->end());
 
-                    // Naudojame Administratorius metodą, kad gautume atsakymą
-                    std::string response_body = admin.addGroupToDatabase(db, group_name);
+                        Administrator admin(1, "Test", "Testas");
 
-                    // Uždarykite ryšį su duomenų baze
-                    delete con;
+                        // Naudojame Administratorius metodą, kad gautume atsakymą (ryšį jis išsinuomoja pats)
+                        std::string response_body = admin.addGroupToDatabase(db, group_name);
 
-                    res.code = 200;
-                    res.body = response_body;
-                }
-                else {
-                    res.code = 200;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
-                        "Grupes pavadinimas negali buti tuscias! "
-                        "<br></body></html>";
-                }
+                        res.code = 200;
+                        res.body = response_body;
+                    }
+                    else {
+                        res.code = 200;
+                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/groups'></head><body>"
+                            "Grupes pavadinimas negali buti tuscias! "
+                            "<br></body></html>";
+                    }
 
-                return res;
+                    return res;
+                });
                     });
             // grupių langas
             CROW_ROUTE(app, "/groups")
-                ([&db]() {
-                // Prisijungiame prie duomenų bazės
-                sql::Connection* con = db.connect();
-                std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-                // Studentų sąrašo dalis (kairėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-                htmlContent += "<h1>Grupiu sarasas</h1>";
-
-                // Paimame grupių informaciją iš duomenų bazės su funkcija getAllGroupsFromDatabase
-                Administrator admin(1, "Test", "Testas"); // Sukuriame administratorių, čia tik pavyzdys
-                std::vector<std::tuple<int, std::string>> groups = admin.getAllGroupsFromDatabase(con);
-
-                // Patikriname, ar yra grupių ir generuojame HTML
-                if (!groups.empty()) {
-                    for (const auto& group : groups) {
-                        int group_id = std::get<0>(group);  // Grupės ID
-                        std::string group_name = std::get<1>(group);  // Grupės pavadinimas
-
-                        htmlContent += "<div class='group' style='margin-bottom: 20px; padding: 10px; font-size: 0.9em; border-bottom: 1px solid #ddd;'>";
-                        htmlContent += "<p><strong>Grupes ID:</strong> " + std::to_string(group_id) + "</p>";
-                        htmlContent += "<p><strong>Grupes pavadinimas:</strong> " + group_name + "</p>";
-                        htmlContent += "</div>";
+                ([&db, &db_executor, &ref_cache, &templates](const crow::request& req, crow::response& res) {
+                std::string etag = versionETag("lgr", db.tableVersion(MySQLDatabase::Table::Groups));
+                db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req, &templates]() {
+                    PageRequest page;
+                    if (!parsePageRequest(req, page)) {
+                        return crow::response(400, "Blogi puslapiavimo parametrai.");
                     }
-                }
-                else {
-                    htmlContent += "<p>Nera grupiu.</p>";
-                }
-
-                htmlContent += "</div>";  // Užbaigia grupių sąrašo div'ą
-
-                // Formos dalis (dešinėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<h1>Valdymo panele</h1>";
-
-                // Pašalinti grupę formą
-                htmlContent += "<h2>Pasalinti grupe pagal ID</h2>";
-                htmlContent += "<form action='/delete_group' method='POST'>";
-                htmlContent += "<label for='group_id'>Grupes ID:</label>";
-                htmlContent += "<input type='number' id='group_id' name='group_id' required>";
-                htmlContent += "<button type='submit'>Pasalinti</button>";
-                htmlContent += "</form>";
 
-                // Pridėti grupę formą
-                htmlContent += "<h2>Prideti nauja grupe</h2>";
-                htmlContent += "<form action='/add_group' method='POST'>";
-                htmlContent += "<label for='group_name'>Grupes Pavadinimas:</label>";
-                htmlContent += "<input type='text' id='group_name' name='group_name' required><br>";
-                htmlContent += "<button type='submit'>Prideti</button>";
-                htmlContent += "</form>";
-
-                htmlContent += "</div></div>";  // Uždaro pagrindinį div'ą
-
-                // Grąžiname HTML turinį kaip atsakymą
-                crow::response res;
-                res.set_header("Content-Type", "text/html");
-                res.body = htmlContent;
-                return res;
+                    // Paimame grupių sąrašo puslapį iš talpyklos
+                    std::shared_ptr<const ReferenceCache::Groups> all_groups = ref_cache.groups();
+                    bool has_more = false;
+                    ReferenceCache::Groups groups = pageOf(*all_groups, page,
+                        [&page](const std::tuple<int, std::string>& row) { return startsWithIgnoreCase(std::get<1>(row), page.prefix); },
+                        has_more);
+
+                    crow::mustache::context ctx;
+                    ctx["search_form"] = pageSearchForm("/groups", page);
+                    ctx["groups"] = namedRows(groups);
+                    ctx["page_links"] = pageLinks("/groups", page, groups.empty() ? page.after : std::get<0>(groups.back()), has_more);
+                    return templates.render("groups.html", ctx);
+                });
                     });
+    // Masinis studentų trynimas (ID sąrašas vienoje transakcijoje)
+    CROW_ROUTE(app, "/delete_students").methods("POST"_method)
+        ([&db_executor, &bulkDelete](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&req, &bulkDelete]() {
+            return bulkDelete(req, "/students", &Administrator::deleteStudentsFromDatabase);
+        });
+            });
             // Studento ištrinimo maršrutas (langas)
     CROW_ROUTE(app, "/delete_student").methods("POST"_method)
-        ([&db](const crow::request& req) {
-        std::string body = req.body;
-        std::string student_id_str;
-        std::size_t pos = body.find("student_id=");
-
-        if (pos != std::string::npos) {
-            student_id_str = body.substr(pos + 11);
-        }
-
-        int student_id = std::stoi(student_id_str);
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        db_executor.respond(req, res, [&db, &req]() {
+            FormData form(req.body);
+            int student_id;
+            if (!form.getInt("student_id", student_id)) {
+                return crow::response(400, "Blogai pateikti duomenys.");
+            }
 
-        // Administrator objekto sukūrimas
-        Administrator admin(1, "Test", "Testas");
+            // Administrator objekto sukūrimas
+            Administrator admin(1, "Test", "Testas");
 
-        // Pašalinti studentą iš duomenų bazės
-        std::string result = admin.deleteStudentFromDatabase(db, student_id);
+            // Pašalinti studentą iš duomenų bazės
+            std::string result = admin.deleteStudentFromDatabase(db, student_id);
 
-        crow::response res;
-        if (result == "Studentas pasalintas sekmingai!") {
-            res.code = 200;
-            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
-                "Studentas su ID " + std::to_string(student_id) + " pasalintas sekmingai. "
-                "<br></body></html>";
-        }
-        else {
-            res.code = 200;
-            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
-                + result +
-                "<br></body></html>";
-        }
+            crow::response res;
+            if (result == "Studentas pasalintas sekmingai!") {
+                res.code = 200;
+                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
+                    "Studentas su ID " + std::to_string(student_id) + " pasalintas sekmingai. "
+                    "<br></body></html>";
+            }
+            else {
+                res.code = 200;
+                res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
+                    + result +
+                    "<br></body></html>";
+            }
 
-        return res;
+            return res;
 
+        });
             });
 
 
+            // Studentų importas iš CSV failo
+            CROW_ROUTE(app, "/import_students").methods("POST"_method)
+                ([&db_executor, &importCsv](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&req, &importCsv]() {
+                    return importCsv(req, false);
+                });
+                    });
+
             // Pridėjimo maršrutas su vardu ir pavarde egzistavimo patikrinimu
             CROW_ROUTE(app, "/add_student").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                std::map<std::string, std::string> form_data;
-                std::istringstream body_stream(body);
-                std::string key_value_pair;
-
-                while (std::getline(body_stream, key_value_pair, '&')) {
-                    size_t delimiter_pos = key_value_pair.find('=');
-                    if (delimiter_pos != std::string::npos) {
-                        std::string key = key_value_pair.substr(0, delimiter_pos);
-                        std::string value = key_value_pair.substr(delimiter_pos + 1);
-                        form_data[key] = value;
-                    }
-                }
-
-                auto name_it = form_data.find("name");
-                auto surname_it = form_data.find("surname");
-
-                crow::response res;
-                if (name_it != form_data.end() && surname_it != form_data.end()) {
-                    std::string name = name_it->second;
-                    std::string surname = surname_it->second;
-
-                    // Administrator objekto sukūrimas
-                    Administrator admin(1, "Test", "Testas");
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    std::optional<std::string_view> name_value = form.get("name");
+                    std::optional<std::string_view> surname_value = form.get("surname");
+
+                    crow::response res;
+                    if (name_value && surname_value) {
+                        std::string name(name_value->begin(), name_value->end());
+                        std::string surname(surname_value->begin(), surname_value->end());
+
+                        // Administrator objekto sukūrimas
+                        Administrator admin(1, "Test", "Testas");
 
-                    // Pridėti studentą ir gauti atsakymą
-                    std::string result = admin.addStudentToDatabase(db, name, surname);
+                        // Pridėti studentą ir gauti atsakymą
+                        std::string result = admin.addStudentToDatabase(db, name, surname);
 
-                    if (result == "Studentas pridetas sekmingai!") {
-                        // Grąžinti sėkmės pranešimą
-                        res.code = 200;
-                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
-                            "Studentas pridetas sekmingai! "
-                            "<br></body></html>";
+                        if (result == "Studentas pridetas sekmingai!") {
+                            // Grąžinti sėkmės pranešimą
+                            res.code = 200;
+                            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
+                                "Studentas pridetas sekmingai! "
+                                "<br></body></html>";
+                        }
+                        else {
+                            // Grąžinti klaidos pranešimą
+                            res.code = 200;
+                            res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
+                                + result +
+                                "<br></body></html>";
+                        }
                     }
                     else {
-                        // Grąžinti klaidos pranešimą
                         res.code = 200;
                         res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
-                            + result +
+                            "Vardas ir pavarde negali buti tusti! "
                             "<br></body></html>";
                     }
-                }
-                else {
-                    res.code = 200;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/students'></head><body>"
-                        "Vardas ir pavarde negali buti tusti! "
-                        "<br></body></html>";
-                }
-                return res;
+                    return res;
+                });
                     });
             // Studento lango maršrutas.
             CROW_ROUTE(app, "/students")
-                ([&db]() {
-                sql::Connection* con = db.connect();
-                Administrator admin(1, "Test", "Testas"); // Sukuriame administratorių, čia tik pavyzdys
-                std::vector<std::tuple<int, std::string, std::string>> students = admin.getAllStudents(con);
-
-                std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
-
-                // Studentų sąrašo dalis (kairėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-                htmlContent += "<h1>Studentu sarasas</h1>";
-
-                for (const auto& student : students) {
-                    int student_id = std::get<0>(student);
-                    std::string name = std::get<1>(student);
-                    std::string surname = std::get<2>(student);
-
-                    htmlContent += "<div class='student' style='margin-bottom: 20px; padding: 10px; font-size: 0.9em; border-bottom: 1px solid #ddd;'>";
-                    htmlContent += "<p><strong>Student ID:</strong> " + std::to_string(student_id) + "</p>";
-                    htmlContent += "<p><strong>Vardas:</strong> " + name + "</p>";
-                    htmlContent += "<p><strong>Pavarde:</strong> " + surname + "</p>";
-                    htmlContent += "</div>";
-                }
-
-                htmlContent += "</div>";
-
-                // Formos dalis (dešinėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<h1>Valdymo panele</h1>";
-
-                // Pašalinti studentą formą
-                htmlContent += "<h2>Pasalinti studenta pagal ID</h2>";
-                htmlContent += "<form action='/delete_student' method='POST'>";
-                htmlContent += "<label for='student_id'>Student ID:</label>";
-                htmlContent += "<input type='number' id='student_id' name='student_id' required>";
-                htmlContent += "<button type='submit'>Pasalinti</button>";
-                htmlContent += "</form>";
-
-                // Pridėti studentą formą
-                htmlContent += "<h2>Prideti nauja studenta</h2>";
-                htmlContent += "<form action='/add_student' method='POST'>";
-                htmlContent += "<label for='name'>Vardas:</label>";
-                htmlContent += "<input type='text' id='name' name='name' required><br>";
-                htmlContent += "<label for='surname'>Pavarde:</label>";
-                htmlContent += "<input type='text' id='surname' name='surname' required><br>";
-                htmlContent += "<button type='submit'>Prideti</button>";
-                htmlContent += "</form>";
-
-                htmlContent += "</div></div>";  // Uždaryti pagrindinį div'ą
-
-                // Grąžiname HTML turinį
-                crow::response res;
-                res.set_header("Content-Type", "text/html");
-                res.body = htmlContent;
-                return res;
+                ([&db, &db_executor, &templates](const crow::request& req, crow::response& res) {
+                std::string etag = versionETag("lst", db.tableVersion(MySQLDatabase::Table::Students));
+                db_executor.respondWithETag(req, res, std::move(etag), [&db, &req, &templates]() {
+                    PageRequest page;
+                    if (!parsePageRequest(req, page)) {
+                        return crow::response(400, "Blogi puslapiavimo parametrai.");
+                    }
+                    MySQLDatabase::ConnectionLease con = db.acquire();
+                    Administrator admin(1, "Test", "Testas"); // Sukuriame administratorių, čia tik pavyzdys
+                    bool has_more = false;
+                    std::vector<std::tuple<int, std::string, std::string>> students = admin.getStudentsPage(con, page, has_more);
+
+                    // Statinė puslapio dalis jau sukompiliuota šablone, čia pildomos tik eilutės
+                    crow::mustache::context ctx;
+                    ctx["search_form"] = pageSearchForm("/students", page);
+                    ctx["students"] = personRows(students);
+                    ctx["page_links"] = pageLinks("/students", page, students.empty() ? page.after : std::get<0>(students.back()), has_more);
+                    return templates.render("students.html", ctx);
+                });
+                    });
+            // Masinis dėstytojų trynimas (ID sąrašas vienoje transakcijoje)
+            CROW_ROUTE(app, "/delete_teachers").methods("POST"_method)
+                ([&db_executor, &bulkDelete](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&req, &bulkDelete]() {
+                    return bulkDelete(req, "/teachers", &Administrator::removeTeachersFromDatabase);
+                });
                     });
             // Maršrutas dėstytojo ištrinimui.
             CROW_ROUTE(app, "/delete_teacher").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                std::string teacher_id_str;
-                std::size_t pos = body.find("teacher_id=");
-
-                if (pos != std::string::npos) {
-                    teacher_id_str = body.substr(pos + 11);
-                }
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    int teacher_id;
+                    if (!form.getInt("teacher_id", teacher_id)) {
+                        return crow::response(400, "Blogai pateikti duomenys.");
+                    }
 
-                int teacher_id = std::stoi(teacher_id_str);
+                    // Administrator objekto sukūrimas
+                    Administrator admin(1, "Test", "Testas");
 
-                // Administrator objekto sukūrimas
-                Administrator admin(1, "Test", "Testas");
+                    // Pašalinti studentą iš duomenų bazės
+                    std::string result = admin.removeTeacherFromDatabase(db, teacher_id);
 
-                // Pašalinti studentą iš duomenų bazės
-                std::string result = admin.removeTeacherFromDatabase(db, teacher_id);
+                    crow::response res;
+                    if (result == "Destytojas pasalintas sekmingai!") {
+                        res.code = 200;
+                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
+                            "Destytojas su ID " + std::to_string(teacher_id) + " pasalintas sekmingai. "
+                            "<br></body></html>";
+                    }
+                    else {
+                        res.code = 200;
+                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
+                            + result +
+                            "<br></body></html>";
+                    }
+                    return res;
+                });
+                    });
 
-                crow::response res;
-                if (result == "Destytojas pasalintas sekmingai!") {
-                    res.code = 200;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
-                        "Destytojas su ID " + std::to_string(teacher_id) + " pasalintas sekmingai. "
-                        "<br></body></html>";
-                }
-                else {
-                    res.code = 200;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
-                        + result +
-                        "<br></body></html>";
-                }
-                return res;
+            // Dėstytojų importas iš CSV failo
+            CROW_ROUTE(app, "/import_teachers").methods("POST"_method)
+                ([&db_executor, &importCsv](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&req, &importCsv]() {
+                    return importCsv(req, true);
+                });
                     });
 
             // Maršrutas pridėti dėstytoją
             CROW_ROUTE(app, "/add_teacher").methods("POST"_method)
-                ([&db](const crow::request& req) {
-                std::string body = req.body;
-                std::map<std::string, std::string> form_data;
-                std::istringstream body_stream(body);
-                std::string key_value_pair;
-
-                while (std::getline(body_stream, key_value_pair, '&')) {
-                    size_t delimiter_pos = key_value_pair.find('=');
-                    if (delimiter_pos != std::string::npos) {
-                        std::string key = key_value_pair.substr(0, delimiter_pos);
-                        std::string value = key_value_pair.substr(delimiter_pos + 1);
-                        form_data[key] = value;
-                    }
-                }
+                ([&db, &db_executor](const crow::request& req, crow::response& res) {
+                db_executor.respond(req, res, [&db, &req]() {
+                    FormData form(req.body);
+                    std::optional<std::string_view> name_value = form.get("name");
+                    std::optional<std::string_view> surname_value = form.get("surname");
 
-                auto name_it = form_data.find("name");
-                auto surname_it = form_data.find("surname");
+                    crow::response res;
+                    if (name_value && surname_value) {
+                        std::string name(name_value->begin(), name_value->end());
+                        std::string surname(surname_value->begin(), surname_value->end());
 
-                crow::response res;
-                if (name_it != form_data.end() && surname_it != form_data.end()) {
-                    std::string name = name_it->second;
-                    std::string surname = surname_it->second;
-
-                    Administrator admin(1, "Admin", "Test");
-                    std::string result = admin.addTeacherToDatabase(db, name, surname);
+                        Administrator admin(1, "Admin", "Test");
+                        std::string result = admin.addTeacherToDatabase(db, name, surname);
 
-                    res.code = 200;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
-                        + result +
-                        "<br></body></html>";
-                }
-                else {
-                    res.code = 400;
-                    res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
-                        "Vardas ir pavarde negali buti tusti! "
-                        "<br></body></html>";
-                }
+                        res.code = 200;
+                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
+                            + result +
+                            "<br></body></html>";
+                    }
+                    else {
+                        res.code = 400;
+                        res.body = "<html><head><meta http-equiv='refresh' content='2; url=/teachers'></head><body>"
+                            "Vardas ir pavarde negali buti tusti! "
+                            "<br></body></html>";
+                    }
 
-                return res;
+                    return res;
+                });
                     });
             // pgr. dėstytojų langas (maršrutas)
             CROW_ROUTE(app, "/teachers")
-                ([&db]() {
-                sql::Connection* con = db.connect();
-                std::string htmlContent = "<div style='display: flex; flex-direction: row;'>";
+                ([&db, &db_executor, &ref_cache, &templates](const crow::request& req, crow::response& res) {
+                std::string etag = versionETag("lte", db.tableVersion(MySQLDatabase::Table::Teachers));
+                db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req, &templates]() {
+                    PageRequest page;
+                    if (!parsePageRequest(req, page)) {
+                        return crow::response(400, "Blogi puslapiavimo parametrai.");
+                    }
 
-                // Studentų sąrašo dalis (kairėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<button onclick=\"window.location.href='/administratorius';\" style='padding: 10px; font-size: 1.2em;'>Atgal</button>";
-                htmlContent += "<h1>Destytoju sarasas</h1>";
+                    // Dėstytojų sąrašo puslapis iš talpyklos; filtruojama pagal vardo arba pavardės pradžią
+                    std::shared_ptr<const ReferenceCache::Teachers> all_teachers = ref_cache.teachers();
+                    bool has_more = false;
+                    ReferenceCache::Teachers teachers = pageOf(*all_teachers, page,
+                        [&page](const std::tuple<int, std::string, std::string>& row) {
+                            return startsWithIgnoreCase(std::get<1>(row), page.prefix) ||
+                                startsWithIgnoreCase(std::get<2>(row), page.prefix);
+                        },
+                        has_more);
+
+                    crow::mustache::context ctx;
+                    ctx["search_form"] = pageSearchForm("/teachers", page);
+                    ctx["teachers"] = personRows(teachers);
+                    ctx["page_links"] = pageLinks("/teachers", page, teachers.empty() ? page.after : std::get<0>(teachers.back()), has_more);
+                    return templates.render("teachers.html", ctx);
+                });
+                    });
 
-                if (con) {
-                    Administrator admin(1, "Test", "Testas");
-                    auto teachers = admin.getAllTeachers(con);
-
-                    for (const auto& teacher : teachers) {
-                        int teacher_id;
-                        std::string name, surname;
-                        std::tie(teacher_id, name, surname) = teacher;
-
-                        htmlContent += "<div class='teacher' style='margin-bottom: 20px; padding: 10px; font-size: 0.9em; border-bottom: 1px solid #ddd;'>";
-                        htmlContent += "<p><strong>Teacher ID:</strong> " + std::to_string(teacher_id) + "</p>";
-                        htmlContent += "<p><strong>Vardas:</strong> " + name + "</p>";
-                        htmlContent += "<p><strong>Pavarde:</strong> " + surname + "</p>";
-                        htmlContent += "</div>";
+    // ---- JSON API (/api/v1) ----
+    // Tie patys duomenys kaip HTML maršrutuose, tik be žymėjimo. Sąrašai puslapiuojami tais pačiais
+    // ?after=&limit=&prefix= parametrais, o atsakymas rašomas JsonWriter tiesiai į vieną buferį.
+    CROW_ROUTE(app, "/api/v1/students")
+        ([&db, &db_executor](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("ast", db.tableVersion(MySQLDatabase::Table::Students));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, &req]() {
+            PageRequest page;
+            if (!parsePageRequest(req, page)) {
+                return jsonResponse(400, "{\"status\": \"error\", \"message\": \"Invalid paging parameters\"}");
+            }
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            Administrator admin(1, "Test", "Testas");
+            bool has_more = false;
+            std::vector<std::tuple<int, std::string, std::string>> students = admin.getStudentsPage(con, page, has_more);
+
+            std::string body;
+            body.reserve(64 + students.size() * 48);
+            JsonWriter json(body);
+            json.beginObject();
+            json.key("students");
+            writePersonRows(json, students);
+            writePageEnd(json, students.empty() ? page.after : std::get<0>(students.back()), has_more);
+            json.endObject();
+            return jsonResponse(200, std::move(body));
+        });
+            });
+
+    CROW_ROUTE(app, "/api/v1/teachers")
+        ([&db, &db_executor, &ref_cache](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("ate", db.tableVersion(MySQLDatabase::Table::Teachers));
+        db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req]() {
+            PageRequest page;
+            if (!parsePageRequest(req, page)) {
+                return jsonResponse(400, "{\"status\": \"error\", \"message\": \"Invalid paging parameters\"}");
+            }
+            std::shared_ptr<const ReferenceCache::Teachers> all_teachers = ref_cache.teachers();
+            bool has_more = false;
+            ReferenceCache::Teachers teachers = pageOf(*all_teachers, page,
+                [&page](const std::tuple<int, std::string, std::string>& row) {
+                    return startsWithIgnoreCase(std::get<1>(row), page.prefix) ||
+                        startsWithIgnoreCase(std::get<2>(row), page.prefix);
+                },
+                has_more);
+
+            std::string body;
+            body.reserve(64 + teachers.size() * 48);
+            JsonWriter json(body);
+            json.beginObject();
+            json.key("teachers");
+            writePersonRows(json, teachers);
+            writePageEnd(json, teachers.empty() ? page.after : std::get<0>(teachers.back()), has_more);
+            json.endObject();
+            return jsonResponse(200, std::move(body));
+        });
+            });
+
+    CROW_ROUTE(app, "/api/v1/subjects")
+        ([&db, &db_executor, &ref_cache](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("asu", db.tableVersion(MySQLDatabase::Table::Subjects));
+        db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req]() {
+            PageRequest page;
+            if (!parsePageRequest(req, page)) {
+                return jsonResponse(400, "{\"status\": \"error\", \"message\": \"Invalid paging parameters\"}");
+            }
+            std::shared_ptr<const ReferenceCache::Subjects> all_subjects = ref_cache.subjects();
+            bool has_more = false;
+            ReferenceCache::Subjects subjects = pageOf(*all_subjects, page,
+                [&page](const std::tuple<int, std::string>& row) { return startsWithIgnoreCase(std::get<1>(row), page.prefix); },
+                has_more);
+
+            std::string body;
+            body.reserve(64 + subjects.size() * 40);
+            JsonWriter json(body);
+            json.beginObject();
+            json.key("subjects");
+            writeNamedRows(json, subjects);
+            writePageEnd(json, subjects.empty() ? page.after : std::get<0>(subjects.back()), has_more);
+            json.endObject();
+            return jsonResponse(200, std::move(body));
+        });
+            });
+
+    CROW_ROUTE(app, "/api/v1/groups")
+        ([&db, &db_executor, &ref_cache](const crow::request& req, crow::response& res) {
+        std::string etag = versionETag("agr", db.tableVersion(MySQLDatabase::Table::Groups));
+        db_executor.respondWithETag(req, res, std::move(etag), [&ref_cache, &req]() {
+            PageRequest page;
+            if (!parsePageRequest(req, page)) {
+                return jsonResponse(400, "{\"status\": \"error\", \"message\": \"Invalid paging parameters\"}");
+            }
+            std::shared_ptr<const ReferenceCache::Groups> all_groups = ref_cache.groups();
+            bool has_more = false;
+            ReferenceCache::Groups groups = pageOf(*all_groups, page,
+                [&page](const std::tuple<int, std::string>& row) { return startsWithIgnoreCase(std::get<1>(row), page.prefix); },
+                has_more);
+
+            std::string body;
+            body.reserve(64 + groups.size() * 40);
+            JsonWriter json(body);
+            json.beginObject();
+            json.key("groups");
+            writeNamedRows(json, groups);
+            writePageEnd(json, groups.empty() ? page.after : std::get<0>(groups.back()), has_more);
+            json.endObject();
+            return jsonResponse(200, std::move(body));
+        });
+            });
+
+    // Dalyko studentų sąrašas su pažymiais (tas pats kaip /subject_students/<id>)
+    CROW_ROUTE(app, "/api/v1/subjects/<int>/students")
+        ([&db, &db_executor](const crow::request& req, crow::response& res, int subject_id) {
+        std::string etag = versionETag("aro", db.tablesVersion({ MySQLDatabase::Table::Subjects, MySQLDatabase::Table::Students,
+            MySQLDatabase::Table::GroupSubjects, MySQLDatabase::Table::Grades }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, subject_id]() {
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                return jsonResponse(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
+            try {
+                std::string subject_name;
+                if (!Teacher::getSubjectInfo(subject_id, con, subject_name)) {
+                    return jsonResponse(404, "{\"status\": \"error\", \"message\": \"Dalykas nerastas.\"}");
+                }
+                std::vector<Teacher::RosterRow> roster = Teacher::getSubjectRoster(subject_id, con);
+
+                std::string body;
+                body.reserve(96 + roster.size() * 64);
+                JsonWriter json(body);
+                json.beginObject();
+                json.key("subject").beginObject();
+                json.key("id").number(subject_id);
+                json.key("name").string(subject_name);
+                json.endObject();
+                json.key("students").beginArray();
+                for (const Teacher::RosterRow& row : roster) {
+                    json.beginObject();
+                    json.key("id").number(row.student_id);
+                    json.key("name").string(row.name);
+                    json.key("surname").string(row.surname);
+                    json.key("grade");
+                    if (row.grade == 0) {
+                        json.null();
                     }
+                    else {
+                        json.number(row.grade);
+                    }
+                    json.endObject();
+                }
+                json.endArray();
+                json.endObject();
+                return jsonResponse(200, std::move(body));
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                return jsonResponse(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
+            }
+        });
+            });
 
-                    delete con; // Išjungiam ryšį su duomenų baze
+    // Studento dalykai ir pažymiai (tas pats kaip /studentas)
+    CROW_ROUTE(app, "/api/v1/students/<int>/grades")
+        ([&db, &db_executor](const crow::request& req, crow::response& res, int student_id) {
+        std::string etag = versionETag("agd", db.studentVersion(student_id) + db.tablesVersion({
+            MySQLDatabase::Table::Students, MySQLDatabase::Table::Subjects, MySQLDatabase::Table::GroupSubjects }));
+        db_executor.respondWithETag(req, res, std::move(etag), [&db, student_id]() {
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                return jsonResponse(500, "{\"status\": \"error\", \"message\": \"Prisijungimo klaida prie duomenu bazes.\"}");
+            }
+            try {
+                std::string name, surname;
+                std::vector<std::pair<std::string, std::string>> subjects;
+                if (!Student::getStudentData(student_id, con, name, surname, subjects)) {
+                    return jsonResponse(404, "{\"status\": \"error\", \"message\": \"Studentas nerastas.\"}");
                 }
-                else {
-                    htmlContent += "<p>Klaida: Nepavyko prisijungti prie duomenu bazes.</p>";
+
+                std::string body;
+                body.reserve(96 + subjects.size() * 48);
+                JsonWriter json(body);
+                json.beginObject();
+                json.key("id").number(student_id);
+                json.key("name").string(name);
+                json.key("surname").string(surname);
+                json.key("grades").beginArray();
+                for (const auto& subject : subjects) {
+                    json.beginObject();
+                    json.key("subject").string(subject.first);
+                    // getStudentData grąžina "Nera", jei pažymio nėra
+                    int grade = 0;
+                    const std::string& text = subject.second;
+                    json.key("grade");
+                    if (std::from_chars(text.data(), text.data() + text.size(), grade).ec == std::errc()) {
+                        json.number(grade);
+                    }
+                    else {
+                        json.null();
+                    }
+                    json.endObject();
                 }
+                json.endArray();
+                json.endObject();
+                return jsonResponse(200, std::move(body));
+            }
+            catch (sql::SQLException& e) {
+                CROW_LOG_ERROR << "SQL klaida: " << e.what();
+                return jsonResponse(500, "{\"status\": \"error\", \"message\": \"Vidine klaida.\"}");
+            }
+        });
+            });
 
-                htmlContent += "</div>";
+    // ---- Pilni eksportai (/api/v1/export) ----
+    // Visa lentelė siunčiama srautu: eilutės iš ResultSet skaitomos po kExportFetchSize ir iškart rašomos
+    // į ChunkWriter, todėl atmintis ir laikas iki pirmo baito nepriklauso nuo lentelės dydžio.
+    static constexpr int32_t kExportFetchSize = 256;
+
+    CROW_ROUTE(app, "/api/v1/export/students")
+        ([&db, &db_executor](crow::response& res) {
+        db_executor.stream(res, "application/json", [&db](ChunkWriter& out) {
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                throw std::runtime_error("Prisijungimo klaida prie duomenu bazes.");
+            }
+            sql::PreparedStatement* pstmt = con.prepare("SELECT student_id, name, surname FROM students ORDER BY student_id");
+            pstmt->setFetchSize(kExportFetchSize);
+            std::unique_ptr<sql::ResultSet> rows(pstmt->executeQuery());
+
+            JsonWriter json(out.buffer());
+            json.beginObject();
+            json.key("students").beginArray();
+            while (rows->next()) {
+                json.beginObject();
+                json.key("id").number(rows->getInt("student_id"));
+                json.key("name").string(rows->getString("name").c_str());
+                json.key("surname").string(rows->getString("surname").c_str());
+                json.endObject();
+                if (!out.flushIfFull()) {
+                    return;
+                }
+            }
+            json.endArray();
+            json.endObject();
+        });
+            });
 
-                // Formos dalis (dešinėje)
-                htmlContent += "<div style='width: 50%; padding: 10px;'>";
-                htmlContent += "<h1>Valdymo panele</h1>";
+    // Dėstytojai su priskirtais dalykais (tas pats kaip administratoriaus dėstytojų lentelė)
+    CROW_ROUTE(app, "/api/v1/export/teacher_subjects")
+        ([&db, &db_executor](crow::response& res) {
+        db_executor.stream(res, "application/json", [&db](ChunkWriter& out) {
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                throw std::runtime_error("Prisijungimo klaida prie duomenu bazes.");
+            }
+            sql::PreparedStatement* pstmt = con.prepare(
+                "SELECT t.teacher_id, t.name, t.surname, s.subject_id, s.subject_name "
+                "FROM teachers t "
+                "LEFT JOIN teacher_subjects ts ON t.teacher_id = ts.teacher_id "
+                "LEFT JOIN subjects s ON ts.subject_id = s.subject_id "
+                "ORDER BY t.teacher_id, s.subject_id");
+            pstmt->setFetchSize(kExportFetchSize);
+            std::unique_ptr<sql::ResultSet> rows(pstmt->executeQuery());
+
+            JsonWriter json(out.buffer());
+            json.beginObject();
+            json.key("teacher_subjects").beginArray();
+            while (rows->next()) {
+                json.beginObject();
+                json.key("teacher_id").number(rows->getInt("teacher_id"));
+                json.key("name").string(rows->getString("name").c_str());
+                json.key("surname").string(rows->getString("surname").c_str());
+                int subject_id = rows->getInt("subject_id");
+                json.key("subject_id");
+                if (subject_id == 0) {
+                    json.null();
+                }
+                else {
+                    json.number(subject_id);
+                }
+                json.key("subject_name");
+                if (subject_id == 0) {
+                    json.null();
+                }
+                else {
+                    json.string(rows->getString("subject_name").c_str());
+                }
+                json.endObject();
+                if (!out.flushIfFull()) {
+                    return;
+                }
+            }
+            json.endArray();
+            json.endObject();
+        });
+            });
 
-                // Pašalinti dėstytoją formą
-                htmlContent += "<h2>Pasalinti destytoja pagal ID</h2>";
-                htmlContent += "<form action='/delete_teacher' method='POST'>";
-                htmlContent += "<label for='teacher_id'>Teacher ID:</label>";
-                htmlContent += "<input type='number' id='teacher_id' name='teacher_id' required>";
-                htmlContent += "<button type='submit'>Pasalinti</button>";
-                htmlContent += "</form>";
+    CROW_ROUTE(app, "/api/v1/export/grades")
+        ([&db, &db_executor](crow::response& res) {
+        db_executor.stream(res, "application/json", [&db](ChunkWriter& out) {
+            MySQLDatabase::ConnectionLease con = db.acquire();
+            if (!con) {
+                throw std::runtime_error("Prisijungimo klaida prie duomenu bazes.");
+            }
+            sql::PreparedStatement* pstmt = con.prepare(
+                "SELECT student_id, subject_id, grade FROM grades ORDER BY student_id, subject_id");
+            pstmt->setFetchSize(kExportFetchSize);
+            std::unique_ptr<sql::ResultSet> rows(pstmt->executeQuery());
+
+            JsonWriter json(out.buffer());
+            json.beginObject();
+            json.key("grades").beginArray();
+            while (rows->next()) {
+                json.beginObject();
+                json.key("student_id").number(rows->getInt("student_id"));
+                json.key("subject_id").number(rows->getInt("subject_id"));
+                json.key("grade").number(rows->getInt("grade"));
+                json.endObject();
+                if (!out.flushIfFull()) {
+                    return;
+                }
+            }
+            json.endArray();
+            json.endObject();
+        });
+            });
 
-                // Pridėti dėstytoją formą
-                htmlContent += "<h2>Prideti nauja destytoja</h2>";
-                htmlContent += "<form action='/add_teacher' method='POST'>";
-                htmlContent += "<label for='name'>Vardas:</label>";
-                htmlContent += "<input type='text' id='name' name='name' required><br>";
-                htmlContent += "<label for='surname'>Pavarde:</label>";
-                htmlContent += "<input type='text' id='surname' name='surname' required><br>";
-                htmlContent += "<button type='submit'>Prideti</button>";
-                htmlContent += "</form>";
+    // ---- Užklausų trace'ai (Chrome trace-event JSON) ----
+    // Išsaugoma 1% užklausų ir visos, trukusios ilgiau nei 250 ms
+    Tracer::configure(0.01, std::chrono::milliseconds(250));
 
-                htmlContent += "</div></div>";  // Uždaryti pagrindinį div'ą
+    CROW_ROUTE(app, "/debug/traces")
+        ([]() {
+        crow::response res(200, Tracer::chromeTraceJson());
+        res.set_header("Content-Type", "application/json");
+        return res;
+            });
 
-                // Grąžiname HTML turinį
-                crow::response res;
-                res.set_header("Content-Type", "text/html");
-                res.body = htmlContent;
-                return res;
-                    });
+    // ---- Metrikos (Prometheus tekstinis formatas) ----
+    // Skaitomos tik atmintyje laikomos histogramos ir skaitikliai, todėl atsakoma iškart IO gijoje
+    CROW_ROUTE(app, "/metrics")
+        ([&app, &db, &db_executor, &log_handler]() {
+        std::string out;
+        out.reserve(32 * 1024);
+        app.get_middleware<MetricsMiddleware>().write(out);
+
+        writePrometheusHeader(out, "db_executor_queue_length", "gauge", "Jobs waiting for a DB worker thread.");
+        out += "db_executor_queue_length " + std::to_string(db_executor.queueLength()) + "\n";
+        writePrometheusHeader(out, "db_executor_queue_wait_seconds", "histogram", "Time a job waited for a DB worker thread.");
+        writePrometheusHistogram(out, "db_executor_queue_wait_seconds", "", db_executor.queueWaitHistogram().snapshot());
+        writePrometheusHeader(out, "db_executor_job_seconds", "histogram", "Time a DB worker spent on one job (queries and rendering).");
+        writePrometheusHistogram(out, "db_executor_job_seconds", "", db_executor.jobTimeHistogram().snapshot());
+        writePrometheusHeader(out, "db_pool_wait_seconds", "histogram", "Time spent acquiring a pooled connection, including connecting.");
+        writePrometheusHistogram(out, "db_pool_wait_seconds", "", db.poolWaitHistogram().snapshot());
+        writePrometheusHeader(out, "db_connection_lease_seconds", "histogram", "Time a connection was held by one job (approximate DB query time).");
+        writePrometheusHistogram(out, "db_connection_lease_seconds", "", db.leaseTimeHistogram().snapshot());
+
+        MySQLDatabase::StatementCacheStats statements = db.statementCacheStats();
+        writePrometheusHeader(out, "db_statement_cache_hits_total", "counter", "Prepared statements reused from the per-connection cache.");
+        out += "db_statement_cache_hits_total " + std::to_string(statements.hits) + "\n";
+        writePrometheusHeader(out, "db_statement_cache_misses_total", "counter", "Prepared statements that had to be prepared.");
+        out += "db_statement_cache_misses_total " + std::to_string(statements.misses) + "\n";
+
+        LoginRateLimiter::Stats login = app.get_middleware<LoginRateLimitMiddleware>().limiter().stats();
+        writePrometheusHeader(out, "login_attempts_allowed_total", "counter", "Login attempts let through to the database.");
+        out += "login_attempts_allowed_total " + std::to_string(login.allowed) + "\n";
+        writePrometheusHeader(out, "login_attempts_limited_total", "counter", "Login attempts rejected with 429 before any DB access.");
+        out += "login_attempts_limited_total{bucket=\"ip\"} " + std::to_string(login.limited_ip) + "\n";
+        out += "login_attempts_limited_total{bucket=\"user\"} " + std::to_string(login.limited_user) + "\n";
+        writePrometheusHeader(out, "login_lockouts_total", "counter", "Usernames locked after repeated failed logins.");
+        out += "login_lockouts_total " + std::to_string(login.lockouts) + "\n";
+        writePrometheusHeader(out, "login_limiter_buckets", "gauge", "Token buckets currently held by the login limiter.");
+        out += "login_limiter_buckets " + std::to_string(login.buckets) + "\n";
+        writePrometheusHeader(out, "login_limiter_evictions_total", "counter", "Buckets evicted because their probe window was full.");
+        out += "login_limiter_evictions_total " + std::to_string(login.evicted) + "\n";
+        writePrometheusHeader(out, "login_limiter_expired_total", "counter", "Idle buckets removed by the timer wheel.");
+        out += "login_limiter_expired_total " + std::to_string(login.expired) + "\n";
+
+        writePrometheusHeader(out, "log_messages_written_total", "counter", "Log messages written by the background log writer.");
+        out += "log_messages_written_total " + std::to_string(log_handler.written()) + "\n";
+        writePrometheusHeader(out, "log_messages_dropped_total", "counter", "Log messages dropped because the log ring was full.");
+        out += "log_messages_dropped_total " + std::to_string(log_handler.dropped()) + "\n";
+
+#ifdef CROW_ENABLE_COMPRESSION
+        crow::CompressionMiddleware::stats compression = app.get_middleware<crow::CompressionMiddleware>().get_stats();
+        writePrometheusHeader(out, "http_compressed_responses_total", "counter", "Responses sent compressed.");
+        out += "http_compressed_responses_total " + std::to_string(compression.compressed) + "\n";
+        writePrometheusHeader(out, "http_compression_bytes_in_total", "counter", "Body bytes before compression.");
+        out += "http_compression_bytes_in_total " + std::to_string(compression.bytes_in) + "\n";
+        writePrometheusHeader(out, "http_compression_bytes_out_total", "counter", "Body bytes after compression.");
+        out += "http_compression_bytes_out_total " + std::to_string(compression.bytes_out) + "\n";
+#endif
+
+        crow::response res(200, std::move(out));
+        res.set_header("Content-Type", "text/plain; version=0.0.4");
+        return res;
+            });
 
     // Paleisti serverį
-    app.port(8080).multithreaded().run();
+    app.port(8080).concurrency(io_threads).run();
+
+    // Eilėje likę darbai naudoja ref_cache, page_cache, templates, pages ir kitus vėliau sukurtus objektus,
+    // kurie sunaikinami anksčiau už db_executor, todėl DB gijos sustabdomos čia, kol visi jie dar gyvi
+    db_executor.shutdown();
     
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+-- Kaskadinis trynimas schemos lygmeniu.
+-- Įdiegus šią migraciją, studento, dėstytojo, dalyko ar grupės trynimas yra vienas DELETE sakinys:
+-- priklausomas eilutes pašalina (arba students.group_id nustato NULL) pati duomenų bazė.
+-- Programa tikrina, ar visi žemiau esantys apribojimai egzistuoja (MySQLDatabase::hasCascadeForeignKeys);
+-- jei ne, priklausomos eilutės trinamos atskirais sakiniais toje pačioje transakcijoje.
+--
+-- Paleisti vieną kartą: mysql -u root sys < sql/001_cascade_deletes.sql
+-- Po migracijos serverį reikia paleisti iš naujo.
+
+START TRANSACTION;
+
+-- Pašaliname jau esančias "našlaites", kitaip išorinių raktų sukurti nepavyks
+DELETE FROM grades WHERE student_id NOT IN (SELECT student_id FROM students)
+    OR subject_id NOT IN (SELECT subject_id FROM subjects);
+DELETE FROM students_subjects WHERE student_id NOT IN (SELECT student_id FROM students)
+    OR subject_id NOT IN (SELECT subject_id FROM subjects);
+DELETE FROM group_students WHERE student_id NOT IN (SELECT student_id FROM students)
+    OR group_id NOT IN (SELECT group_id FROM stud_groups);
+DELETE FROM group_subjects WHERE group_id NOT IN (SELECT group_id FROM stud_groups)
+    OR subject_id NOT IN (SELECT subject_id FROM subjects);
+DELETE FROM teacher_subjects WHERE teacher_id NOT IN (SELECT teacher_id FROM teachers)
+    OR subject_id NOT IN (SELECT subject_id FROM subjects);
+UPDATE students SET group_id = NULL
+    WHERE group_id IS NOT NULL AND group_id NOT IN (SELECT group_id FROM stud_groups);
+
+COMMIT;
+
+ALTER TABLE grades
+    ADD CONSTRAINT fk_grades_student FOREIGN KEY IF NOT EXISTS (student_id)
+        REFERENCES students (student_id) ON DELETE CASCADE,
+    ADD CONSTRAINT fk_grades_subject FOREIGN KEY IF NOT EXISTS (subject_id)
+        REFERENCES subjects (subject_id) ON DELETE CASCADE;
+
+ALTER TABLE students_subjects
+    ADD CONSTRAINT fk_students_subjects_student FOREIGN KEY IF NOT EXISTS (student_id)
+        REFERENCES students (student_id) ON DELETE CASCADE,
+    ADD CONSTRAINT fk_students_subjects_subject FOREIGN KEY IF NOT EXISTS (subject_id)
+        REFERENCES subjects (subject_id) ON DELETE CASCADE;
+
+ALTER TABLE group_students
+    ADD CONSTRAINT fk_group_students_student FOREIGN KEY IF NOT EXISTS (student_id)
+        REFERENCES students (student_id) ON DELETE CASCADE,
+    ADD CONSTRAINT fk_group_students_group FOREIGN KEY IF NOT EXISTS (group_id)
+        REFERENCES stud_groups (group_id) ON DELETE CASCADE;
+
+ALTER TABLE group_subjects
+    ADD CONSTRAINT fk_group_subjects_group FOREIGN KEY IF NOT EXISTS (group_id)
+        REFERENCES stud_groups (group_id) ON DELETE CASCADE,
+    ADD CONSTRAINT fk_group_subjects_subject FOREIGN KEY IF NOT EXISTS (subject_id)
+        REFERENCES subjects (subject_id) ON DELETE CASCADE;
+
+ALTER TABLE teacher_subjects
+    ADD CONSTRAINT fk_teacher_subjects_teacher FOREIGN KEY IF NOT EXISTS (teacher_id)
+        REFERENCES teachers (teacher_id) ON DELETE CASCADE,
+    ADD CONSTRAINT fk_teacher_subjects_subject FOREIGN KEY IF NOT EXISTS (subject_id)
+        REFERENCES subjects (subject_id) ON DELETE CASCADE;
+
+ALTER TABLE students
+    ADD CONSTRAINT fk_students_group FOREIGN KEY IF NOT EXISTS (group_id)
+        REFERENCES stud_groups (group_id) ON DELETE SET NULL;
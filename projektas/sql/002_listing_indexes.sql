@@ -0,0 +1,9 @@
+-- Indeksai sąrašų puslapiavimui (/students?after=&limit=&prefix=).
+-- Puslapiai imami pagal pirminį raktą (student_id > ? ORDER BY student_id LIMIT ?),
+-- o vardo ar pavardės pradžios filtrą (LIKE 'prefix%') aptarnauja šie indeksai.
+-- Dėstytojų, dalykų ir grupių sąrašai puslapiuojami iš atmintyje laikomos talpyklos, todėl jiems indeksų nereikia.
+--
+-- Paleisti vieną kartą: mysql -u root sys < sql/002_listing_indexes.sql
+
+CREATE INDEX IF NOT EXISTS idx_students_name ON students (name);
+CREATE INDEX IF NOT EXISTS idx_students_surname ON students (surname);